@@ -0,0 +1,847 @@
+/*
+ * @Describe:tinyJSON的性能测试程序
+ * 用法：tinyjson_bench [--json] [--scale N] [--iterations N] [--corpus 名字] [文件...]
+ * 默认使用内置生成器生成的语料，给出文件时改为测试这些文件
+ * 对每份语料测试parse/stringify/copy/is_equal/tiny_free等操作，输出吞吐量(MB/s)、每个节点的耗时(ns/node)、
+ * 每次操作的内存分配次数和堆内存峰值，--json时输出机器可读的JSON，便于在不同版本间比较
+ * NDJSON语料改为对比逐行调用parse与单线程、多线程的parse_ndjson
+ * 需要以Release模式编译：cmake -DCMAKE_BUILD_TYPE=Release
+ */
+#include "tinyjson.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__) || defined(__linux__)
+#include <malloc.h>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/* 统计内存分配：glibc下替换malloc/realloc/calloc/free，转发给glibc内部的实现
+ * tinyjson静态链接进本程序，所以库内的分配也会被统计到；parse_ndjson的工作线程也会分配内存，计数器使用原子操作
+ */
+static std::atomic<size_t> alloc_count(0); // 分配次数，realloc也算一次
+static std::atomic<size_t> live_bytes(0);  // 当前的堆内存使用量
+static std::atomic<size_t> peak_bytes(0);  // live_bytes的峰值
+
+#if defined(__GLIBC__)
+#define BENCH_COUNT_ALLOCS
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void __libc_free(void* p);
+
+static void count_alloc(void* p) {
+    if (p) {
+        ++alloc_count;
+        size_t live = live_bytes += malloc_usable_size(p);
+        size_t peak = peak_bytes;
+        while (live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {
+        }
+    }
+}
+
+void* malloc(size_t size) {
+    void* p = __libc_malloc(size);
+    count_alloc(p);
+    return p;
+}
+
+void* calloc(size_t n, size_t size) {
+    void* p = __libc_calloc(n, size);
+    count_alloc(p);
+    return p;
+}
+
+void* realloc(void* p, size_t size) {
+    size_t old = p ? malloc_usable_size(p) : 0;
+    void* q = __libc_realloc(p, size);
+    if (q || size == 0) {
+        live_bytes -= old;
+    }
+    count_alloc(q);
+    return q;
+}
+
+void free(void* p) {
+    if (p) {
+        live_bytes -= malloc_usable_size(p);
+    }
+    __libc_free(p);
+}
+}
+#endif
+
+// 开始统计一次操作
+static void alloc_reset() {
+    alloc_count = 0;
+    peak_bytes = live_bytes.load();
+}
+
+// 进程的常驻内存峰值，单位KB
+static long peak_rss_kb() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static double now_ns() {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/* 语料生成：固定种子的伪随机数，保证每次生成的语料相同，各个版本之间的结果可以比较 */
+static unsigned long long rng_state = 20221230;
+
+static unsigned int rng() {
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned int)(rng_state >> 33);
+}
+
+static unsigned int rng(unsigned int n) { return rng() % n; }
+
+static const char* const WORDS[] = {"json",  "tiny",   "parse",  "value",   "object", "array",  "string",
+                                    "hello", "world",  "number", "unicode", "escape", "stream", "arena",
+                                    "前田",  "東京",   "データ", "café",    "naïve",  "Zürich", "😀"};
+
+static void append_words(std::string* s, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i != 0) {
+            *s += ' ';
+        }
+        switch (rng(16)) {
+        case 0:
+            *s += "\\n";
+            break;
+        case 1:
+            *s += "\\\"";
+            break;
+        case 2:
+            *s += "\\u00e9";
+            break;
+        case 3:
+            *s += "\\/";
+            break;
+        default:
+            break;
+        }
+        *s += WORDS[rng(sizeof(WORDS) / sizeof(WORDS[0]))];
+    }
+}
+
+static void append_uint(std::string* s, unsigned long long n) { *s += std::to_string(n); }
+
+static void append_double(std::string* s, double d) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.17g", d);
+    *s += buffer;
+}
+
+// 类似twitter.json：社交网络的消息，大量短字符串、大整数和null/bool，中文及转义较多
+static std::string gen_twitter(int scale) {
+    std::string s = "{\"statuses\":[";
+    for (int i = 0; i < 500 * scale; i++) {
+        unsigned long long id = 505874924095815681ULL + rng();
+        s += i == 0 ? "{" : ",{";
+        s += "\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"ja\"},";
+        s += "\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":";
+        append_uint(&s, id);
+        s += ",\"id_str\":\"";
+        append_uint(&s, id);
+        s += "\",\"text\":\"";
+        append_words(&s, 8 + rng(16));
+        s += "\",\"source\":\"<a href=\\\"http://twitter.com/download/iphone\\\" rel=\\\"nofollow\\\">Twitter for "
+             "iPhone</a>\",\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_user_id\":";
+        append_uint(&s, rng());
+        s += ",\"user\":{\"id\":";
+        append_uint(&s, rng());
+        s += ",\"name\":\"";
+        append_words(&s, 2);
+        s += "\",\"screen_name\":\"user";
+        append_uint(&s, rng(100000));
+        s += "\",\"location\":\"\",\"description\":\"";
+        append_words(&s, 10 + rng(20));
+        s += "\",\"url\":null,\"protected\":false,\"followers_count\":";
+        append_uint(&s, rng(100000));
+        s += ",\"friends_count\":";
+        append_uint(&s, rng(10000));
+        s += ",\"created_at\":\"Fri Feb 08 09:00:15 +0000 2013\",\"favourites_count\":";
+        append_uint(&s, rng(1000));
+        s += ",\"verified\":false,\"lang\":\"ja\",\"profile_background_color\":\"C0DEED\","
+             "\"profile_image_url\":\"http://pbs.twimg.com/profile_images/497760886795153410/LDjAwR_y_normal.jpeg\","
+             "\"default_profile\":true,\"following\":false,\"notifications\":false},";
+        s += "\"geo\":null,\"coordinates\":null,\"place\":null,\"retweet_count\":";
+        append_uint(&s, rng(100));
+        s += ",\"favorite_count\":";
+        append_uint(&s, rng(100));
+        s += ",\"entities\":{\"hashtags\":[],\"symbols\":[],\"urls\":[],\"user_mentions\":[";
+        for (unsigned int j = 0, n = rng(3); j < n; j++) {
+            s += j == 0 ? "{" : ",{";
+            s += "\"screen_name\":\"aym0566x\",\"name\":\"前田あゆみ\",\"id\":";
+            append_uint(&s, rng());
+            s += ",\"indices\":[0,9]}";
+        }
+        s += "]},\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}";
+    }
+    s += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"query\":\"%E4%B8%80\","
+         "\"count\":100,\"since_id\":0}}";
+    return s;
+}
+
+// 类似canada.json：GeoJSON的多边形，几乎全部是17位有效数字的浮点数
+static std::string gen_canada(int scale) {
+    std::string s = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":"
+                    "\"Canada\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+    for (int i = 0; i < 40 * scale; i++) {
+        s += i == 0 ? "[" : ",[";
+        double x = -140.0 + rng(8000) / 100.0, y = 42.0 + rng(3000) / 100.0;
+        for (int j = 0; j < 1000; j++) {
+            x += (rng(2000) - 1000.0) / 1e5 + rng() / 4294967296.0 / 1e7;
+            y += (rng(2000) - 1000.0) / 1e5 + rng() / 4294967296.0 / 1e7;
+            s += j == 0 ? "[" : ",[";
+            append_double(&s, x);
+            s += ',';
+            append_double(&s, y);
+            s += ']';
+        }
+        s += ']';
+    }
+    s += "]}}]}";
+    return s;
+}
+
+// 类似citm_catalog.json：以数字字符串为键的大object，多层嵌套的小object和整数数组
+static std::string gen_citm(int scale) {
+    std::string s = "{\"areaNames\":{";
+    for (int i = 0; i < 200 * scale; i++) {
+        s += i == 0 ? "\"" : ",\"";
+        append_uint(&s, 205705993 + i);
+        s += "\":\"";
+        append_words(&s, 2);
+        s += "\"";
+    }
+    s += "},\"events\":{";
+    for (int i = 0; i < 2000 * scale; i++) {
+        unsigned int id = 138586341 + i;
+        s += i == 0 ? "\"" : ",\"";
+        append_uint(&s, id);
+        s += "\":{\"description\":null,\"id\":";
+        append_uint(&s, id);
+        s += ",\"logo\":null,\"name\":\"";
+        append_words(&s, 3);
+        s += "\",\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[";
+        append_uint(&s, 324846099 + rng(100));
+        s += ",107888604]}";
+    }
+    s += "},\"performances\":[";
+    for (int i = 0; i < 2500 * scale; i++) {
+        s += i == 0 ? "{" : ",{";
+        s += "\"eventId\":";
+        append_uint(&s, 138586341 + rng(2000 * scale));
+        s += ",\"id\":";
+        append_uint(&s, 339887544 + i);
+        s += ",\"logo\":null,\"name\":null,\"prices\":[";
+        for (unsigned int j = 0, n = 1 + rng(4); j < n; j++) {
+            s += j == 0 ? "{" : ",{";
+            s += "\"amount\":";
+            append_uint(&s, 10000 + rng(90000));
+            s += ",\"audienceSubCategoryId\":337100890,\"seatCategoryId\":";
+            append_uint(&s, 338937295 + j);
+            s += "}";
+        }
+        s += "],\"seatCategories\":[";
+        for (unsigned int j = 0, n = 1 + rng(4); j < n; j++) {
+            s += j == 0 ? "{" : ",{";
+            s += "\"areas\":[{\"areaId\":205705999,\"blockIds\":[]},{\"areaId\":205705998,\"blockIds\":[]}],"
+                 "\"seatCategoryId\":";
+            append_uint(&s, 338937295 + j);
+            s += "}";
+        }
+        s += "],\"seatMapImage\":null,\"start\":";
+        append_uint(&s, 1372701600000ULL + rng() * 1000ULL);
+        s += ",\"venueCode\":\"PLEYEL_PLEYEL\"}";
+    }
+    s += "]}";
+    return s;
+}
+
+// 很长的字符串，大部分是普通字符，偶尔出现转义
+static std::string gen_long_strings(int scale) {
+    std::string s = "[";
+    for (int i = 0; i < 16 * scale; i++) {
+        s += i == 0 ? "\"" : ",\"";
+        int len = 16384 + rng(49152);
+        while (len > 0) {
+            int run = 64 + rng(512);
+            for (int j = 0; j < run; j++) {
+                s += (char)('a' + rng(26));
+            }
+            s += rng(4) == 0 ? "\\u00e9" : rng(2) == 0 ? "\\n" : " 前田 ";
+            len -= run;
+        }
+        s += "\"";
+    }
+    s += "]";
+    return s;
+}
+
+// 深层嵌套的array和object
+static std::string gen_deep(int scale) {
+    const int depth = 200;
+    std::string s = "[";
+    for (int i = 0; i < 500 * scale; i++) {
+        if (i != 0) {
+            s += ',';
+        }
+        for (int j = 0; j < depth; j++) {
+            s += j % 2 == 0 ? "[1," : "{\"k\":";
+        }
+        s += "null";
+        for (int j = depth - 1; j >= 0; j--) {
+            s += j % 2 == 0 ? "]" : "}";
+        }
+    }
+    s += "]";
+    return s;
+}
+
+// 很宽的array和object：几个包含大量元素/成员的扁平容器
+static std::string gen_wide(int scale) {
+    std::string s = "{\"ids\":[";
+    for (int i = 0; i < 100000 * scale; i++) {
+        if (i != 0) {
+            s += ',';
+        }
+        append_uint(&s, rng());
+    }
+    s += "],\"flags\":[";
+    for (int i = 0; i < 50000 * scale; i++) {
+        s += i == 0 ? "" : ",";
+        s += rng(2) ? "true" : "null";
+    }
+    s += "],\"names\":{";
+    for (int i = 0; i < 20000 * scale; i++) {
+        s += i == 0 ? "\"n" : ",\"n";
+        append_uint(&s, i);
+        s += "\":\"";
+        append_words(&s, 1);
+        s += "\"";
+    }
+    s += "}}";
+    return s;
+}
+
+// NDJSON：每行一条小记录，只用于parse_ndjson相关的测试
+static std::string gen_ndjson(int scale) {
+    std::string s;
+    for (int i = 0; i < 20000 * scale; i++) {
+        s += "{\"id\":";
+        append_uint(&s, i);
+        s += ",\"user\":{\"screen_name\":\"";
+        append_words(&s, 1);
+        s += "\",\"followers_count\":";
+        append_uint(&s, rng(100000));
+        s += ",\"profile_image_url_https\":\"https://example.com/";
+        append_uint(&s, rng(100000));
+        s += ".png\"},\"text\":\"";
+        append_words(&s, 4 + rng(12));
+        s += "\",\"score\":";
+        append_double(&s, rng(100000) / 7.0);
+        s += ",\"tags\":[\"";
+        append_words(&s, 1);
+        s += "\",\"";
+        append_words(&s, 1);
+        s += "\"]}\n";
+    }
+    return s;
+}
+
+typedef struct {
+    std::string name;
+    std::string json;
+} corpus;
+
+typedef struct {
+    std::string corpus, op;
+    double mbps, ns_per_node;
+    double allocs;     // 每次操作的分配次数，-1表示无法统计
+    size_t peak_bytes; // 一次操作中堆内存的峰值增量
+} result;
+
+static size_t count_nodes(const tinyjson::value* v) {
+    size_t n = 1;
+    switch (tinyjson::get_type(v)) {
+    case tinyjson::ARRAY:
+        for (size_t i = 0; i < tinyjson::get_array_size(v); i++) {
+            n += count_nodes(tinyjson::get_array_element(v, i));
+        }
+        break;
+    case tinyjson::OBJECT:
+        for (size_t i = 0; i < tinyjson::get_object_size(v); i++) {
+            n += count_nodes(tinyjson::get_object_value(v, i));
+        }
+        break;
+    default:
+        break;
+    }
+    return n;
+}
+
+static int sax_count(void* user) {
+    ++*(size_t*)user;
+    return 0;
+}
+static int sax_count_boolean(void* user, int) { return sax_count(user); }
+static int sax_count_number(void* user, double) { return sax_count(user); }
+static int sax_count_string(void* user, const char*, size_t) { return sax_count(user); }
+static int sax_count_end(void*, size_t) { return 0; }
+
+// 惰性DOM的典型用法：只读取根的前几个元素/成员，字符串和数字取出值
+static size_t lazy_touch(const tinyjson::lazy_doc* d) {
+    const tinyjson::lvalue* root = tinyjson::lazy_root(d);
+    size_t touched = 0;
+    bool is_array = tinyjson::get_type(root) == tinyjson::ARRAY;
+    if (!is_array && tinyjson::get_type(root) != tinyjson::OBJECT) {
+        return 0;
+    }
+    size_t n = is_array ? tinyjson::get_array_size(root) : tinyjson::get_object_size(root);
+    for (size_t i = 0; i < n && i < 4; i++) {
+        const tinyjson::lvalue* e =
+            is_array ? tinyjson::get_array_element(root, i) : tinyjson::get_object_value(root, i);
+        if (tinyjson::get_type(e) == tinyjson::STRING) {
+            touched += tinyjson::get_string(e)[0] != '\0' || tinyjson::get_string_len(e) == 0;
+        } else if (tinyjson::get_type(e) == tinyjson::NUMBER) {
+            touched += tinyjson::get_number(e) != 0;
+        }
+        ++touched;
+    }
+    return touched;
+}
+
+/* 一次操作的计时和统计：每轮只计时op本身，准备和清理工作不计入
+ * 至少运行iterations轮，并且连同准备和清理的总时间不少于0.1秒，取最快的一轮
+ */
+typedef struct {
+    double best_ns;
+    size_t rounds, allocs, peak;
+} measure;
+
+static void measure_begin(measure* m) {
+    m->best_ns = 1e300;
+    m->rounds = m->allocs = m->peak = 0;
+}
+
+static bool measure_more(const measure* m, int iterations, double total_ns) {
+    return m->rounds < (size_t)iterations || total_ns < 1e8;
+}
+
+static void measure_add(measure* m, double ns, size_t base) {
+    if (ns < m->best_ns) {
+        m->best_ns = ns;
+    }
+    ++m->rounds;
+    m->allocs += alloc_count;
+    if (peak_bytes - base > m->peak) {
+        m->peak = peak_bytes - base;
+    }
+}
+
+static result make_result(const corpus* c, const char* op, const measure* m, size_t nodes) {
+    result r;
+    r.corpus = c->name;
+    r.op = op;
+    r.mbps = c->json.size() / (m->best_ns / 1e9) / (1024 * 1024);
+    r.ns_per_node = m->best_ns / nodes;
+#ifdef BENCH_COUNT_ALLOCS
+    r.allocs = (double)m->allocs / m->rounds;
+#else
+    r.allocs = -1;
+#endif
+    r.peak_bytes = m->peak;
+    return r;
+}
+
+#define BENCH_OP(op, setup, body, cleanup)                                                                             \
+    do {                                                                                                               \
+        measure m;                                                                                                     \
+        double total = 0;                                                                                              \
+        measure_begin(&m);                                                                                             \
+        while (measure_more(&m, iterations, total)) {                                                                  \
+            double round_start = now_ns();                                                                             \
+            setup;                                                                                                     \
+            size_t base = live_bytes;                                                                                  \
+            alloc_reset();                                                                                             \
+            double start = now_ns();                                                                                   \
+            body;                                                                                                      \
+            double ns = now_ns() - start;                                                                              \
+            measure_add(&m, ns, base);                                                                                 \
+            cleanup;                                                                                                   \
+            total += now_ns() - round_start;                                                                           \
+        }                                                                                                              \
+        results->push_back(make_result(c, op, &m, nodes));                                                             \
+    } while (0)
+
+static void bench_corpus(const corpus* c, int iterations, std::vector<result>* results) {
+    const char* json = c->json.c_str();
+    size_t len = c->json.size();
+    tinyjson::value doc, v;
+    tinyjson::tiny_init(&doc);
+    if (tinyjson::parse(&doc, json, len) != tinyjson::PARSE_OK) {
+        fprintf(stderr, "%s: parse failed, skipped\n", c->name.c_str());
+        return;
+    }
+    size_t nodes = count_nodes(&doc);
+
+    BENCH_OP("parse", tinyjson::tiny_init(&v), tinyjson::parse(&v, json, len), tinyjson::tiny_free(&v));
+    {
+        tinyjson::parse_options opt;
+        tinyjson::parse_options_init(&opt);
+        opt.flags = tinyjson::PARSE_FLAG_STRING_VIEW;
+        BENCH_OP("parse_view", tinyjson::tiny_init(&v), tinyjson::parse(&v, json, len, &opt), tinyjson::tiny_free(&v));
+
+        /* 元素/成员直接写入最终的内存块，与上面的parse对比 */
+        opt.flags = tinyjson::PARSE_FLAG_IN_PLACE;
+        BENCH_OP("parse_in_place",
+                 tinyjson::tiny_init(&v),
+                 tinyjson::parse(&v, json, len, &opt),
+                 tinyjson::tiny_free(&v));
+        opt.flags = tinyjson::PARSE_FLAG_STRING_VIEW;
+
+        tinyjson::arena a;
+        tinyjson::arena_init(&a, nullptr, 0);
+        opt.pool = &a;
+        BENCH_OP("parse_arena",
+                 tinyjson::tiny_init(&v),
+                 tinyjson::parse(&v, json, len, &opt),
+                 tinyjson::tiny_free(&v);
+                 tinyjson::arena_release(&a));
+
+        /* 解析用的堆栈在多次调用之间复用 */
+        tinyjson::scratch sc;
+        tinyjson::scratch_init(&sc, tinyjson::SCRATCH_RETAIN_UNLIMITED);
+        tinyjson::parse_options_init(&opt);
+        opt.work = &sc;
+        tinyjson::tiny_init(&v);
+        tinyjson::parse(&v, json, len, &opt); // 预热，之后的每一轮都不再为堆栈分配内存
+        tinyjson::tiny_free(&v);
+        BENCH_OP("parse_scratch",
+                 tinyjson::tiny_init(&v),
+                 tinyjson::parse(&v, json, len, &opt),
+                 tinyjson::tiny_free(&v));
+        tinyjson::scratch_free(&sc);
+
+        /* 长键在多次解析之间共享驻留表中的同一份副本 */
+        tinyjson::key_table keys;
+        tinyjson::key_table_init(&keys);
+        tinyjson::parse_options_init(&opt);
+        opt.keys = &keys;
+        BENCH_OP("parse_interned",
+                 tinyjson::tiny_init(&v),
+                 tinyjson::parse(&v, json, len, &opt),
+                 tinyjson::tiny_free(&v));
+        tinyjson::key_table_free(&keys);
+    }
+    /* 建立结构索引后按硬件线程数并行解析，语料小于PARSE_PARALLEL_MIN_SIZE时与parse相同 */
+    BENCH_OP("parse_parallel",
+             tinyjson::tiny_init(&v),
+             tinyjson::parse_parallel(&v, json, len, 0, nullptr),
+             tinyjson::tiny_free(&v));
+    {
+        /* 紧凑DOM，peak_heap可以与parse直接比较 */
+        tinyjson::cvalue cv;
+        BENCH_OP("parse_compact", (void)0, tinyjson::parse(&cv, json, len), tinyjson::tiny_free(&cv));
+        tinyjson::parse(&cv, json, len);
+        char* out = nullptr;
+        BENCH_OP("stringify_compact", (void)0, out = tinyjson::stringify(&cv, nullptr), free(out));
+        tinyjson::tiny_free(&cv);
+    }
+    {
+        /* 惰性DOM：只校验并建立结构索引，索引在多次解析之间复用；touch只访问根的前几个元素/成员 */
+        tinyjson::lazy_doc d;
+        volatile size_t touched;
+        tinyjson::tiny_init(&d);
+        tinyjson::parse(&d, json, len); // 预热，之后的每一轮都不再为索引分配内存
+        BENCH_OP("parse_lazy", (void)0, tinyjson::parse(&d, json, len), (void)0);
+        BENCH_OP("parse_lazy_touch", (void)0, tinyjson::parse(&d, json, len); touched = lazy_touch(&d), (void)touched);
+        tinyjson::tiny_free(&d);
+    }
+    {
+        tinyjson::sax_handler h;
+        size_t count = 0;
+        tinyjson::sax_handler_init(&h);
+        h.null_value = sax_count;
+        h.boolean = sax_count_boolean;
+        h.number = sax_count_number;
+        h.string = sax_count_string;
+        h.start_array = sax_count;
+        h.start_object = sax_count;
+        h.end_array = sax_count_end;
+        h.end_object = sax_count_end;
+        BENCH_OP("sax_parse", count = 0, tinyjson::sax_parse(json, len, &h, &count), (void)count);
+    }
+    {
+        char* out = nullptr;
+        BENCH_OP("stringify", (void)0, out = tinyjson::stringify(&doc, nullptr), free(out));
+
+        tinyjson::scratch sc;
+        const char* volatile result;
+        tinyjson::scratch_init(&sc, tinyjson::SCRATCH_RETAIN_UNLIMITED);
+        tinyjson::stringify(&doc, nullptr, &sc);
+        BENCH_OP("stringify_scratch", (void)0, result = tinyjson::stringify(&doc, nullptr, &sc), (void)result);
+        tinyjson::scratch_free(&sc);
+
+        /* 先计算精确的大小，再写入预先分配好的缓冲区，与发送缓冲区的用法相同 */
+        size_t size = tinyjson::stringify_size(&doc);
+        char* buf = (char*)malloc(size);
+        BENCH_OP("stringify_into",
+                 (void)0,
+                 size = tinyjson::stringify_into(&doc, buf, tinyjson::stringify_size(&doc)),
+                 (void)size);
+        free(buf);
+
+        /* 缩进输出与紧凑输出在同一次遍历中完成，差距只来自多写的空白 */
+        tinyjson::stringify_options opt;
+        tinyjson::stringify_options_init(&opt);
+        opt.indent = 2;
+        BENCH_OP("stringify_pretty", (void)0, out = tinyjson::stringify_format(&doc, nullptr, &opt), free(out));
+        opt.sort_keys = 1;
+        BENCH_OP("stringify_sorted", (void)0, out = tinyjson::stringify_format(&doc, nullptr, &opt), free(out));
+    }
+    BENCH_OP("copy", tinyjson::tiny_init(&v), tinyjson::copy(&v, &doc), tinyjson::tiny_free(&v));
+    tinyjson::tiny_init(&v);
+    tinyjson::copy(&v, &doc);
+    {
+        volatile int equal;
+        BENCH_OP("is_equal", (void)0, equal = tinyjson::is_equal(&doc, &v), (void)equal);
+    }
+    tinyjson::tiny_free(&v);
+    BENCH_OP("tiny_free",
+             tinyjson::tiny_init(&v);
+             tinyjson::parse(&v, json, len),
+             tinyjson::tiny_free(&v),
+             (void)0);
+    tinyjson::tiny_free(&doc);
+}
+
+static int ndjson_count(void* user, size_t, tinyjson::value*, int status) {
+    *(size_t*)user += status == tinyjson::PARSE_OK;
+    return 0;
+}
+
+// NDJSON语料：逐行调用parse作为基准，与单线程和多线程的parse_ndjson对比
+static void bench_ndjson(const corpus* c, int iterations, std::vector<result>* results) {
+    const char* json = c->json.c_str();
+    const char* end = json + c->json.size();
+    tinyjson::value v;
+    size_t nodes = 0, records = 0;
+    for (const char* p = json; p < end;) {
+        const char* q = (const char*)memchr(p, '\n', end - p);
+        q = q ? q : end;
+        if (tinyjson::parse(&v, p, q - p) != tinyjson::PARSE_OK) {
+            fprintf(stderr, "%s: parse failed, skipped\n", c->name.c_str());
+            return;
+        }
+        nodes += count_nodes(&v);
+        tinyjson::tiny_free(&v);
+        p = q + 1;
+    }
+
+    BENCH_OP("parse_lines",
+             (void)0,
+             for (const char* p = json; p < end;) {
+                 const char* q = (const char*)memchr(p, '\n', end - p);
+                 q = q ? q : end;
+                 tinyjson::parse(&v, p, q - p);
+                 tinyjson::tiny_free(&v);
+                 p = q + 1;
+             },
+             (void)0);
+    tinyjson::ndjson_options opt;
+    tinyjson::ndjson_options_init(&opt);
+    opt.threads = 1;
+    BENCH_OP("parse_ndjson_1",
+             records = 0,
+             tinyjson::parse_ndjson(json, end - json, ndjson_count, &records, &opt),
+             (void)records);
+    opt.threads = 0;
+    BENCH_OP("parse_ndjson",
+             records = 0,
+             tinyjson::parse_ndjson(json, end - json, ndjson_count, &records, &opt),
+             (void)records);
+
+    /* 所有线程共享一张驻留表：每条记录都有长键，已有的键不加锁查找，与上面两项对比线程数增加时是否仍然按比例加速 */
+    tinyjson::key_table keys;
+    tinyjson::parse_options popt;
+    tinyjson::key_table_init(&keys);
+    tinyjson::parse_options_init(&popt);
+    popt.keys = &keys;
+    opt.parse = &popt;
+    opt.threads = 1;
+    BENCH_OP("parse_ndjson_keys_1",
+             records = 0,
+             tinyjson::parse_ndjson(json, end - json, ndjson_count, &records, &opt),
+             (void)records);
+    opt.threads = 0;
+    BENCH_OP("parse_ndjson_keys",
+             records = 0,
+             tinyjson::parse_ndjson(json, end - json, ndjson_count, &records, &opt),
+             (void)records);
+    tinyjson::key_table_free(&keys);
+}
+
+static bool read_file(const char* path, std::string* out) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        out->append(buffer, n);
+    }
+    fclose(fp);
+    return true;
+}
+
+static void print_text(const std::vector<corpus>& corpora, const std::vector<result>& results) {
+    printf("%-14s %12s\n", "corpus", "size(KB)");
+    for (const corpus& c : corpora) {
+        printf("%-14s %12.1f\n", c.name.c_str(), c.json.size() / 1024.0);
+    }
+    printf("\n%-14s %-12s %10s %10s %10s %14s\n", "corpus", "op", "MB/s", "ns/node", "allocs", "peak_heap(KB)");
+    for (const result& r : results) {
+        printf("%-14s %-18s %10.1f %10.2f %10.0f %14.1f\n",
+               r.corpus.c_str(),
+               r.op.c_str(),
+               r.mbps,
+               r.ns_per_node,
+               r.allocs,
+               r.peak_bytes / 1024.0);
+    }
+    printf("\npeak_rss(KB): %ld\n", peak_rss_kb());
+}
+
+// 机器可读的输出，用tinyjson自己生成
+static void print_json(const std::vector<corpus>& corpora, const std::vector<result>& results) {
+    tinyjson::value root, *a;
+    tinyjson::tiny_init(&root);
+    tinyjson::set_object(&root, 0);
+    a = tinyjson::set_object_value(&root, (char*)"corpora", 7);
+    tinyjson::set_array(a, corpora.size());
+    for (const corpus& c : corpora) {
+        tinyjson::value* o = tinyjson::array_pushback(a);
+        tinyjson::set_object(o, 2);
+        tinyjson::set_string(tinyjson::set_object_value(o, (char*)"name", 4), c.name.c_str(), c.name.size());
+        tinyjson::set_number(tinyjson::set_object_value(o, (char*)"bytes", 5), (double)c.json.size());
+    }
+    a = tinyjson::set_object_value(&root, (char*)"results", 7);
+    tinyjson::set_array(a, results.size());
+    for (const result& r : results) {
+        tinyjson::value* o = tinyjson::array_pushback(a);
+        tinyjson::set_object(o, 6);
+        tinyjson::set_string(tinyjson::set_object_value(o, (char*)"corpus", 6), r.corpus.c_str(), r.corpus.size());
+        tinyjson::set_string(tinyjson::set_object_value(o, (char*)"op", 2), r.op.c_str(), r.op.size());
+        tinyjson::set_number(tinyjson::set_object_value(o, (char*)"mb_per_s", 8), r.mbps);
+        tinyjson::set_number(tinyjson::set_object_value(o, (char*)"ns_per_node", 11), r.ns_per_node);
+        if (r.allocs >= 0) {
+            tinyjson::set_number(tinyjson::set_object_value(o, (char*)"allocs", 6), r.allocs);
+        } else {
+            tinyjson::set_null(tinyjson::set_object_value(o, (char*)"allocs", 6));
+        }
+        tinyjson::set_number(tinyjson::set_object_value(o, (char*)"peak_heap_bytes", 15), (double)r.peak_bytes);
+    }
+    tinyjson::set_number(tinyjson::set_object_value(&root, (char*)"peak_rss_kb", 11), (double)peak_rss_kb());
+    tinyjson::stringify_file(&root, stdout);
+    printf("\n");
+    tinyjson::tiny_free(&root);
+}
+
+int main(int argc, char* argv[]) {
+    bool json_output = false;
+    int scale = 1, iterations = 5;
+    const char* only = nullptr;
+    std::vector<corpus> corpora;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json_output = true;
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr,
+                    "usage: %s [--json] [--scale N] [--iterations N] [--corpus name] [file...]\n",
+                    argv[0]);
+            return 1;
+        } else {
+            corpus c;
+            const char* name = strrchr(argv[i], '/');
+            c.name = name ? name + 1 : argv[i];
+            if (!read_file(argv[i], &c.json)) {
+                fprintf(stderr, "cannot read %s\n", argv[i]);
+                return 1;
+            }
+            corpora.push_back(c);
+        }
+    }
+#ifndef NDEBUG
+    fprintf(stderr, "warning: assertions are enabled, build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n");
+#endif
+
+    if (corpora.empty()) {
+        static const struct {
+            const char* name;
+            std::string (*gen)(int scale);
+        } generators[] = {{"twitter", gen_twitter},
+                          {"canada", gen_canada},
+                          {"citm", gen_citm},
+                          {"long_strings", gen_long_strings},
+                          {"deep", gen_deep},
+                          {"wide", gen_wide},
+                          {"ndjson", gen_ndjson}};
+        for (const auto& g : generators) {
+            if (only && strcmp(only, g.name) != 0) {
+                continue;
+            }
+            corpus c;
+            c.name = g.name;
+            c.json = g.gen(scale);
+            corpora.push_back(c);
+        }
+    }
+
+    std::vector<result> results;
+    for (const corpus& c : corpora) {
+        if (c.name == "ndjson") {
+            bench_ndjson(&c, iterations, &results);
+        } else {
+            bench_corpus(&c, iterations, &results);
+        }
+    }
+    if (json_output) {
+        print_json(corpora, results);
+    } else {
+        print_text(corpora, results);
+    }
+    return 0;
+}
@@ -13,10 +13,15 @@
 #include "tinyjson.h"
 
 #include <iostream>
+#include <math.h>
 #include <ostream>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 static int main_ret = 0;
 static int test_count = 0;
@@ -53,8 +58,68 @@ static int test_pass = 0;
         EXPECT_EQ_INT(error, tinyjson::parse(&v, json));                                                               \
         EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));                                                     \
         tinyjson::tiny_free(&v);                                                                                       \
+        tinyjson::sax_handler h;                                                                                       \
+        tinyjson::sax_handler_init(&h);                                                                                \
+        EXPECT_EQ_INT(error, tinyjson::sax_parse(json, strlen(json), &h, nullptr));                                    \
+        EXPECT_EQ_INT(error, push_parse(&v, json, strlen(json), 1));                                                   \
+        EXPECT_EQ_INT(error, parse_in_place(&v, json, strlen(json)));                                                  \
+        EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));                                                     \
+        tinyjson::cvalue cv;                                                                                           \
+        EXPECT_EQ_INT(error, tinyjson::parse(&cv, json, strlen(json)));                                                \
+        EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&cv));                                                    \
+        tinyjson::lazy_doc d;                                                                                          \
+        tinyjson::tiny_init(&d);                                                                                       \
+        EXPECT_EQ_INT(error, tinyjson::parse(&d, json, strlen(json)));                                                 \
+        EXPECT_TRUE(tinyjson::lazy_root(&d) == nullptr);                                                               \
+        tinyjson::tiny_free(&d);                                                                                       \
     } while (0)
 
+#define TEST_ERROR_LEN(error, json, len)                                                                               \
+    do {                                                                                                               \
+        tinyjson::value v;                                                                                             \
+        tiny_init(&v);                                                                                                 \
+        tinyjson::set_boolean(&v, 0);                                                                                  \
+        EXPECT_EQ_INT(error, tinyjson::parse(&v, json, len));                                                          \
+        EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));                                                     \
+        tinyjson::tiny_free(&v);                                                                                       \
+        tinyjson::sax_handler h;                                                                                       \
+        tinyjson::sax_handler_init(&h);                                                                                \
+        EXPECT_EQ_INT(error, tinyjson::sax_parse(json, len, &h, nullptr));                                             \
+        EXPECT_EQ_INT(error, push_parse(&v, json, len, 1));                                                            \
+        EXPECT_EQ_INT(error, parse_in_place(&v, json, len));                                                           \
+        EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));                                                     \
+        tinyjson::cvalue cv;                                                                                           \
+        EXPECT_EQ_INT(error, tinyjson::parse(&cv, json, len));                                                         \
+        EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&cv));                                                    \
+        tinyjson::lazy_doc d;                                                                                          \
+        tinyjson::tiny_init(&d);                                                                                       \
+        EXPECT_EQ_INT(error, tinyjson::parse(&d, json, len));                                                          \
+        EXPECT_TRUE(tinyjson::lazy_root(&d) == nullptr);                                                               \
+        tinyjson::tiny_free(&d);                                                                                       \
+    } while (0)
+
+// 把输入按chunk字节一块交给增量解析器
+static int push_parse(tinyjson::value* v, const char* json, size_t len, size_t chunk) {
+    tinyjson::push_parser p;
+    int ret = tinyjson::PARSE_OK;
+    tinyjson::push_parser_init(&p, v);
+    for (size_t i = 0; i < len && ret == tinyjson::PARSE_OK; i += chunk) {
+        ret = tinyjson::push_parser_feed(&p, json + i, len - i < chunk ? len - i : chunk);
+    }
+    if (ret == tinyjson::PARSE_OK) {
+        ret = tinyjson::push_parser_finish(&p);
+    }
+    tinyjson::push_parser_free(&p);
+    return ret;
+}
+
+static int parse_in_place(tinyjson::value* v, const char* json, size_t len) {
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.flags = tinyjson::PARSE_FLAG_IN_PLACE;
+    return tinyjson::parse(v, json, len, &opt);
+}
+
 #define TEST_NUMBER(expect, json)                                                                                      \
     do {                                                                                                               \
         tinyjson::value v;                                                                                             \
@@ -76,6 +141,15 @@ static int test_pass = 0;
         tinyjson::tiny_free(&v);                                                                                       \
     } while (0)
 
+// stringify_size与stringify的输出长度相同，stringify_into写入恰好这么大的缓冲区后与stringify的输出相同
+static void expect_stringify_into(const tinyjson::value* v, const char* expect, size_t length) {
+    EXPECT_EQ_SIZE_T(length, tinyjson::stringify_size(v));
+    char* buf = (char*)malloc(length);
+    EXPECT_EQ_SIZE_T(length, tinyjson::stringify_into(v, buf, length));
+    EXPECT_TRUE(memcmp(buf, expect, length) == 0);
+    free(buf);
+}
+
 #define TEST_ROUNDTRIP(json)                                                                                           \
     do {                                                                                                               \
         tinyjson::value v;                                                                                             \
@@ -85,6 +159,34 @@ static int test_pass = 0;
         EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json));                                                  \
         json2 = tinyjson::stringify(&v, &length);                                                                      \
         EXPECT_EQ_STRING(json, json2, length);                                                                         \
+        expect_stringify_into(&v, json2, length);                                                                      \
+        tinyjson::tiny_free(&v);                                                                                       \
+        free(json2);                                                                                                   \
+        tinyjson::cvalue cv;                                                                                           \
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv, json, strlen(json)));                                   \
+        json2 = tinyjson::stringify(&cv, &length);                                                                     \
+        EXPECT_EQ_STRING(json, json2, length);                                                                         \
+        tinyjson::tiny_free(&cv);                                                                                      \
+        free(json2);                                                                                                   \
+        tinyjson::lazy_doc d;                                                                                          \
+        tinyjson::tiny_init(&d);                                                                                       \
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&d, json, strlen(json)));                                    \
+        json2 = tinyjson::stringify(tinyjson::lazy_root(&d), &length);                                                 \
+        EXPECT_EQ_STRING(json, json2, length);                                                                         \
+        tinyjson::tiny_free(&d);                                                                                       \
+        free(json2);                                                                                                   \
+    } while (0)
+
+#define TEST_STRINGIFY(expect, json)                                                                                   \
+    do {                                                                                                               \
+        tinyjson::value v;                                                                                             \
+        char* json2;                                                                                                   \
+        size_t length;                                                                                                 \
+        tinyjson::tiny_init(&v);                                                                                       \
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json));                                                  \
+        json2 = tinyjson::stringify(&v, &length);                                                                      \
+        EXPECT_EQ_STRING(expect, json2, length);                                                                       \
+        expect_stringify_into(&v, json2, length);                                                                      \
         tinyjson::tiny_free(&v);                                                                                       \
         free(json2);                                                                                                   \
     } while (0)
@@ -148,6 +250,7 @@ static void test_parse_number() {
     TEST_NUMBER(1.234E+10, "1.234E+10");
     TEST_NUMBER(1.234E-10, "1.234E-10");
     TEST_NUMBER(0.0, "1e-10000"); /* must underflow */
+    TEST_NUMBER(1.5, "1.50000000000000000000000000000000000000000000000000000000000000000000000000000000");
 
     TEST_NUMBER(1.0000000000000002, "1.0000000000000002");           /* the smallest number > 1 */
     TEST_NUMBER(4.9406564584124654e-324, "4.9406564584124654e-324"); /* minimum denormal */
@@ -158,6 +261,61 @@ static void test_parse_number() {
     TEST_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
     TEST_NUMBER(1.7976931348623157e+308, "1.7976931348623157e+308"); /* Max double */
     TEST_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+
+    TEST_NUMBER(0.1, "0.1");
+    TEST_NUMBER(0.0, "0.000");
+    TEST_NUMBER(-0.0, "-0e-999999999999");
+    TEST_NUMBER(9007199254740992.0, "9007199254740993"); /* halfway, round to even */
+    TEST_NUMBER(9007199254740994.0, "9007199254740993.0000000000000000000000001");
+    TEST_NUMBER(9007199254740996.0, "9007199254740995");
+    TEST_NUMBER(1e23, "1e23");
+    TEST_NUMBER(8.589973e9, "8589973000");
+    TEST_NUMBER(1.7976931348623157e+308, "179769313486231570000000000000000000000000000000000000000000000000000000000000"
+                                         "00000000000000000000000000000000000000000000000000000000000000000000000000000"
+                                         "00000000000000000000000000000000000000000000000000000000000000000000000000000"
+                                         "00000000000000000000000000000000000000000000000000000000000000000000000000000");
+    TEST_NUMBER(2.2250738585072011e-308, "2.2250738585072011e-308");
+    TEST_NUMBER(4.9406564584124654e-324, "2.4703282292062328e-324"); /* just above half of minimum denormal */
+    TEST_NUMBER(0.0, "2.4703282292062327e-324");                      /* just below half, underflow */
+    TEST_NUMBER(1.7976931348623157e+308, "1.7976931348623158e+308");
+    TEST_NUMBER(0.1, "0.1000000000000000055511151231257827021181583404541015625");
+    TEST_NUMBER(0.1, "0.10000000000000000555111512312578270211815834045410156250000000000000000000001");
+}
+
+// 把随机生成的数字字符串的解析结果与strtod对比，覆盖快速路径、Eisel-Lemire和高精度慢速路径
+static void test_parse_number_random() {
+    char json[128];
+    unsigned int seed = 20221230;
+    for (int i = 0; i < 20000; ++i) {
+        size_t len = 0;
+        seed = seed * 1103515245 + 12345;
+        int int_digits = 1 + (seed >> 16) % 25;
+        seed = seed * 1103515245 + 12345;
+        int frac_digits = (seed >> 16) % 25;
+        seed = seed * 1103515245 + 12345;
+        int exp = (int)((seed >> 16) % 700) - 350;
+        if (i & 1) {
+            json[len++] = '-';
+        }
+        for (int j = 0; j < int_digits; ++j) {
+            seed = seed * 1103515245 + 12345;
+            json[len++] = (char)('0' + (j == 0 && int_digits > 1 ? 1 + (seed >> 16) % 9 : (seed >> 16) % 10));
+        }
+        if (frac_digits > 0) {
+            json[len++] = '.';
+            for (int j = 0; j < frac_digits; ++j) {
+                seed = seed * 1103515245 + 12345;
+                json[len++] = (char)('0' + (seed >> 16) % 10);
+            }
+        }
+        len += sprintf(json + len, "e%d", exp);
+        double expect = strtod(json, NULL);
+        if (expect == HUGE_VAL || expect == -HUGE_VAL) {
+            TEST_ERROR(tinyjson::PARSE_NUMBER_TOO_BIG, json);
+        } else {
+            TEST_NUMBER(expect, json);
+        }
+    }
 }
 
 static void test_parse_string() {
@@ -313,6 +471,8 @@ static void test_parse_root_not_singular() {
 static void test_parse_number_too_big() {
     TEST_ERROR(tinyjson::PARSE_NUMBER_TOO_BIG, "1e309");
     TEST_ERROR(tinyjson::PARSE_NUMBER_TOO_BIG, "-1e309");
+    TEST_ERROR(tinyjson::PARSE_NUMBER_TOO_BIG, "1.7976931348623159e+308");
+    TEST_ERROR(tinyjson::PARSE_NUMBER_TOO_BIG, "1e99999999999999999999");
 }
 
 static void test_parse_missing_quotation_mark() {
@@ -426,6 +586,62 @@ static void test_access_string() {
     tinyjson::tiny_free(&v);
 }
 
+// 短字符串和短键直接存放在value/member内，长度边界两侧的内容都正确
+static void test_access_string_inline() {
+    tinyjson::value v, o, e;
+    const char text[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    tiny_init(&v);
+    tiny_init(&o);
+    tiny_init(&e);
+    for (size_t len = tinyjson::VALUE_INLINE_STRING - 1; len <= tinyjson::VALUE_INLINE_STRING + 1; len++) {
+        tinyjson::set_string(&v, text, len);
+        const char* s = tinyjson::get_string(&v);
+        EXPECT_EQ_SIZE_T(len, tinyjson::get_string_len(&v));
+        EXPECT_TRUE(memcmp(s, text, len) == 0 && s[len] == '\0');
+        bool in_value = s >= (const char*)&v && s < (const char*)(&v + 1);
+        EXPECT_TRUE(in_value == (len <= tinyjson::VALUE_INLINE_STRING));
+        /* 拷贝、移动和交换后内容不变 */
+        tinyjson::copy(&e, &v);
+        EXPECT_TRUE(tinyjson::is_equal(&e, &v));
+        tinyjson::set_null(&v);
+        tinyjson::swap(&e, &v);
+        tinyjson::move(&e, &v);
+        EXPECT_TRUE(tinyjson::get_string_len(&e) == len && memcmp(tinyjson::get_string(&e), text, len) == 0);
+    }
+
+    tinyjson::set_object(&o, 0);
+    for (size_t len = 0; len <= tinyjson::MEMBER_INLINE_KEY + 1; len++) {
+        tinyjson::set_number(tinyjson::set_object_value(&o, (char*)text, len), (double)len);
+    }
+    for (size_t len = 0; len <= tinyjson::MEMBER_INLINE_KEY + 1; len++) {
+        size_t i = tinyjson::find_object_index(&o, text, len);
+        EXPECT_EQ_SIZE_T(len, i);
+        const char* k = tinyjson::get_object_key(&o, i);
+        EXPECT_EQ_SIZE_T(len, tinyjson::get_object_key_length(&o, i));
+        EXPECT_TRUE(memcmp(k, text, len) == 0 && k[len] == '\0');
+        const char* m = (const char*)tinyjson::get_object_value(&o, i);
+        bool in_member = k < m && k > m - sizeof(tinyjson::member);
+        EXPECT_TRUE(in_member == (len <= tinyjson::MEMBER_INLINE_KEY));
+    }
+    /* 删除和清空时短键与长键混在一起 */
+    tinyjson::remove_object_value(&o, 0);
+    size_t long_key = tinyjson::MEMBER_INLINE_KEY + 1;
+    EXPECT_EQ_SIZE_T(long_key - 1, tinyjson::find_object_index(&o, text, long_key));
+    EXPECT_EQ_SIZE_T(0, tinyjson::find_object_index(&o, text, 1));
+    tinyjson::object_clear(&o);
+    EXPECT_EQ_SIZE_T(tinyjson::KEY_NOT_EXIST, tinyjson::find_object_index(&o, text, 1));
+    tinyjson::tiny_free(&o);
+
+    /* 解析得到的短字符串和短键同样不另外分配内存 */
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&o, "{\"id\":\"a\\tb\",\"a key that is long\":\"x\"}"));
+    EXPECT_EQ_STRING("id", tinyjson::get_object_key(&o, 0), tinyjson::get_object_key_length(&o, 0));
+    EXPECT_EQ_STRING("a key that is long", tinyjson::get_object_key(&o, 1), tinyjson::get_object_key_length(&o, 1));
+    EXPECT_EQ_STRING("a\tb", tinyjson::get_string(tinyjson::get_object_value(&o, 0)), 3);
+    tinyjson::tiny_free(&o);
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&e);
+}
+
 static void test_access_array() {
     tinyjson::value a, e;
     size_t i, j;
@@ -508,6 +724,8 @@ static void test_access_object() {
     tinyjson::value o, v, *pv;
     size_t i, j, index;
 
+    /* 键的标记存放在键本身的16字节中，成员不另外占用空间 */
+    EXPECT_EQ_SIZE_T(2 * sizeof(size_t) + sizeof(tinyjson::value), sizeof(tinyjson::member));
     tinyjson::tiny_init(&o);
 
     for (j = 0; j <= 5; j += 5) {
@@ -579,14 +797,990 @@ static void test_access_object() {
 #endif
 }
 
+// 成员较多的object会建立哈希索引，增删改查、收缩、清空后查找结果都要正确
+static void test_access_object_index() {
+    tinyjson::value o, o2, *pv;
+    size_t i, index;
+    char key[16];
+
+    tinyjson::tiny_init(&o);
+    tinyjson::set_object(&o, 0);
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "k%zu", i);
+        tinyjson::set_number(tinyjson::set_object_value(&o, key, strlen(key)), (double)i);
+    }
+    EXPECT_EQ_SIZE_T(1000, tinyjson::get_object_size(&o));
+    /* 已存在的键不会重复添加 */
+    tinyjson::set_object_value(&o, (char*)"k500", 4);
+    EXPECT_EQ_SIZE_T(1000, tinyjson::get_object_size(&o));
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "k%zu", i);
+        EXPECT_EQ_SIZE_T(i, tinyjson::find_object_index(&o, key, strlen(key)));
+    }
+    EXPECT_TRUE(tinyjson::find_object_index(&o, "k1000", 5) == tinyjson::KEY_NOT_EXIST);
+    EXPECT_TRUE(tinyjson::find_object_index(&o, "k", 1) == tinyjson::KEY_NOT_EXIST);
+
+    /* 删除后后面成员的下标前移 */
+    for (i = 0; i < 1000; i += 2) {
+        sprintf(key, "k%zu", i);
+        tinyjson::remove_object_value(&o, tinyjson::find_object_index(&o, key, strlen(key)));
+    }
+    EXPECT_EQ_SIZE_T(500, tinyjson::get_object_size(&o));
+    tinyjson::object_shrink(&o);
+    EXPECT_EQ_SIZE_T(500, tinyjson::get_object_capacity(&o));
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "k%zu", i);
+        index = tinyjson::find_object_index(&o, key, strlen(key));
+        if (i % 2 == 0) {
+            EXPECT_TRUE(index == tinyjson::KEY_NOT_EXIST);
+        } else {
+            EXPECT_EQ_SIZE_T(i / 2, index);
+            EXPECT_EQ_DOUBLE((double)i, tinyjson::get_number(tinyjson::get_object_value(&o, index)));
+        }
+    }
+
+    /* 拷贝和比较 */
+    tinyjson::tiny_init(&o2);
+    tinyjson::copy(&o2, &o);
+    EXPECT_TRUE(tinyjson::is_equal(&o, &o2));
+    pv = tinyjson::find_object_value(&o2, "k999", 4);
+    EXPECT_TRUE(pv != NULL);
+    tinyjson::set_number(pv, 0.0);
+    EXPECT_FALSE(tinyjson::is_equal(&o, &o2));
+    tinyjson::tiny_free(&o2);
+
+    /* 收缩到阈值以下后仍然可以查找 */
+    while (tinyjson::get_object_size(&o) > 3) {
+        tinyjson::remove_object_value(&o, 0);
+    }
+    tinyjson::object_shrink(&o);
+    EXPECT_EQ_SIZE_T(2, tinyjson::find_object_index(&o, "k999", 4));
+    tinyjson::object_clear(&o);
+    EXPECT_TRUE(tinyjson::find_object_index(&o, "k999", 4) == tinyjson::KEY_NOT_EXIST);
+    tinyjson::tiny_free(&o);
+
+    /* 解析得到的大object，包括arena模式 */
+    std::string json = "{";
+    for (i = 0; i < 100; i++) {
+        json += (i == 0 ? "\"" : ",\"") + std::to_string(i) + "\":" + std::to_string(i);
+    }
+    json += "}";
+    for (int use_pool = 0; use_pool <= 1; use_pool++) {
+        tinyjson::arena a;
+        tinyjson::parse_options opt;
+        tinyjson::arena_init(&a, nullptr, 0);
+        tinyjson::parse_options_init(&opt);
+        opt.pool = use_pool ? &a : nullptr;
+        tinyjson::tiny_init(&o);
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&o, json.c_str(), json.size(), &opt));
+        for (i = 0; i < 100; i++) {
+            sprintf(key, "%zu", i);
+            EXPECT_EQ_SIZE_T(i, tinyjson::find_object_index(&o, key, strlen(key)));
+        }
+        EXPECT_TRUE(tinyjson::find_object_index(&o, "100", 3) == tinyjson::KEY_NOT_EXIST);
+        tinyjson::tiny_free(&o);
+        tinyjson::arena_release(&a);
+    }
+}
+
+// 只解析缓冲区中的一段，后面跟着的字节不能被读取
+static void test_parse_length() {
+    tinyjson::value v;
+
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "1234567", 3));
+    EXPECT_EQ_INT(tinyjson::NUMBER, tinyjson::get_type(&v));
+    EXPECT_EQ_DOUBLE(123.0, tinyjson::get_number(&v));
+    tinyjson::tiny_free(&v);
+
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "1.5e3e", 5));
+    EXPECT_EQ_DOUBLE(1500.0, tinyjson::get_number(&v));
+    tinyjson::tiny_free(&v);
+
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "[1,\"ab\"]xyz", 8));
+    EXPECT_EQ_INT(tinyjson::ARRAY, tinyjson::get_type(&v));
+    EXPECT_EQ_SIZE_T(2, tinyjson::get_array_size(&v));
+    EXPECT_EQ_STRING("ab",
+                     tinyjson::get_string(tinyjson::get_array_element(&v, 1)),
+                     tinyjson::get_string_len(tinyjson::get_array_element(&v, 1)));
+    tinyjson::tiny_free(&v);
+
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "\"a\\u0000b\"", 10));
+    EXPECT_EQ_STRING("a\0b", tinyjson::get_string(&v), tinyjson::get_string_len(&v));
+    tinyjson::tiny_free(&v);
+
+    TEST_ERROR_LEN(tinyjson::PARSE_EXPECT_VALUE, "null", 0);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_VALUE, "null", 3);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_VALUE, "true", 2);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_VALUE, "1.5", 2);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_VALUE, "1e5", 2);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_VALUE, "-1", 1);
+    TEST_ERROR_LEN(tinyjson::PARSE_MISS_QUOTATION_MARK, "\"abc\"", 4);
+    TEST_ERROR_LEN(tinyjson::PARSE_MISS_QUOTATION_MARK, "\"a\\n\"", 3);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_UNICODE_HEX, "\"\\u0041\"", 6);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD834\\uDD1E\"", 8);
+    TEST_ERROR_LEN(tinyjson::PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1,2]", 4);
+    TEST_ERROR_LEN(tinyjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1}", 6);
+    TEST_ERROR_LEN(tinyjson::PARSE_MISS_COLON, "{\"a\":1}", 4);
+
+    // 长度范围内的'\0'是普通字节，不再作为结束标志
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_STRING_CHAR, "\"a\0b\"", 5);
+    TEST_ERROR_LEN(tinyjson::PARSE_ROOT_NOT_SINGULAR, "null\0", 5);
+    TEST_ERROR_LEN(tinyjson::PARSE_INVALID_VALUE, "\0", 1);
+}
+
+static void test_parse_arena() {
+    const char* json = "{\"n\":null,\"s\":\"abc\",\"a\":[1,\"x\",[true,{}]],\"o\":{\"k\":\"long string value\"}}";
+    char buffer[64]; // 故意给一个很小的初始缓冲区，迫使arena从堆上申请新块
+    tinyjson::arena pool;
+    tinyjson::parse_options opt;
+    tinyjson::value v, expect, dup;
+
+    tinyjson::arena_init(&pool, buffer, sizeof(buffer));
+    tinyjson::parse_options_init(&opt);
+    opt.pool = &pool;
+
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&expect);
+    tinyjson::tiny_init(&dup);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, strlen(json), &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&expect, json));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    EXPECT_TRUE(pool.blocks != NULL);
+    EXPECT_EQ_STRING("abc",
+                     tinyjson::get_string(tinyjson::find_object_value(&v, "s", 1)),
+                     tinyjson::get_string_len(tinyjson::find_object_value(&v, "s", 1)));
+
+    // 拷贝出来的树在堆上，释放arena后仍然有效
+    tinyjson::copy(&dup, &v);
+    tinyjson::tiny_free(&v);
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    tinyjson::arena_release(&pool);
+    EXPECT_TRUE(pool.blocks == NULL);
+    EXPECT_EQ_SIZE_T(0, pool.used);
+    EXPECT_TRUE(tinyjson::is_equal(&dup, &expect));
+    tinyjson::set_string(tinyjson::find_object_value(&dup, "s", 1), "def", 3);
+    EXPECT_FALSE(tinyjson::is_equal(&dup, &expect));
+
+    // 解析失败时不会有节点残留，arena照常释放
+    tinyjson::set_boolean(&v, 0);
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET, tinyjson::parse(&v, "{\"a\":[\"b\"]", 11, &opt));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    EXPECT_EQ_INT(tinyjson::PARSE_ROOT_NOT_SINGULAR, tinyjson::parse(&v, "[\"b\"] x", 7, &opt));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    tinyjson::arena_release(&pool);
+
+    // 不提供初始缓冲区时完全从堆上申请
+    tinyjson::arena_init(&pool, NULL, 0);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, strlen(json), &opt));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+    tinyjson::arena_release(&pool);
+
+    // 初始缓冲区的地址不是8的倍数时，分配结果和解析出的节点仍然按8字节对齐
+    char unaligned[1024];
+    char* base = unaligned + (8 - (uintptr_t)unaligned % 8) % 8 + 1;
+    tinyjson::arena_init(&pool, base, sizeof(unaligned) - 16);
+    EXPECT_TRUE((uintptr_t)tinyjson::arena_alloc(&pool, 1) % 8 == 0);
+    char* p = (char*)tinyjson::arena_alloc(&pool, 3);
+    EXPECT_TRUE((uintptr_t)p % 8 == 0 && p >= base && p < base + pool.size);
+    EXPECT_TRUE((uintptr_t)tinyjson::arena_alloc(&pool, 8) % 8 == 0);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, strlen(json), &opt));
+    EXPECT_TRUE(pool.blocks == NULL); // 全部节点都在调用者的缓冲区中
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    const tinyjson::value* a = tinyjson::find_object_value(&v, "a", 1);
+    EXPECT_TRUE((uintptr_t)a % 8 == 0);
+    EXPECT_TRUE((uintptr_t)tinyjson::get_array_element(a, 0) % 8 == 0);
+    EXPECT_TRUE((uintptr_t)tinyjson::find_object_value(tinyjson::find_object_value(&v, "o", 1), "k", 1) % 8 == 0);
+    EXPECT_EQ_DOUBLE(1.0, tinyjson::get_number(tinyjson::get_array_element(a, 0)));
+    tinyjson::tiny_free(&v);
+    tinyjson::arena_release(&pool);
+    EXPECT_TRUE((uintptr_t)tinyjson::arena_alloc(&pool, 16) % 8 == 0);
+    tinyjson::arena_release(&pool);
+
+    tinyjson::tiny_free(&expect);
+    tinyjson::tiny_free(&dup);
+}
+
+// 宽的array/object直接写入最终的内存块，结果与默认方式完全相同，容量恰好等于大小
+static void test_parse_in_place() {
+    std::string json = "[";
+    for (int i = 0; i < 300; i++) {
+        json += i == 0 ? "" : ",";
+        json += "{\"k" + std::to_string(i) + "\":[" + std::to_string(i) + ",\"s\",[],{}],\"n\":null}";
+    }
+    json += ",{";
+    for (int i = 0; i < 100; i++) {
+        json += (i == 0 ? "\"" : ",\"") + std::to_string(i) + "\":" + std::to_string(i);
+    }
+    json += "}]";
+    tinyjson::value v, expect;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&expect);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&expect, json.c_str(), json.size()));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, parse_in_place(&v, json.c_str(), json.size()));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    EXPECT_EQ_SIZE_T(301, tinyjson::get_array_size(&v));
+    EXPECT_EQ_SIZE_T(301, tinyjson::get_array_capacity(&v));
+    tinyjson::value* e = tinyjson::get_array_element(&v, 0);
+    EXPECT_EQ_SIZE_T(2, tinyjson::get_object_capacity(e));
+    EXPECT_EQ_SIZE_T(4, tinyjson::get_array_capacity(tinyjson::get_object_value(e, 0)));
+    /* 成员较多的object同样建立了索引 */
+    e = tinyjson::get_array_element(&v, 300);
+    EXPECT_EQ_SIZE_T(100, tinyjson::get_object_capacity(e));
+    EXPECT_EQ_SIZE_T(99, tinyjson::find_object_index(e, "99", 2));
+    tinyjson::set_object_value(e, (char*)"new", 3);
+    EXPECT_EQ_SIZE_T(100, tinyjson::find_object_index(e, "new", 3));
+    tinyjson::tiny_free(&v);
+
+    /* 出错时释放已经放入块中的元素 */
+    json.replace(json.size() - 2, 1, ",");
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_KEY, parse_in_place(&v, json.c_str(), json.size()));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+
+    /* 与string view和arena一起使用 */
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.flags = tinyjson::PARSE_FLAG_IN_PLACE | tinyjson::PARSE_FLAG_STRING_VIEW;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "[\"a\",{\"b\":[\"c\"]}]", 17, &opt));
+    EXPECT_EQ_STRING("c", tinyjson::get_string(tinyjson::get_array_element(
+                              tinyjson::find_object_value(tinyjson::get_array_element(&v, 1), "b", 1), 0)), 1);
+    tinyjson::tiny_free(&v);
+    tinyjson::arena pool;
+    tinyjson::arena_init(&pool, NULL, 0);
+    opt.pool = &pool;
+    json.replace(json.size() - 2, 1, "}");
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size(), &opt));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+    tinyjson::arena_release(&pool);
+    tinyjson::tiny_free(&expect);
+}
+
+// 长键从key_table驻留，多个文档共享同一份副本
+static void test_parse_key_table() {
+    const char json[] = "[{\"a rather long key name\":1,\"id\":2},{\"id\":3,\"a rather long key name\":4}]";
+    tinyjson::key_table keys;
+    tinyjson::key_table_init(&keys);
+    const char* k = tinyjson::key_table_intern(&keys, "a rather long key name", 22);
+    EXPECT_EQ_STRING("a rather long key name", k, strlen(k));
+    EXPECT_TRUE(k == tinyjson::key_table_intern(&keys, "a rather long key name", 22));
+    EXPECT_TRUE(k != tinyjson::key_table_intern(&keys, "a rather long key", 17));
+    EXPECT_EQ_SIZE_T(2, tinyjson::key_table_size(&keys));
+    /* 扩容后已经返回的指针仍然有效 */
+    std::vector<const char*> interned;
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key number " + std::to_string(i);
+        interned.push_back(tinyjson::key_table_intern(&keys, key.c_str(), key.size()));
+    }
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key number " + std::to_string(i);
+        EXPECT_TRUE(interned[i] == tinyjson::key_table_intern(&keys, key.c_str(), key.size()));
+    }
+    EXPECT_EQ_SIZE_T(1002, tinyjson::key_table_size(&keys));
+    EXPECT_TRUE(k == tinyjson::key_table_intern(&keys, "a rather long key name", 22));
+
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.keys = &keys;
+    tinyjson::value v, v2, expect;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&v2);
+    tinyjson::tiny_init(&expect);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, sizeof(json) - 1, &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v2, json, sizeof(json) - 1, &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&expect, json, sizeof(json) - 1));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    /* 短键仍然存放在成员内，不进入驻留表 */
+    EXPECT_EQ_SIZE_T(1002, tinyjson::key_table_size(&keys));
+    tinyjson::value* e0 = tinyjson::get_array_element(&v, 0);
+    tinyjson::value* e1 = tinyjson::get_array_element(&v, 1);
+    EXPECT_TRUE(tinyjson::get_object_key(e0, 0) == k);
+    EXPECT_TRUE(tinyjson::get_object_key(e1, 1) == k);
+    EXPECT_TRUE(tinyjson::get_object_key(tinyjson::get_array_element(&v2, 0), 0) == k);
+    EXPECT_EQ_SIZE_T(1, tinyjson::find_object_index(e1, k, 22));
+
+    /* 修改和删除共享键的成员不会释放驻留的键 */
+    tinyjson::set_number(tinyjson::set_object_value(e0, "another long key name", 21, &keys), 5.0);
+    EXPECT_EQ_SIZE_T(1003, tinyjson::key_table_size(&keys));
+    EXPECT_TRUE(tinyjson::get_object_key(e0, 2) == tinyjson::key_table_intern(&keys, "another long key name", 21));
+    tinyjson::remove_object_value(e0, 0);
+    tinyjson::object_clear(e1);
+    tinyjson::tiny_free(&v);
+    EXPECT_EQ_STRING("a rather long key name", k, strlen(k));
+    /* 拷贝得到的文档拥有自己的键，可以比驻留表活得更久 */
+    tinyjson::copy(&v, &v2);
+    tinyjson::tiny_free(&v2);
+    tinyjson::key_table_free(&keys);
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+
+    /* 出错时已经驻留的键留在表中 */
+    tinyjson::key_table_init(&keys);
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COLON, tinyjson::parse(&v, "{\"a rather long key name\"}", 26, &opt));
+    EXPECT_EQ_SIZE_T(1, tinyjson::key_table_size(&keys));
+    tinyjson::key_table_free(&keys);
+    tinyjson::tiny_free(&expect);
+
+    /* 多个线程按不同的顺序同时驻留同一批键，查找与插入、扩容并发进行，同一个键总是得到同一个指针 */
+    const int threads = 4, count = 2000;
+    std::vector<std::vector<const char*>> results(threads, std::vector<const char*>(count));
+    tinyjson::key_table_init(&keys);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&keys, &results, t] {
+            for (int round = 0; round < 2; round++) {
+                for (int i = 0; i < count; i++) {
+                    int n = (i * 7 + t * 13) % count;
+                    std::string key = "concurrently interned key " + std::to_string(n);
+                    const char* k = tinyjson::key_table_intern(&keys, key.c_str(), key.size());
+                    if (round == 0) {
+                        results[t][n] = k;
+                    } else if (results[t][n] != k) {
+                        results[t][n] = nullptr;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    EXPECT_EQ_SIZE_T(count, tinyjson::key_table_size(&keys));
+    for (int n = 0; n < count; n++) {
+        std::string key = "concurrently interned key " + std::to_string(n);
+        const char* k = tinyjson::key_table_intern(&keys, key.c_str(), key.size());
+        bool same = strcmp(k, key.c_str()) == 0;
+        for (int t = 0; t < threads; t++) {
+            same = same && results[t][n] == k;
+        }
+        EXPECT_TRUE(same);
+    }
+    tinyjson::key_table_free(&keys);
+}
+
+typedef struct {
+    std::vector<size_t> lines;
+    std::vector<int> status;
+    size_t mismatch, limit;
+    tinyjson::value kept;
+} ndjson_result;
+
+static int ndjson_collect(void* user, size_t line, tinyjson::value* v, int status) {
+    ndjson_result* r = (ndjson_result*)user;
+    r->lines.push_back(line);
+    r->status.push_back(status);
+    if (status == tinyjson::PARSE_OK) {
+        /* 每条记录的id等于它的行号 */
+        tinyjson::value* id = tinyjson::find_object_value(v, "id", 2);
+        if (id == nullptr || tinyjson::get_number(id) != (double)line) {
+            r->mismatch++;
+        }
+        if (line == 1) {
+            tinyjson::move(&r->kept, v);
+        }
+    } else if (tinyjson::get_type(v) != tinyjson::TINYNULL) {
+        r->mismatch++;
+    }
+    return r->lines.size() == r->limit;
+}
+
+static void test_parse_ndjson() {
+    /* 第0行为空行，每隔7行一条空白行，每隔50行一条错误的记录，行尾混用\n和\r\n，最后一行没有换行 */
+    std::string json = "\n";
+    size_t records = 0, errors = 0;
+    for (size_t line = 1; line < 1000; line++) {
+        if (line % 7 == 0) {
+            json += " \t\r\n";
+            continue;
+        }
+        if (line % 50 == 0) {
+            json += "{\"id\":" + std::to_string(line) + ",}\n";
+            errors++;
+        } else {
+            json += "{\"id\":" + std::to_string(line) + ",\"a rather long key name\":[1,2,3]}";
+            json += line % 3 ? "\n" : "\r\n";
+        }
+        records++;
+    }
+    json.erase(json.size() - 1);
+
+    tinyjson::key_table keys;
+    tinyjson::key_table_init(&keys);
+    tinyjson::parse_options popt;
+    tinyjson::parse_options_init(&popt);
+    popt.keys = &keys;
+    tinyjson::ndjson_options opt;
+    tinyjson::ndjson_options_init(&opt);
+    opt.batch_size = 100;
+    opt.parse = &popt;
+    /* 4个线程有序交付、4个线程无序交付、直接在调用线程上解析 */
+    for (int run = 0; run < 3; run++) {
+        ndjson_result r;
+        r.mismatch = 0;
+        r.limit = 0;
+        tinyjson::tiny_init(&r.kept);
+        opt.threads = run < 2 ? 4 : 1;
+        opt.ordered = run != 1;
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_ndjson(json.data(), json.size(), ndjson_collect, &r, &opt));
+        EXPECT_EQ_SIZE_T(records, r.lines.size());
+        EXPECT_EQ_SIZE_T(0, r.mismatch);
+        size_t ok = 0, sorted = 1;
+        for (size_t i = 0; i < r.lines.size(); i++) {
+            ok += r.status[i] == tinyjson::PARSE_OK;
+            EXPECT_TRUE(r.status[i] == tinyjson::PARSE_OK || r.lines[i] % 50 == 0);
+            if (i > 0 && r.lines[i] <= r.lines[i - 1]) {
+                sorted = 0;
+            }
+        }
+        EXPECT_EQ_SIZE_T(records - errors, ok);
+        if (opt.ordered) {
+            EXPECT_TRUE(sorted);
+        }
+        /* 回调取走的值在parse_ndjson返回后仍然有效 */
+        EXPECT_EQ_INT(tinyjson::OBJECT, tinyjson::get_type(&r.kept));
+        tinyjson::value* a = tinyjson::find_object_value(&r.kept, "a rather long key name", 22);
+        EXPECT_EQ_SIZE_T(3, tinyjson::get_array_size(a));
+        tinyjson::tiny_free(&r.kept);
+    }
+    /* 所有线程共享同一张驻留表 */
+    EXPECT_EQ_SIZE_T(1, tinyjson::key_table_size(&keys));
+
+    /* 回调返回非0时停止，之后的记录不再交付 */
+    ndjson_result r;
+    r.mismatch = 0;
+    r.limit = 10;
+    tinyjson::tiny_init(&r.kept);
+    opt.threads = 4;
+    opt.ordered = 1;
+    EXPECT_EQ_INT(tinyjson::PARSE_CANCELED, tinyjson::parse_ndjson(json.data(), json.size(), ndjson_collect, &r, &opt));
+    EXPECT_EQ_SIZE_T(10, r.lines.size());
+    EXPECT_EQ_SIZE_T(11, r.lines.back());
+    tinyjson::tiny_free(&r.kept);
+    tinyjson::key_table_free(&keys);
+
+    /* 默认选项；空输入和只有空行的输入不产生记录 */
+    r.lines.clear();
+    r.limit = 0;
+    const char lines[] = "{\"id\":0}\n{\"id\":1}\n";
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_ndjson(lines, sizeof(lines) - 1, ndjson_collect, &r, nullptr));
+    EXPECT_EQ_SIZE_T(2, r.lines.size());
+    EXPECT_EQ_SIZE_T(0, r.mismatch);
+    tinyjson::tiny_free(&r.kept);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_ndjson(nullptr, 0, ndjson_collect, &r, nullptr));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_ndjson("\n\r\n \n", 5, ndjson_collect, &r, nullptr));
+    EXPECT_EQ_SIZE_T(2, r.lines.size());
+}
+
+/* parse_parallel的结果和返回值必须与顺序解析完全相同 */
+static void check_parallel(const std::string& json, const tinyjson::parse_options* opt) {
+    tinyjson::value v, expect;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&expect);
+    int ret = tinyjson::parse(&expect, json.data(), json.size(), opt);
+    EXPECT_EQ_INT(ret, tinyjson::parse_parallel(&v, json.data(), json.size(), 4, opt));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&expect);
+}
+
+static void test_parse_parallel() {
+    /* 字符串中的逗号、括号、转义的引号和反斜杠都不能被当作结构字符 */
+    std::string array = " [";
+    std::string object = "{";
+    for (int i = 0; i < 20000; i++) {
+        std::string item;
+        switch (i % 5) {
+        case 0:
+            item = std::to_string(i * 0.5);
+            break;
+        case 1:
+            item = "\"a,b]c}\\\"d\\\\\",\"e\\u4E2D\"";
+            item = "[" + item + ",null,true,{}]";
+            break;
+        case 2:
+            item = "{\"key, with [comma]\":[1,{\"x\":\"\\\\\"}],\"y\":false}";
+            break;
+        case 3:
+            item = "\"" + std::to_string(i) + "\\\\\"";
+            break;
+        default:
+            item = " \t[ [], [[\"\\\"]\"]] ]\n";
+            break;
+        }
+        array += (i ? "," : "") + item;
+        object += i ? ",\"" : "\"";
+        object += std::string(i % 7 ? "k" : "a rather long key ") + std::to_string(i) + "\" :" + item;
+    }
+    array += "]\r\n";
+    object += "}";
+    EXPECT_TRUE(array.size() >= tinyjson::PARSE_PARALLEL_MIN_SIZE);
+    check_parallel(array, nullptr);
+    check_parallel(object, nullptr);
+
+    tinyjson::value v;
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_parallel(&v, object.data(), object.size(), 4, nullptr));
+    EXPECT_EQ_SIZE_T(20000, tinyjson::get_object_size(&v));
+    EXPECT_EQ_SIZE_T(19998, tinyjson::find_object_index(&v, "k19998", 6));
+    tinyjson::tiny_free(&v);
+
+    tinyjson::key_table keys;
+    tinyjson::key_table_init(&keys);
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.flags = tinyjson::PARSE_FLAG_STRING_VIEW | tinyjson::PARSE_FLAG_IN_PLACE;
+    opt.keys = &keys;
+    check_parallel(array, &opt);
+    check_parallel(object, &opt);
+    tinyjson::key_table_free(&keys);
+
+    /* 各种错误改为顺序解析，返回值与parse相同 */
+    check_parallel(array.substr(0, array.size() - 3), nullptr);
+    check_parallel(array + "x", nullptr);
+    check_parallel(array.substr(0, array.size() - 3) + "}", nullptr);
+    check_parallel(object.substr(0, object.size() / 2) + "," + object.substr(object.size() / 2), nullptr);
+    check_parallel(object.substr(0, object.size() / 2) + "]" + object.substr(object.size() / 2), nullptr);
+    check_parallel(array.substr(0, array.size() / 3) + ",," + array.substr(array.size() / 3), nullptr);
+    check_parallel("[" + object + "]", nullptr);
+    opt.keys = nullptr;
+    opt.max_depth = 3;
+    check_parallel(array, &opt);
+    opt.max_depth = 1;
+    check_parallel(array, &opt);
+    opt.max_depth = 0;
+    check_parallel(array, &opt);
+
+    /* 根不是array/object或文档太小时直接顺序解析 */
+    check_parallel(std::string(tinyjson::PARSE_PARALLEL_MIN_SIZE, ' ') + "\"x\"", nullptr);
+    check_parallel("[1,2,3]", nullptr);
+    check_parallel("[" + std::string(tinyjson::PARSE_PARALLEL_MIN_SIZE, ' ') + "]", nullptr);
+    check_parallel("", nullptr);
+}
+
+static void test_parse_file() {
+    const char* path = "tinyjson_test_parse_file.json";
+    const char json[] = " {\"name\":\"a long enough string value\",\"list\":[1,\"esc\\n\",{\"k\":null}]} ";
+    tinyjson::value v, expect;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&expect);
+    EXPECT_EQ_INT(tinyjson::PARSE_FILE_ERROR, tinyjson::parse_file(&v, "tinyjson_no_such_file.json"));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+
+    FILE* fp = fopen(path, "wb");
+    EXPECT_TRUE(fp != NULL);
+    if (fp == NULL) {
+        return;
+    }
+    fclose(fp);
+    /* 空文件无法映射，读入的内容为空 */
+    EXPECT_EQ_INT(tinyjson::PARSE_EXPECT_VALUE, tinyjson::parse_file(&v, path));
+
+    fp = fopen(path, "wb");
+    fwrite(json, 1, sizeof(json) - 1, fp);
+    fclose(fp);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&expect, json));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_file(&v, path));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+
+    /* 不保留映射时忽略PARSE_FLAG_STRING_VIEW，字符串在解除映射后仍然有效 */
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.flags = tinyjson::PARSE_FLAG_STRING_VIEW;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_file(&v, path, &opt));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+
+    /* 保留映射时字符串直接引用文件的内容 */
+    tinyjson::mapped_file f;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse_file(&v, path, &opt, &f));
+    EXPECT_EQ_SIZE_T(sizeof(json) - 1, f.size);
+#ifndef _WIN32
+    EXPECT_TRUE(f.mapped);
+#endif
+    EXPECT_TRUE(memcmp(f.data, json, f.size) == 0);
+    const char* s = tinyjson::get_string(tinyjson::find_object_value(&v, "name", 4));
+    EXPECT_TRUE(s >= f.data && s < f.data + f.size);
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+    tinyjson::tiny_free(&v);
+    tinyjson::unmap_file(&f);
+    EXPECT_TRUE(f.data == nullptr);
+
+    /* 语法错误与parse相同 */
+    fp = fopen(path, "wb");
+    fwrite(json, 1, sizeof(json) - 3, fp);
+    fclose(fp);
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET, tinyjson::parse_file(&v, path, nullptr, &f));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    tinyjson::unmap_file(&f);
+    remove(path);
+#ifdef __linux__
+    /* /proc中的文件大小为0，无法映射，改为读取 */
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::map_file(&f, "/proc/self/stat"));
+    EXPECT_TRUE(!f.mapped && f.size > 0);
+    tinyjson::unmap_file(&f);
+#endif
+    tinyjson::tiny_free(&expect);
+}
+
+static void test_parse_string_view() {
+    const char json[] = "{\"key\":\"plain\",\"e\\u0073c\":\"esc\\n\",\"a\":[\"x\",\"\"]}";
+    const char* end = json + sizeof(json) - 1;
+    tinyjson::parse_options opt;
+    tinyjson::value v, expect;
+    tinyjson::value* e;
+
+    tinyjson::parse_options_init(&opt);
+    opt.flags = tinyjson::PARSE_FLAG_STRING_VIEW;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&expect);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, sizeof(json) - 1, &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&expect, json));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+
+    // 不含转义的键和字符串直接指向输入缓冲区
+    EXPECT_EQ_STRING("key", tinyjson::get_object_key(&v, 0), tinyjson::get_object_key_length(&v, 0));
+    EXPECT_TRUE(tinyjson::get_object_key(&v, 0) == json + 2);
+    e = tinyjson::get_object_value(&v, 0);
+    EXPECT_EQ_STRING("plain", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    EXPECT_TRUE(tinyjson::get_string(e) >= json && tinyjson::get_string(e) < end);
+
+    // 含转义的需要另外分配内存
+    EXPECT_EQ_STRING("esc", tinyjson::get_object_key(&v, 1), tinyjson::get_object_key_length(&v, 1));
+    EXPECT_TRUE(tinyjson::get_object_key(&v, 1) < json || tinyjson::get_object_key(&v, 1) >= end);
+    e = tinyjson::get_object_value(&v, 1);
+    EXPECT_EQ_STRING("esc\n", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    EXPECT_TRUE(tinyjson::get_string(e) < json || tinyjson::get_string(e) >= end);
+
+    // 修改引用输入缓冲区的节点不会释放输入缓冲区
+    tinyjson::set_string(tinyjson::get_array_element(tinyjson::find_object_value(&v, "a", 1), 0), "y", 1);
+    tinyjson::remove_object_value(&v, 0);
+    EXPECT_EQ_SIZE_T(2, tinyjson::get_object_size(&v));
+    tinyjson::tiny_free(&v);
+
+    // 与arena一起使用
+    {
+        tinyjson::arena pool;
+        tinyjson::arena_init(&pool, NULL, 0);
+        opt.pool = &pool;
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, sizeof(json) - 1, &opt));
+        EXPECT_TRUE(tinyjson::is_equal(&v, &expect));
+        EXPECT_TRUE(tinyjson::get_object_key(&v, 0) == json + 2);
+        tinyjson::tiny_free(&v);
+        EXPECT_EQ_INT(tinyjson::PARSE_MISS_COLON, tinyjson::parse(&v, "{\"a\":1,\"b\"}", 11, &opt));
+        tinyjson::arena_release(&pool);
+    }
+
+    opt.pool = NULL;
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COLON, tinyjson::parse(&v, "{\"a\":\"x\",\"b\"}", 15, &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_INVALID_STRING_ESCAPE, tinyjson::parse(&v, "[\"a\",\"b\\x\"]", 12, &opt));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    tinyjson::tiny_free(&expect);
+}
+
+// 长字符串会走按块扫描的路径，需要检查特殊字符出现在块内各个位置以及跨越块边界的情况
+static void test_parse_long_string() {
+    char json[128], expect[128];
+    tinyjson::value v;
+    size_t len, pos;
+
+    tinyjson::tiny_init(&v);
+    for (len = 0; len < 100; ++len) {
+        json[0] = '"';
+        memset(json + 1, 'a', len);
+        json[len + 1] = '"';
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, len + 2));
+        EXPECT_EQ_SIZE_T(len, tinyjson::get_string_len(&v));
+        tinyjson::tiny_free(&v);
+        EXPECT_EQ_INT(tinyjson::PARSE_MISS_QUOTATION_MARK, tinyjson::parse(&v, json, len + 1));
+
+        for (pos = 0; pos < len; ++pos) {
+            json[pos + 1] = '\x1f';
+            EXPECT_EQ_INT(tinyjson::PARSE_INVALID_STRING_CHAR, tinyjson::parse(&v, json, len + 2));
+            json[pos + 1] = '\\';
+            EXPECT_EQ_INT(pos + 1 < len ? tinyjson::PARSE_INVALID_STRING_ESCAPE : tinyjson::PARSE_MISS_QUOTATION_MARK,
+                          tinyjson::parse(&v, json, len + 2));
+
+            // 在pos处插入转义字符\n
+            memset(json + 1, 'a', len + 1);
+            json[pos + 1] = '\\';
+            json[pos + 2] = 'n';
+            json[len + 2] = '"';
+            memset(expect, 'a', len);
+            expect[pos] = '\n';
+            EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, len + 3));
+            EXPECT_EQ_SIZE_T(len, tinyjson::get_string_len(&v));
+            EXPECT_TRUE(memcmp(expect, tinyjson::get_string(&v), len) == 0);
+            tinyjson::tiny_free(&v);
+
+            memset(json + 1, 'a', len + 1);
+            json[len + 1] = '"';
+        }
+    }
+    tinyjson::tiny_free(&v);
+}
+
+// SAX事件按顺序记录成一个字符串，便于和期望值比较
+static int sax_null(void* user) {
+    *(std::string*)user += "n ";
+    return 0;
+}
+static int sax_boolean(void* user, int b) {
+    *(std::string*)user += b ? "t " : "f ";
+    return 0;
+}
+static int sax_number(void* user, double n) {
+    char buffer[32];
+    sprintf(buffer, "%g ", n);
+    *(std::string*)user += buffer;
+    return 0;
+}
+static int sax_string(void* user, const char* s, size_t len) {
+    *(std::string*)user += "\"" + std::string(s, len) + "\" ";
+    return 0;
+}
+static int sax_key(void* user, const char* k, size_t len) {
+    *(std::string*)user += std::string(k, len) + ": ";
+    return 0;
+}
+static int sax_start_array(void* user) {
+    *(std::string*)user += "[ ";
+    return 0;
+}
+static int sax_end_array(void* user, size_t count) {
+    *(std::string*)user += "]" + std::to_string(count) + " ";
+    return 0;
+}
+static int sax_start_object(void* user) {
+    *(std::string*)user += "{ ";
+    return 0;
+}
+static int sax_end_object(void* user, size_t count) {
+    *(std::string*)user += "}" + std::to_string(count) + " ";
+    return (int)(((std::string*)user)->size() > 1000); /* 事件足够多时中止 */
+}
+
+#define TEST_SAX(expect, json)                                                                                         \
+    do {                                                                                                               \
+        std::string events;                                                                                            \
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::sax_parse(json, strlen(json), &h, &events));                      \
+        EXPECT_EQ_STRING(expect, events.c_str(), events.size());                                                       \
+    } while (0)
+
+static void test_parse_sax() {
+    tinyjson::sax_handler h;
+    std::string events;
+    tinyjson::sax_handler_init(&h);
+    h.null_value = sax_null;
+    h.boolean = sax_boolean;
+    h.number = sax_number;
+    h.string = sax_string;
+    h.key = sax_key;
+    h.start_array = sax_start_array;
+    h.end_array = sax_end_array;
+    h.start_object = sax_start_object;
+    h.end_object = sax_end_object;
+
+    TEST_SAX("n ", " null ");
+    TEST_SAX("t ", "true");
+    TEST_SAX("-1.5 ", "-1.5");
+    TEST_SAX("\"Hello\nWorld\" ", "\"Hello\\nWorld\"");
+    TEST_SAX("[ ]0 ", "[ ]");
+    TEST_SAX("{ }0 ", "{ }");
+    TEST_SAX("[ n f t 123 \"abc\" [ 1 2 ]2 ]6 ", "[ null , false , true , 123 , \"abc\", [ 1, 2 ] ]");
+    TEST_SAX("{ n: n f: f t: t i: 123 s: \"abc\" a: [ 1 2 3 ]3 o: { 1: 1 2: 2 }2 }7 ",
+             " { "
+             "\"n\" : null , "
+             "\"f\" : false , "
+             "\"t\" : true , "
+             "\"i\" : 123 , "
+             "\"s\" : \"abc\", "
+             "\"a\" : [ 1, 2, 3 ],"
+             "\"o\" : { \"1\" : 1, \"2\" : 2 }"
+             " } ");
+    /* 含转义的键 */
+    TEST_SAX("{ a\"b: [ ]0 }1 ", "{\"a\\\"b\":[]}");
+
+    /* 回调返回非0时中止解析，之后不再产生事件 */
+    std::string json = "[";
+    for (int i = 0; i < 1000; i++) {
+        json += i == 0 ? "{}" : ",{}";
+    }
+    json += "]";
+    EXPECT_EQ_INT(tinyjson::PARSE_CANCELED, tinyjson::sax_parse(json.c_str(), json.size(), &h, &events));
+    EXPECT_TRUE(events.size() > 1000 && events.size() < 1010);
+
+    /* 出错之前的事件已经产生 */
+    events.clear();
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_SQUARE_BRACKET, tinyjson::sax_parse("[1}", 3, &h, &events));
+    EXPECT_EQ_STRING("[ 1 ", events.c_str(), events.size());
+}
+
+// 嵌套层数由max_depth限制，解析、释放、拷贝、比较和生成都不使用递归
+static void test_parse_depth() {
+    std::string json;
+    for (size_t i = 0; i < tinyjson::PARSE_MAX_DEPTH; i++) {
+        json += i % 2 ? "{\"a\":" : "[";
+    }
+    json += "[]";
+    for (size_t i = tinyjson::PARSE_MAX_DEPTH; i > 0; i--) {
+        json += (i - 1) % 2 ? "}" : "]";
+    }
+    TEST_ERROR_LEN(tinyjson::PARSE_TOO_DEEP, json.c_str(), json.size());
+    /* 最内层的[]去掉后恰好是PARSE_MAX_DEPTH层 */
+    json.replace(json.find("[]"), 2, "1");
+    tinyjson::value v;
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size()));
+    tinyjson::tiny_free(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_parse(&v, json.c_str(), json.size(), 1000));
+    tinyjson::tiny_free(&v);
+
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.max_depth = 2;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "[{\"a\":1},[]]", 12, &opt));
+    tinyjson::tiny_free(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_TOO_DEEP, tinyjson::parse(&v, "[{\"a\":[]}]", 11, &opt));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    tinyjson::sax_handler h;
+    tinyjson::sax_handler_init(&h);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::sax_parse("[{\"a\":1},[]]", 12, &h, nullptr, &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_TOO_DEEP, tinyjson::sax_parse("[{\"a\":[]}]", 11, &h, nullptr, &opt));
+
+    /* 放开限制后可以处理远超C调用栈能力的嵌套 */
+    const size_t depth = 1000000;
+    json.assign(depth, '[');
+    json.append(depth, ']');
+    opt.max_depth = (size_t)-1;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size(), &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::sax_parse(json.c_str(), json.size(), &h, nullptr, &opt));
+    tinyjson::value v2;
+    tinyjson::tiny_init(&v2);
+    tinyjson::copy(&v2, &v);
+    EXPECT_TRUE(tinyjson::is_equal(&v, &v2));
+    size_t len;
+    char* json2 = tinyjson::stringify(&v2, &len);
+    EXPECT_TRUE(len == json.size() && memcmp(json2, json.c_str(), len) == 0);
+    free(json2);
+    tinyjson::tiny_free(&v2);
+    tinyjson::tiny_free(&v);
+}
+
+static int push_feed(tinyjson::push_parser* p, const char* chunk) {
+    return tinyjson::push_parser_feed(p, chunk, strlen(chunk));
+}
+
+static void test_parse_push() {
+    static const char* const docs[] = {
+        "null",
+        " true ",
+        "-1.25e+10",
+        "0",
+        "\"Hello\\u4F60\\uD834\\uDD1E\\n\\\"World\\\"\"",
+        "[ null , false , true , 123 , \"abc\", [ 1, 2, [] ], {} ]",
+        " { "
+        "\"n\" : null , "
+        "\"f\" : false , "
+        "\"t\" : true , "
+        "\"i\" : 123 , "
+        "\"s\" : \"abc\", "
+        "\"a\" : [ 1, 2, 3 ],"
+        "\"o\" : { \"1\" : 1, \"2\" : 2, \"3\" : 3 },"
+        "\"e\\t\" : [ { \"x\": -0.5e-3 }, \"\\\\\" ]"
+        " } ",
+    };
+    for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        size_t len = strlen(docs[i]);
+        tinyjson::value expect, v;
+        tinyjson::tiny_init(&expect);
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&expect, docs[i]));
+        /* 任意分块得到的DOM都相同 */
+        for (size_t chunk = 1; chunk <= len; chunk++) {
+            tinyjson::tiny_init(&v);
+            EXPECT_EQ_INT(tinyjson::PARSE_OK, push_parse(&v, docs[i], len, chunk));
+            EXPECT_TRUE(tinyjson::is_equal(&expect, &v));
+            tinyjson::tiny_free(&v);
+        }
+        tinyjson::tiny_free(&expect);
+    }
+
+    /* 根值完整之后即可得知，数字要等到后面出现其他字符 */
+    tinyjson::push_parser p;
+    tinyjson::value v;
+    tinyjson::push_parser_init(&p, &v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "{\"a\":[1"));
+    EXPECT_FALSE(tinyjson::push_parser_complete(&p));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "]}"));
+    EXPECT_TRUE(tinyjson::push_parser_complete(&p));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::push_parser_finish(&p));
+    EXPECT_EQ_INT(tinyjson::OBJECT, tinyjson::get_type(&v));
+    tinyjson::tiny_free(&v);
+    tinyjson::push_parser_free(&p);
+
+    tinyjson::push_parser_init(&p, &v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "12"));
+    EXPECT_FALSE(tinyjson::push_parser_complete(&p));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "3 "));
+    EXPECT_TRUE(tinyjson::push_parser_complete(&p));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::push_parser_finish(&p));
+    EXPECT_EQ_DOUBLE(123.0, tinyjson::get_number(&v));
+    tinyjson::tiny_free(&v);
+    tinyjson::push_parser_free(&p);
+
+    /* 出错后之前构建的部分被释放，之后的调用返回同样的错误 */
+    tinyjson::push_parser_init(&p, &v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "[\"abc\", {\"a\":"));
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET, push_feed(&p, "1]"));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(&v));
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET, push_feed(&p, "}]"));
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_CURLY_BRACKET, tinyjson::push_parser_finish(&p));
+    tinyjson::push_parser_free(&p);
+
+    /* SAX模式 */
+    tinyjson::sax_handler h;
+    std::string events;
+    tinyjson::sax_handler_init(&h);
+    h.string = sax_string;
+    h.key = sax_key;
+    h.number = sax_number;
+    h.start_object = sax_start_object;
+    h.end_object = sax_end_object;
+    tinyjson::push_parser_init(&p, &h, &events);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "{\"ke"));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "y\":\"val"));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "ue\",\"n\":4"));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, push_feed(&p, "2}"));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::push_parser_finish(&p));
+    EXPECT_EQ_STRING("{ key: \"value\" n: 42 }2 ", events.c_str(), events.size());
+    tinyjson::push_parser_free(&p);
+}
+
 static void test_parse() {
     test_parse_null();
     test_parse_true();
     test_parse_false();
     test_parse_number();
+    test_parse_number_random();
     test_parse_string();
     test_parse_array();
     test_parse_object();
+    test_parse_length();
+    test_parse_arena();
+    test_parse_string_view();
+    test_parse_in_place();
+    test_parse_key_table();
+    test_parse_ndjson();
+    test_parse_parallel();
+    test_parse_file();
+    test_parse_long_string();
+    test_parse_sax();
+    test_parse_push();
+    test_parse_depth();
 
     test_parse_expect_value();
     test_parse_invalid_value();
@@ -603,13 +1797,158 @@ static void test_parse() {
     test_parse_miss_comma_or_curly_bracket();
 }
 
+// 查找pointer指向的节点，返回其生成的结果；不存在时返回"(none)"
+static std::string pointer_result(const tinyjson::value* v, const char* s) {
+    const tinyjson::value* e = tinyjson::pointer_get(v, s, strlen(s));
+    if (e == nullptr) {
+        return "(none)";
+    }
+    size_t len;
+    char* out = tinyjson::stringify(e, &len);
+    std::string ret(out, len);
+    free(out);
+    return ret;
+}
+
+static void test_access_pointer() {
+    /* RFC 6901第5节的例子 */
+    const char json[] = "{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,\"i\\\\j\":5,"
+                        "\"k\\\"l\":6,\" \":7,\"m~n\":8}";
+    tinyjson::value v, w;
+    tinyjson::pointer p;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&w);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, sizeof(json) - 1));
+    EXPECT_TRUE(tinyjson::pointer_get(&v, "", 0) == &v);
+    EXPECT_TRUE(pointer_result(&v, "/foo") == "[\"bar\",\"baz\"]");
+    EXPECT_TRUE(pointer_result(&v, "/foo/0") == "\"bar\"");
+    EXPECT_TRUE(pointer_result(&v, "/") == "0");
+    EXPECT_TRUE(pointer_result(&v, "/a~1b") == "1");
+    EXPECT_TRUE(pointer_result(&v, "/c%d") == "2");
+    EXPECT_TRUE(pointer_result(&v, "/e^f") == "3");
+    EXPECT_TRUE(pointer_result(&v, "/g|h") == "4");
+    EXPECT_TRUE(pointer_result(&v, "/i\\j") == "5");
+    EXPECT_TRUE(pointer_result(&v, "/k\"l") == "6");
+    EXPECT_TRUE(pointer_result(&v, "/ ") == "7");
+    EXPECT_TRUE(pointer_result(&v, "/m~0n") == "8");
+    /* 不存在的路径、不合法的下标和pointer */
+    EXPECT_TRUE(pointer_result(&v, "/foo/2") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/foo/-") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/foo/01") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/foo/+1") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/foo/99999999999999999999999") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/foo/0/x") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/a~1b/0") == "(none)");
+    EXPECT_TRUE(pointer_result(&v, "/m~n") == "(none)");
+    EXPECT_EQ_INT(tinyjson::POINTER_INVALID, tinyjson::pointer_compile(&p, "foo", 3));
+    EXPECT_EQ_INT(tinyjson::POINTER_INVALID, tinyjson::pointer_compile(&p, "/m~2n", 5));
+    EXPECT_EQ_INT(tinyjson::POINTER_INVALID, tinyjson::pointer_compile(&p, "/m~", 3));
+    EXPECT_TRUE(p.tokens == nullptr && p.count == 0);
+
+    /* 编译后的token */
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/a~01/~1/7/-//0", 15));
+    EXPECT_EQ_SIZE_T(6, p.count);
+    EXPECT_EQ_STRING("a~1", p.tokens[0].key, p.tokens[0].len);
+    EXPECT_EQ_STRING("/", p.tokens[1].key, p.tokens[1].len);
+    EXPECT_EQ_SIZE_T(tinyjson::POINTER_NO_INDEX, p.tokens[1].index);
+    EXPECT_EQ_SIZE_T(7, p.tokens[2].index);
+    EXPECT_EQ_SIZE_T(tinyjson::POINTER_END_INDEX, p.tokens[3].index);
+    EXPECT_EQ_SIZE_T(0, p.tokens[4].len);
+    EXPECT_EQ_SIZE_T(tinyjson::POINTER_NO_INDEX, p.tokens[4].index);
+    EXPECT_EQ_SIZE_T(0, p.tokens[5].index);
+    tinyjson::pointer_free(&p);
+
+    /* 同一个pointer查找多个文档，包括有哈希索引的object */
+    std::string big = "{";
+    for (int i = 0; i < 40; i++) {
+        big += (i == 0 ? "\"k" : ",\"k") + std::to_string(i) + "\":{\"a\":[" + std::to_string(i) + "]}";
+    }
+    big += "}";
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&w, big.c_str(), big.size()));
+    for (int i = 0; i < 40; i++) {
+        std::string s = "/k" + std::to_string(i) + "/a/0";
+        EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, s.c_str(), s.size()));
+        EXPECT_EQ_DOUBLE((double)i, tinyjson::get_number(tinyjson::pointer_get(&w, &p)));
+        EXPECT_TRUE(tinyjson::pointer_get(&v, &p) == nullptr);
+        tinyjson::pointer_free(&p);
+    }
+    tinyjson::cvalue cv;
+    tinyjson::compact(&cv, &w);
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/k39/a/0", 8));
+    EXPECT_EQ_DOUBLE(39.0, tinyjson::get_number(tinyjson::pointer_get(&cv, &p)));
+    tinyjson::pointer_free(&p);
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/k39/a/1", 8));
+    EXPECT_TRUE(tinyjson::pointer_get(&cv, &p) == nullptr);
+    tinyjson::pointer_free(&p);
+    tinyjson::tiny_free(&cv);
+
+    /* 修改、插入和删除：父节点必须存在，array的下标不能超过大小 */
+    const char* edits[][3] = {
+        {"s", "/k0/a/0", "[1]"},
+        {"s", "/k0/a/1", "[1,2]"},
+        {"s", "/k0/a/-", "[1,2,3]"},
+        {"i", "/k0/a/0", "[4,1,2,3]"},
+        {"i", "/k0/a/-", "[4,1,2,3,5]"},
+        {"r", "/k0/a/1", "[4,2,3,5]"},
+        {"s", "/k0/a/5", nullptr},
+        {"i", "/k0/a/5", nullptr},
+        {"s", "/k0/x/0", nullptr},
+        {"s", "/k0/a/x", nullptr},
+        {"r", "/k0/a/4", nullptr},
+        {"r", "/k0/a/-", nullptr},
+    };
+    for (size_t i = 0; i < sizeof(edits) / sizeof(edits[0]); i++) {
+        EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, edits[i][1], strlen(edits[i][1])));
+        if (edits[i][0][0] == 'r') {
+            int expect_ret = edits[i][2] != nullptr ? tinyjson::POINTER_OK : tinyjson::POINTER_NOT_FOUND;
+            EXPECT_EQ_INT(expect_ret, tinyjson::pointer_remove(&w, &p));
+        } else {
+            tinyjson::value* e =
+                edits[i][0][0] == 's' ? tinyjson::pointer_set(&w, &p) : tinyjson::pointer_insert(&w, &p);
+            EXPECT_TRUE((e != nullptr) == (edits[i][2] != nullptr));
+            if (e != nullptr) {
+                tinyjson::set_number(e, (double)(i + 1));
+            }
+        }
+        tinyjson::pointer_free(&p);
+        if (edits[i][2] != nullptr) {
+            EXPECT_TRUE(pointer_result(&w, "/k0/a") == edits[i][2]);
+        }
+    }
+    EXPECT_TRUE(pointer_result(&w, "/k0/a") == "[4,2,3,5]");
+    /* object：已有的键返回原来的节点，没有的键新增，有哈希索引时同样能找到新增和删除后的成员 */
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/k1", 3));
+    EXPECT_TRUE(tinyjson::pointer_set(&w, &p) == tinyjson::find_object_value(&w, "k1", 2));
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_remove(&w, &p));
+    EXPECT_TRUE(tinyjson::pointer_get(&w, &p) == nullptr);
+    EXPECT_EQ_INT(tinyjson::POINTER_NOT_FOUND, tinyjson::pointer_remove(&w, &p));
+    tinyjson::pointer_free(&p);
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/k40", 4));
+    tinyjson::set_boolean(tinyjson::pointer_insert(&w, &p), 1);
+    tinyjson::pointer_free(&p);
+    EXPECT_TRUE(pointer_result(&w, "/k40") == "true");
+    EXPECT_TRUE(pointer_result(&w, "/k39/a") == "[39]");
+    EXPECT_EQ_SIZE_T(40, tinyjson::get_object_size(&w));
+    EXPECT_TRUE(pointer_result(&w, "/k2/a") == "[2]");
+    /* 空pointer指向整个文档，不能删除 */
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "", 0));
+    EXPECT_TRUE(tinyjson::pointer_set(&w, &p) == &w);
+    EXPECT_EQ_INT(tinyjson::POINTER_NOT_FOUND, tinyjson::pointer_remove(&w, &p));
+    tinyjson::pointer_free(&p);
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&w);
+}
+
 static void test_access() {
     test_access_null();
     test_access_string();
+    test_access_string_inline();
     test_access_boolean();
     test_access_number();
     test_access_array();
     test_access_object();
+    test_access_object_index();
+    test_access_pointer();
 }
 
 static void test_stringify_number() {
@@ -624,15 +1963,61 @@ static void test_stringify_number() {
     TEST_ROUNDTRIP("1.234e+20");
     TEST_ROUNDTRIP("1.234e-20");
 
-    TEST_ROUNDTRIP("1.0000000000000002");      /* the smallest number > 1 */
-    TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-    TEST_ROUNDTRIP("2.2250738585072009e-308"); /* Max subnormal double */
-    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
+    TEST_ROUNDTRIP("5e-324");             /* minimum denormal */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308"); /* Max subnormal double */
+    TEST_ROUNDTRIP("-2.225073858507201e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308"); /* Min normal positive double */
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308"); /* Max double */
     TEST_ROUNDTRIP("-1.7976931348623157e+308");
+
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("0.001234");
+    TEST_ROUNDTRIP("0.0001");
+    TEST_ROUNDTRIP("1e-05");
+    TEST_ROUNDTRIP("123.456");
+    TEST_ROUNDTRIP("9007199254740991");
+    TEST_ROUNDTRIP("9007199254740992");
+    TEST_ROUNDTRIP("10000000000000000");
+    TEST_ROUNDTRIP("12345678901234568");
+    TEST_ROUNDTRIP("1.2345678901234568e+17");
+    TEST_ROUNDTRIP("1e+100");
+
+    /* 输出能还原出同一个double的最短表示 */
+    TEST_STRINGIFY("0.1", "0.10000000000000001");
+    TEST_STRINGIFY("5e-324", "4.9406564584124654e-324");
+    TEST_STRINGIFY("0.30000000000000004", "0.30000000000000004");
+    TEST_STRINGIFY("100", "1e2");
+    TEST_STRINGIFY("-0", "-0.0");
+    TEST_STRINGIFY("1e+21", "1000000000000000000000");
+}
+
+// 随机生成double的二进制位，检查生成的字符串能还原出同一个double
+static void test_stringify_number_random() {
+    unsigned long long seed = 20221230;
+    for (int i = 0; i < 20000; ++i) {
+        unsigned long long bits;
+        double d;
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        bits = seed;
+        memcpy(&d, &bits, sizeof(d));
+        if (d != d || d == HUGE_VAL || d == -HUGE_VAL) {
+            continue;
+        }
+        tinyjson::value v;
+        size_t length;
+        char* json;
+        tinyjson::tiny_init(&v);
+        tinyjson::set_number(&v, d);
+        json = tinyjson::stringify(&v, &length);
+        EXPECT_TRUE(length <= 24);
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, length));
+        EXPECT_TRUE(memcmp(&d, &v.u.n, sizeof(d)) == 0);
+        tinyjson::tiny_free(&v);
+        free(json);
+    }
 }
 
 static void test_stringify_string() {
@@ -641,6 +2026,23 @@ static void test_stringify_string() {
     TEST_ROUNDTRIP("\"Hello\\nWorld\"");
     TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
     TEST_ROUNDTRIP("\"Hello\\u0000World\"");
+    TEST_ROUNDTRIP("\"\\u0001\\u000B\\u0010\\u001F\\u001Fx\\u001F\"");
+
+    /* 需要转义的字符落在向量化扫描的块内、块边界上以及结尾不足一块的部分 */
+    std::string json = "\"";
+    for (int i = 0; i < 300; i++) {
+        json += i % 17 == 0 ? "\\\"" : i % 31 == 0 ? "\\u0002" : i % 45 == 0 ? "\\t\\\\" : "a";
+    }
+    json += "\"";
+    tinyjson::value v;
+    size_t len;
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size()));
+    char* out = tinyjson::stringify(&v, &len);
+    EXPECT_TRUE(json == std::string(out, len));
+    expect_stringify_into(&v, out, len);
+    free(out);
+    tinyjson::tiny_free(&v);
 }
 
 static void test_stringify_array() {
@@ -652,6 +2054,228 @@ static void test_stringify_object() {
     TEST_ROUNDTRIP("{}");
     TEST_ROUNDTRIP(
         "{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+    TEST_ROUNDTRIP("{\"a\":1,\"bcd\":2,\"\":3,\"efghij\":4}");
+}
+
+static int string_sink(void* user, const char* data, size_t len) {
+    ((std::string*)user)->append(data, len);
+    return 0;
+}
+
+static int failing_sink(void* user, const char*, size_t) {
+    ++*(int*)user;
+    return 1;
+}
+
+// 流式生成的结果与stringify相同，且不受缓冲区大小影响
+static void test_stringify_sink() {
+    tinyjson::value v;
+    std::string json = "[";
+    for (int i = 0; i < 200; i++) {
+        json += i == 0 ? "" : ",";
+        json += "{\"key" + std::to_string(i) + "\":\"va\\nlue\",\"n\":[1.5e+300,-0.125,null,true,false]}";
+    }
+    /* 比缓冲区更长的字符串分段转义 */
+    json += ",\"";
+    for (int i = 0; i < 3000; i++) {
+        json += i % 100 == 0 ? "\\u0001\\\"" : "x";
+    }
+    json += "\"";
+    json += "]";
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size()));
+    size_t len;
+    char* expect = tinyjson::stringify(&v, &len);
+    expect_stringify_into(&v, expect, len);
+    char buf[1000];
+    for (size_t size = tinyjson::STRINGIFY_MIN_BUFFER_SIZE; size <= sizeof(buf); size += 97) {
+        std::string out;
+        EXPECT_EQ_INT(tinyjson::STRINGIFY_OK, tinyjson::stringify(&v, buf, size, string_sink, &out));
+        EXPECT_TRUE(out.size() == len && memcmp(out.data(), expect, len) == 0);
+    }
+
+    /* sink失败后不再调用 */
+    int calls = 0;
+    EXPECT_EQ_INT(tinyjson::STRINGIFY_SINK_ERROR,
+                  tinyjson::stringify(&v, buf, tinyjson::STRINGIFY_MIN_BUFFER_SIZE, failing_sink, &calls));
+    EXPECT_EQ_INT(1, calls);
+
+    /* 写入文件再读回 */
+    FILE* fp = tmpfile();
+    EXPECT_TRUE(fp != NULL);
+    if (fp != NULL) {
+        EXPECT_EQ_INT(tinyjson::STRINGIFY_OK, tinyjson::stringify_file(&v, fp));
+        fflush(fp);
+        EXPECT_EQ_INT(tinyjson::STRINGIFY_OK, tinyjson::stringify_fd(&v, fileno(fp)));
+        std::string out(len * 2 + 1, '\0');
+        rewind(fp);
+        EXPECT_EQ_SIZE_T(len * 2, fread(&out[0], 1, len * 2 + 1, fp));
+        EXPECT_TRUE(memcmp(out.data(), expect, len) == 0 && memcmp(out.data() + len, expect, len) == 0);
+        fclose(fp);
+    }
+    free(expect);
+    tinyjson::tiny_free(&v);
+}
+
+// 按opt生成，流式生成的结果相同，解析结果与原值相等
+static void expect_stringify_pretty(const char* json, const tinyjson::stringify_options* opt, const char* expect) {
+    tinyjson::value v, v2;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&v2);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, strlen(json)));
+    size_t len;
+    char* out = tinyjson::stringify_format(&v, &len, opt);
+    EXPECT_TRUE(strlen(expect) == len && memcmp(expect, out, len) == 0);
+    char buf[tinyjson::STRINGIFY_MIN_BUFFER_SIZE];
+    std::string sunk;
+    EXPECT_EQ_INT(tinyjson::STRINGIFY_OK, tinyjson::stringify_format(&v, buf, sizeof(buf), string_sink, &sunk, opt));
+    EXPECT_TRUE(sunk.size() == len && memcmp(sunk.data(), out, len) == 0);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v2, out, len));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &v2));
+    free(out);
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&v2);
+}
+
+static void test_stringify_pretty() {
+    tinyjson::stringify_options opt;
+    tinyjson::stringify_options_init(&opt);
+    /* 默认选项与紧凑输出相同 */
+    expect_stringify_pretty("{\"b\":[1,{}],\"a\":[]}", &opt, "{\"b\":[1,{}],\"a\":[]}");
+    expect_stringify_pretty("{\"b\":[1,{}],\"a\":[]}", nullptr, "{\"b\":[1,{}],\"a\":[]}");
+    {
+        /* 头文件中写明的用法：opt直接传nullptr */
+        tinyjson::value v;
+        tinyjson::tiny_init(&v);
+        const char* json = "[1,{\"a\":null}]";
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, strlen(json)));
+        size_t len;
+        char* out = tinyjson::stringify_format(&v, &len, nullptr);
+        EXPECT_EQ_STRING("[1,{\"a\":null}]", out, len);
+        free(out);
+        char buf[tinyjson::STRINGIFY_MIN_BUFFER_SIZE];
+        std::string sunk;
+        EXPECT_EQ_INT(tinyjson::STRINGIFY_OK,
+                      tinyjson::stringify_format(&v, buf, sizeof(buf), string_sink, &sunk, nullptr));
+        EXPECT_TRUE(sunk == "[1,{\"a\":null}]");
+        tinyjson::tiny_free(&v);
+    }
+
+    opt.indent = 2;
+    expect_stringify_pretty("null", &opt, "null");
+    expect_stringify_pretty("[]", &opt, "[]");
+    expect_stringify_pretty("{}", &opt, "{}");
+    expect_stringify_pretty("[1]", &opt, "[\n  1\n]");
+    expect_stringify_pretty("{\"b\":[1,{}],\"a\":[]}", &opt,
+                            "{\n  \"b\": [\n    1,\n    {}\n  ],\n  \"a\": []\n}");
+    expect_stringify_pretty("[[[\"x\"]],{\"k\":{\"l\":null}}]", &opt,
+                            "[\n  [\n    [\n      \"x\"\n    ]\n  ],\n"
+                            "  {\n    \"k\": {\n      \"l\": null\n    }\n  }\n]");
+
+    /* tab缩进和CRLF换行 */
+    opt.indent = 1;
+    opt.indent_char = '\t';
+    opt.newline = "\r\n";
+    expect_stringify_pretty("{\"a\":[true,false]}", &opt, "{\r\n\t\"a\": [\r\n\t\ttrue,\r\n\t\tfalse\r\n\t]\r\n}");
+
+    /* 按键排序：字节序，前缀在前，相同的键保持原来的顺序，内层object各自排序 */
+    tinyjson::stringify_options_init(&opt);
+    opt.sort_keys = 1;
+    expect_stringify_pretty("{\"b\":1,\"ab\":2,\"a\":3,\"\\u00e9\":4,\"B\":5}", &opt,
+                            "{\"B\":5,\"a\":3,\"ab\":2,\"b\":1,\"\xc3\xa9\":4}");
+    tinyjson::value v;
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, "{\"b\":0,\"a\":1,\"b\":2,\"a\":3}", 25));
+    size_t len;
+    char* out = tinyjson::stringify_format(&v, &len, &opt);
+    EXPECT_EQ_STRING("{\"a\":1,\"a\":3,\"b\":0,\"b\":2}", out, len);
+    free(out);
+    tinyjson::tiny_free(&v);
+    expect_stringify_pretty("[{\"z\":{\"y\":1,\"x\":[{\"d\":0,\"c\":0}]},\"w\":2},{\"v\":0,\"u\":0}]", &opt,
+                            "[{\"w\":2,\"z\":{\"x\":[{\"c\":0,\"d\":0}],\"y\":1}},{\"u\":0,\"v\":0}]");
+    opt.indent = 1;
+    expect_stringify_pretty("{\"b\":{\"d\":1,\"c\":2},\"a\":0}", &opt,
+                            "{\n \"a\": 0,\n \"b\": {\n  \"c\": 2,\n  \"d\": 1\n }\n}");
+
+    /* 深层嵌套的缩进超过流式生成的缓冲区 */
+    std::string json, expect;
+    for (int i = 0; i < 50; i++) {
+        json += "[";
+        expect += std::string(i == 0 ? "" : "\n") + std::string(i * 4, ' ') + "[";
+    }
+    expect += "\n" + std::string(50 * 4, ' ') + "0";
+    json += "0";
+    for (int i = 49; i >= 0; i--) {
+        json += "]";
+        expect += "\n" + std::string(i * 4, ' ') + "]";
+    }
+    opt.indent = 4;
+    opt.sort_keys = 0;
+    expect_stringify_pretty(json.c_str(), &opt, expect.c_str());
+}
+
+// 复用scratch：结果与不复用时相同，稳定后不再重新分配，保留的内存不超过retain
+static void test_scratch() {
+    tinyjson::value v, v2;
+    std::string json = "[";
+    for (int i = 0; i < 100; i++) {
+        json += i == 0 ? "" : ",";
+        json += "{\"k\\u00e9y" + std::to_string(i) + "\":[\"a\\tb\",[[" + std::to_string(i) + "]]]}";
+    }
+    json += "]";
+    tinyjson::scratch s;
+    tinyjson::scratch_init(&s, tinyjson::SCRATCH_RETAIN_UNLIMITED);
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.work = &s;
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&v2);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size(), &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v2, json.c_str(), json.size()));
+    EXPECT_TRUE(tinyjson::is_equal(&v, &v2));
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&v2);
+    EXPECT_TRUE(s.stack != nullptr);
+    char* stack = s.stack;
+    size_t size = s.size;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json.c_str(), json.size(), &opt));
+    EXPECT_TRUE(stack == s.stack && size == s.size);
+    tinyjson::sax_handler h;
+    tinyjson::sax_handler_init(&h);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::sax_parse(json.c_str(), json.size(), &h, nullptr, &opt));
+    EXPECT_TRUE(stack == s.stack && size == s.size);
+    /* 出错时堆栈同样交还 */
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_SQUARE_BRACKET, tinyjson::parse(&v2, "[\"abc\"}", 7, &opt));
+    EXPECT_TRUE(stack == s.stack && size == s.size);
+
+    size_t len, expect_len;
+    char* expect = tinyjson::stringify(&v, &expect_len);
+    const char* out = tinyjson::stringify(&v, &len, &s);
+    EXPECT_TRUE(len == expect_len && memcmp(out, expect, len + 1) == 0);
+    out = tinyjson::stringify(&v, &len, &s);
+    EXPECT_TRUE(out == s.stack && len == expect_len && memcmp(out, expect, len + 1) == 0);
+    stack = s.stack;
+    out = tinyjson::stringify(&v, &len, &s);
+    EXPECT_TRUE(out == stack);
+    free(expect);
+
+    /* 限制保留的内存 */
+    s.retain = 100;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v2, json.c_str(), json.size(), &opt));
+    EXPECT_TRUE(s.size <= 100);
+    EXPECT_TRUE(tinyjson::is_equal(&v, &v2));
+    out = tinyjson::stringify(&v2, &len, &s);
+    EXPECT_EQ_SIZE_T(expect_len, len);
+    tinyjson::scratch_trim(&s, 100);
+    EXPECT_TRUE(s.size <= 100 && s.frames_size <= 100);
+    tinyjson::scratch_free(&s);
+    EXPECT_TRUE(s.stack == nullptr && s.size == 0 && s.frames == nullptr && s.frames_size == 0);
+    /* 释放后仍然可以使用 */
+    out = tinyjson::stringify(&v2, &len, &s);
+    EXPECT_EQ_SIZE_T(expect_len, len);
+    tinyjson::scratch_free(&s);
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&v2);
 }
 
 static void test_stringify() {
@@ -659,9 +2283,12 @@ static void test_stringify() {
     TEST_ROUNDTRIP("false");
     TEST_ROUNDTRIP("true");
     test_stringify_number();
+    test_stringify_number_random();
     test_stringify_string();
     test_stringify_array();
     test_stringify_object();
+    test_stringify_sink();
+    test_stringify_pretty();
 }
 
 static void test_equal() {
@@ -729,17 +2356,234 @@ static void test_swap() {
     tinyjson::tiny_free(&v2);
 }
 
+// 紧凑DOM：与value的内容相同，但每个节点只有16字节
+static void test_compact() {
+    const char json[] = "{\"n\":null,\"f\":false,\"t\":true,\"num\":-1.5e-10,\"short\":\"0123456789abcd\","
+                        "\"long\":\"0123456789abcde\",\"nul\":\"a\\u0000b\",\"a\":[1,[],{},[\"x\"]],"
+                        "\"a key longer than inline\":{\"k\":\"v\"}}";
+    tinyjson::value v;
+    tinyjson::cvalue cv, cv2;
+    const tinyjson::cvalue* e;
+    EXPECT_EQ_SIZE_T(16, sizeof(tinyjson::cvalue));
+    tinyjson::tiny_init(&v);
+    tinyjson::tiny_init(&cv2);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv, json, sizeof(json) - 1));
+    EXPECT_EQ_INT(tinyjson::OBJECT, tinyjson::get_type(&cv));
+    EXPECT_EQ_SIZE_T(9, tinyjson::get_object_size(&cv));
+    EXPECT_EQ_STRING("n", tinyjson::get_object_key(&cv, 0), tinyjson::get_object_key_length(&cv, 0));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(tinyjson::get_object_value(&cv, 0)));
+    EXPECT_EQ_INT(0, tinyjson::get_boolean(tinyjson::get_object_value(&cv, 1)));
+    EXPECT_EQ_INT(1, tinyjson::get_boolean(tinyjson::get_object_value(&cv, 2)));
+    EXPECT_EQ_DOUBLE(-1.5e-10, tinyjson::get_number(tinyjson::find_object_value(&cv, "num", 3)));
+    /* 14字节的字符串存放在节点内，15字节的放在堆上 */
+    e = tinyjson::find_object_value(&cv, "short", 5);
+    EXPECT_EQ_STRING("0123456789abcd", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    EXPECT_TRUE(tinyjson::get_string(e) == (const char*)e);
+    e = tinyjson::find_object_value(&cv, "long", 4);
+    EXPECT_EQ_STRING("0123456789abcde", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    EXPECT_EQ_INT('\0', tinyjson::get_string(e)[15]);
+    e = tinyjson::find_object_value(&cv, "nul", 3);
+    EXPECT_EQ_STRING("a\0b", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    e = tinyjson::find_object_value(&cv, "a", 1);
+    EXPECT_EQ_SIZE_T(4, tinyjson::get_array_size(e));
+    EXPECT_EQ_DOUBLE(1.0, tinyjson::get_number(tinyjson::get_array_element(e, 0)));
+    EXPECT_EQ_SIZE_T(0, tinyjson::get_array_size(tinyjson::get_array_element(e, 1)));
+    EXPECT_EQ_SIZE_T(0, tinyjson::get_object_size(tinyjson::get_array_element(e, 2)));
+    e = tinyjson::get_array_element(tinyjson::get_array_element(e, 3), 0);
+    EXPECT_EQ_STRING("x", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    e = tinyjson::find_object_value(&cv, "a key longer than inline", 24);
+    EXPECT_EQ_STRING("v", tinyjson::get_string(tinyjson::find_object_value(e, "k", 1)), 1);
+    EXPECT_TRUE(tinyjson::find_object_value(&cv, "k", 1) == nullptr);
+    EXPECT_EQ_SIZE_T(tinyjson::KEY_NOT_EXIST, tinyjson::find_object_index(&cv, "missing", 7));
+
+    /* 从value转换得到相同的结果，生成的JSON与value相同 */
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, json, sizeof(json) - 1));
+    tinyjson::compact(&cv2, &v);
+    EXPECT_TRUE(tinyjson::is_equal(&cv, &cv2));
+    size_t len, clen;
+    char* expect = tinyjson::stringify(&v, &len);
+    char* actual = tinyjson::stringify(&cv, &clen);
+    EXPECT_TRUE(len == clen && memcmp(expect, actual, len + 1) == 0);
+    free(expect);
+    free(actual);
+    tinyjson::set_number(tinyjson::get_array_element(tinyjson::find_object_value(&v, "a", 1), 0), 2.0);
+    tinyjson::compact(&cv2, &v);
+    EXPECT_FALSE(tinyjson::is_equal(&cv, &cv2));
+    tinyjson::set_string(&v, "s", 1);
+    tinyjson::compact(&cv2, &v);
+    EXPECT_EQ_STRING("s", tinyjson::get_string(&cv2), tinyjson::get_string_len(&cv2));
+    tinyjson::tiny_free(&v);
+
+    /* 成员顺序不同的object相等 */
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv2, "{\"b\":[1,{}],\"a\":\"long string value\"}", 36));
+    tinyjson::tiny_free(&cv);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv, "{\"a\":\"long string value\",\"b\":[1,{}]}", 36));
+    EXPECT_TRUE(tinyjson::is_equal(&cv, &cv2));
+    tinyjson::tiny_free(&cv);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv, "{\"a\":\"long string value\",\"c\":[1,{}]}", 36));
+    EXPECT_FALSE(tinyjson::is_equal(&cv, &cv2));
+    tinyjson::tiny_free(&cv);
+    tinyjson::tiny_free(&cv2);
+
+    /* 释放、比较和生成都不使用递归 */
+    const size_t depth = 1000000;
+    std::string deep(depth, '[');
+    deep.append(depth, ']');
+    tinyjson::parse_options opt;
+    tinyjson::parse_options_init(&opt);
+    opt.max_depth = (size_t)-1;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv, deep.c_str(), deep.size(), &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&cv2, deep.c_str(), deep.size(), &opt));
+    EXPECT_TRUE(tinyjson::is_equal(&cv, &cv2));
+    actual = tinyjson::stringify(&cv, &len);
+    EXPECT_TRUE(len == deep.size() && memcmp(actual, deep.c_str(), len) == 0);
+    free(actual);
+    tinyjson::tiny_free(&cv);
+    tinyjson::tiny_free(&cv2);
+    EXPECT_EQ_INT(tinyjson::PARSE_TOO_DEEP, tinyjson::parse(&cv, deep.c_str(), deep.size()));
+}
+
+// 惰性DOM逐个节点与value比较，object按下标和按键都访问一次
+static bool lazy_equal(const tinyjson::lvalue* l, const tinyjson::value* v) {
+    if (tinyjson::get_type(l) != tinyjson::get_type(v)) {
+        return false;
+    }
+    switch (tinyjson::get_type(v)) {
+    case tinyjson::NUMBER:
+        return tinyjson::get_number(l) == tinyjson::get_number(v);
+    case tinyjson::STRING:
+        return tinyjson::get_string_len(l) == tinyjson::get_string_len(v) &&
+               memcmp(tinyjson::get_string(l), tinyjson::get_string(v), tinyjson::get_string_len(v)) == 0;
+    case tinyjson::ARRAY:
+        if (tinyjson::get_array_size(l) != tinyjson::get_array_size(v)) {
+            return false;
+        }
+        for (size_t i = 0; i < tinyjson::get_array_size(v); i++) {
+            if (!lazy_equal(tinyjson::get_array_element(l, i), tinyjson::get_array_element(v, i))) {
+                return false;
+            }
+        }
+        return true;
+    case tinyjson::OBJECT:
+        if (tinyjson::get_object_size(l) != tinyjson::get_object_size(v)) {
+            return false;
+        }
+        for (size_t i = 0; i < tinyjson::get_object_size(v); i++) {
+            const char* key = tinyjson::get_object_key(v, i);
+            size_t klen = tinyjson::get_object_key_length(v, i);
+            if (tinyjson::get_object_key_length(l, i) != klen ||
+                memcmp(tinyjson::get_object_key(l, i), key, klen) != 0 ||
+                tinyjson::find_object_index(l, key, klen) != tinyjson::find_object_index(v, key, klen) ||
+                !lazy_equal(tinyjson::get_object_value(l, i), tinyjson::get_object_value(v, i))) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+static void test_lazy() {
+    const char json[] = "{\"n\":null,\"f\":false,\"t\":true,\"num\":-1.5e-10,\"s\":\"plain\",\"esc\":\"a\\u0000b\\n\","
+                        "\"a\":[1,[],{},[\"x\"],{\"k\":[2,{\"l\":3}]}],\"k\\u00e9y\":{\"k\":\"v\"},\"e\":{}}";
+    tinyjson::lazy_doc d;
+    const tinyjson::lvalue* root;
+    const tinyjson::lvalue* e;
+    tinyjson::tiny_init(&d);
+    EXPECT_TRUE(tinyjson::lazy_root(&d) == nullptr);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&d, json, sizeof(json) - 1));
+    root = tinyjson::lazy_root(&d);
+    EXPECT_TRUE(root == d.nodes);
+    EXPECT_EQ_INT(tinyjson::OBJECT, tinyjson::get_type(root));
+    EXPECT_EQ_SIZE_T(9, tinyjson::get_object_size(root));
+    /* 按键查找不建立子节点表，不含转义的字符串直接引用输入 */
+    EXPECT_EQ_DOUBLE(-1.5e-10, tinyjson::get_number(tinyjson::find_object_value(root, "num", 3)));
+    e = tinyjson::find_object_value(root, "s", 1);
+    EXPECT_EQ_STRING("plain", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    EXPECT_TRUE(tinyjson::get_string(e) > json && tinyjson::get_string(e) < json + sizeof(json));
+    e = tinyjson::find_object_value(root, "esc", 3);
+    EXPECT_EQ_STRING("a\0b\n", tinyjson::get_string(e), tinyjson::get_string_len(e));
+    EXPECT_EQ_INT('\0', tinyjson::get_string(e)[4]);
+    EXPECT_TRUE(tinyjson::get_string(e) == tinyjson::get_string(e));
+    e = tinyjson::find_object_value(root, "k\xc3\xa9y", 4);
+    EXPECT_TRUE(e != nullptr && tinyjson::get_object_size(e) == 1);
+    EXPECT_TRUE(tinyjson::find_object_value(root, "missing", 7) == nullptr);
+    EXPECT_EQ_SIZE_T(tinyjson::KEY_NOT_EXIST, tinyjson::find_object_index(root, "ke", 2));
+    EXPECT_EQ_INT(tinyjson::TINYNULL, tinyjson::get_type(tinyjson::get_object_value(root, 0)));
+    EXPECT_EQ_INT(0, tinyjson::get_boolean(tinyjson::get_object_value(root, 1)));
+    EXPECT_EQ_INT(1, tinyjson::get_boolean(tinyjson::get_object_value(root, 2)));
+    EXPECT_EQ_STRING("e", tinyjson::get_object_key(root, 8), tinyjson::get_object_key_length(root, 8));
+    EXPECT_EQ_SIZE_T(0, tinyjson::get_object_size(tinyjson::get_object_value(root, 8)));
+    /* 跳过子树 */
+    e = tinyjson::find_object_value(root, "a", 1);
+    EXPECT_EQ_SIZE_T(5, tinyjson::get_array_size(e));
+    EXPECT_EQ_SIZE_T(0, tinyjson::get_array_size(tinyjson::get_array_element(e, 1)));
+    EXPECT_EQ_SIZE_T(0, tinyjson::get_object_size(tinyjson::get_array_element(e, 2)));
+    tinyjson::pointer p;
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/a/4/k/1/l", 10));
+    EXPECT_EQ_DOUBLE(3.0, tinyjson::get_number(tinyjson::pointer_get(root, &p)));
+    tinyjson::pointer_free(&p);
+    EXPECT_EQ_INT(tinyjson::POINTER_OK, tinyjson::pointer_compile(&p, "/a/5", 4));
+    EXPECT_TRUE(tinyjson::pointer_get(root, &p) == nullptr);
+    tinyjson::pointer_free(&p);
+    /* 子树的生成结果 */
+    size_t len;
+    char* out = tinyjson::stringify(e, &len);
+    EXPECT_EQ_STRING("[1,[],{},[\"x\"],{\"k\":[2,{\"l\":3}]}]", out, len);
+    free(out);
+
+    /* 与完整解析的结果逐个节点比较，重新解析时复用索引 */
+    std::string big = "[";
+    for (int i = 0; i < 300; i++) {
+        big += i == 0 ? "" : ",";
+        big += "{\"id\":" + std::to_string(i) + ",\"name\":\"n\\u00e9" + std::to_string(i) +
+               "\",\"tags\":[\"a\",\"b\\\"\",[]],\"nested\":{\"x\":[1.5,true,null],\"y\":{}}}";
+    }
+    big += "]";
+    tinyjson::value v;
+    tinyjson::tiny_init(&v);
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&v, big.c_str(), big.size()));
+    for (int round = 0; round < 2; round++) {
+        EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&d, big.c_str(), big.size()));
+        EXPECT_TRUE(lazy_equal(tinyjson::lazy_root(&d), &v));
+        EXPECT_TRUE(lazy_equal(tinyjson::lazy_root(&d), &v));
+        EXPECT_EQ_SIZE_T(300 * 19 + 1, d.size);
+    }
+    tinyjson::lvalue* nodes = d.nodes;
+    EXPECT_EQ_INT(tinyjson::PARSE_MISS_COMMA_OR_SQUARE_BRACKET, tinyjson::parse(&d, "[1}", 3));
+    EXPECT_TRUE(tinyjson::lazy_root(&d) == nullptr && d.nodes == nodes);
+
+    /* 使用scratch和max_depth */
+    tinyjson::scratch s;
+    tinyjson::parse_options opt;
+    tinyjson::scratch_init(&s, tinyjson::SCRATCH_RETAIN_UNLIMITED);
+    tinyjson::parse_options_init(&opt);
+    opt.work = &s;
+    opt.max_depth = 2;
+    EXPECT_EQ_INT(tinyjson::PARSE_OK, tinyjson::parse(&d, "[[\"\\t\"]]", 8, &opt));
+    EXPECT_EQ_INT(tinyjson::PARSE_TOO_DEEP, tinyjson::parse(&d, "[[[]]]", 6, &opt));
+    EXPECT_TRUE(s.stack != nullptr);
+    tinyjson::scratch_free(&s);
+    tinyjson::tiny_free(&v);
+    tinyjson::tiny_free(&d);
+    EXPECT_TRUE(d.nodes == nullptr && d.size == 0 && d.capacity == 0);
+}
+
 int main() {
 #ifdef _WINDOWS
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
     test_parse();
     test_access();
+    test_scratch();
     test_stringify();
     test_equal();
     test_copy();
     test_move();
     test_swap();
+    test_compact();
+    test_lazy();
 
     printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
     return main_ret;
@@ -12,21 +12,89 @@
 
 #include "tinyjson.h"
 
-#include <asm-generic/errno-base.h>
 #include <assert.h>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <errno.h>
 #include <iostream>
+#include <mutex>
+#include <thread>
+
+// x86-64上SSE2总是可用的；AVX2在运行时检测，只需要编译器支持target属性
+#if !defined(TINYJSON_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__))
+#define TINYJSON_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define TINYJSON_AVX2
+#include <immintrin.h>
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace tinyjson {
+// value::tiny_flags的取值
+enum {
+    VALUE_FLAG_ARENA = 1 << 0,   // 节点自身及其子节点的内存都来自arena，tiny_free时不逐个释放
+    VALUE_FLAG_VIEW = 1 << 1,    // 字符串直接引用输入缓冲区，不拥有这块内存
+    VALUE_FLAG_INDEXED = 1 << 2, // object的成员数组之后紧跟着哈希索引
+    VALUE_FLAG_INLINE = 1 << 3,  // 字符串存放在u.ss中，长度存放在INLINE_LEN_SHIFT以上的位
+};
+
+/* 键的标记是member::k的最后1字节，不另外占用空间
+ * 短键的标记为MEMBER_INLINE_KEY - 长度，最长的短键的标记同时就是结尾的'\0'
+ * 长键的标记最高位为1，低位为KEY_FLAG_*；这个字节与k.p.len的最高字节（小端）或最低字节（大端）重合，长度存放在其余的位中
+ */
+enum {
+    KEY_TAG_LONG = 1 << 7,    // k.p中的键
+    KEY_FLAG_VIEW = 1 << 0,   // 键直接引用输入缓冲区，不拥有这块内存
+    KEY_FLAG_SHARED = 1 << 1, // 键属于key_table，不拥有这块内存
+};
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const int KEY_LEN_SHIFT = 8;
+#else
+const int KEY_LEN_SHIFT = 0;
+#endif
+const size_t KEY_LEN_MAX = ~(size_t)0 >> 8;
+
+const int INLINE_LEN_SHIFT = 8;
+
+struct arena_block {
+    arena_block* next;
+    size_t size;
+};
+
+const size_t ARENA_MIN_BLOCK_SIZE = 4096;
+
 typedef struct {
     const char* json;
+    const char* end; // 输入的结束位置，解析过程不再依赖'\0'作为结束标志
     char* stack;
     size_t size, top;
+    arena* pool;         // 非空时解析结果从这里分配内存
+    unsigned int flags;  // PARSE_FLAG_*
+    size_t max_depth;    // array/object的最大嵌套层数
+    key_table* keys;     // 非空时长键从这里驻留
+    stringify_sink sink; // 非空时stack是调用者提供的固定缓冲区，写满时交给sink而不是realloc
+    void* user;
+    int status;                     // 流式生成的结果，STRINGIFY_*
+    const stringify_options* format; // 非空时按其中的设置缩进、换行和排序键
 } context;
 
 inline void EXPECT(context* c, char ch) {
@@ -34,6 +102,24 @@ inline void EXPECT(context* c, char ch) {
     ++c->json;
 }
 
+// 读取当前字符，到达输入末尾时返回'\0'
+inline char PEEK(const context* c) { return c->json != c->end ? *c->json : '\0'; }
+
+// arena中的树是只读的，不能调用会realloc/free其内存的函数
+inline void ASSERT_MUTABLE(const value* v) { assert(!(v->tiny_flags & VALUE_FLAG_ARENA)); }
+
+// 返回最低位的1所在的位置，x不能为0
+inline int CTZ(unsigned int x) {
+    assert(x != 0);
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
 inline bool ISDIGIT(char ch) { return ch >= '0' && ch <= '9'; }
 
 inline bool ISDIGIT1TO9(char ch) { return ch >= '1' && ch <= '9'; }
@@ -42,10 +128,24 @@ inline bool ISALPHA_ATOF(char ch) { return ch >= 'A' && ch <= 'F'; }
 
 inline bool ISALPHA_aTOf(char ch) { return ch >= 'a' && ch <= 'f'; }
 
+// 把缓冲区中的内容交给sink，sink失败后丢弃之后的所有输出
+static void context_flush(context* c) {
+    if (c->top > 0 && c->status == STRINGIFY_OK && c->sink(c->user, c->stack, c->top) != 0) {
+        c->status = STRINGIFY_SINK_ERROR;
+    }
+    c->top = 0;
+}
+
 static void* context_push(context* c, size_t size) {
     void* ret;
     assert(size > 0);
     if (c->top + size >= c->size) {
+        if (c->sink) {
+            context_flush(c);
+            assert(size < c->size);
+            c->top = size;
+            return c->stack;
+        }
         if (c->size == 0) {
             c->size = PARSE_STACK_INIT_SIZE;
         }
@@ -64,39 +164,449 @@ static void* context_pop(context* c, size_t size) {
     return c->stack + (c->top -= size);
 }
 
+// 以默认设置初始化context，解析的输入为[json, json + len)
+static void context_init(context* c, const char* json, size_t len) {
+    c->json = json;
+    c->end = json + len;
+    c->stack = nullptr;
+    c->size = c->top = 0;
+    c->pool = nullptr;
+    c->flags = PARSE_FLAG_DEFAULT;
+    c->max_depth = PARSE_MAX_DEPTH;
+    c->keys = nullptr;
+    c->sink = nullptr;
+    c->user = nullptr;
+    c->status = STRINGIFY_OK;
+    c->format = nullptr;
+}
+
+// 把一块可复用的内存收缩到retain以内
+static void shrink_buffer(char** buf, size_t* size, size_t retain) {
+    if (*size > retain) {
+        if (retain == 0) {
+            free(*buf);
+            *buf = nullptr;
+        } else {
+            *buf = (char*)realloc(*buf, retain);
+        }
+        *size = retain;
+    }
+}
+
+void scratch_init(scratch* s, size_t retain) {
+    assert(s != nullptr);
+    s->stack = s->frames = nullptr;
+    s->size = s->frames_size = 0;
+    s->retain = retain;
+}
+
+void scratch_trim(scratch* s, size_t retain) {
+    assert(s != nullptr);
+    shrink_buffer(&s->stack, &s->size, retain);
+    shrink_buffer(&s->frames, &s->frames_size, retain);
+}
+
+void scratch_free(scratch* s) { scratch_trim(s, 0); }
+
 inline void PUTC(context* c, char ch) { *(char*)context_push(c, sizeof(char)) = ch; }
 
 inline void PUTS(context* c, const char* s, size_t len) { memcpy(context_push(c, len), s, len); }
 
-void copy(value* dst, const value* src) {
-    size_t i;
-    assert(dst != nullptr && src != nullptr && dst != src);
-    switch (src->tiny_type) {
-    case STRING:
-        set_string(dst, src->u.s.s, src->u.s.len);
-        break;
-    case ARRAY:
-        set_array(dst, src->u.a.size);
-        for (i = 0; i < src->u.a.size; ++i) {
-            copy(&dst->u.a.e[i], &src->u.a.e[i]);
+void arena_init(arena* a, void* buf, size_t size) {
+    assert(a != nullptr && (buf != nullptr || size == 0));
+    a->buf = a->head = (char*)buf;
+    a->size = a->head_size = size;
+    a->used = 0;
+    a->blocks = nullptr;
+}
+
+void* arena_alloc(arena* a, size_t size) {
+    assert(a != nullptr);
+    // 对齐的是地址而不是偏移，调用者提供的缓冲区不一定按8字节对齐
+    size_t offset = (((uintptr_t)a->buf + a->used + 7) & ~(uintptr_t)7) - (uintptr_t)a->buf;
+    if (a->buf == nullptr || offset + size > a->size) {
+        // 当前块不够用，从堆上申请一个新块，新块至少是上一块的两倍
+        size_t block_size = a->size * 2 > ARENA_MIN_BLOCK_SIZE ? a->size * 2 : ARENA_MIN_BLOCK_SIZE;
+        if (block_size < size) {
+            block_size = size;
         }
-        dst->u.a.size = src->u.a.size;
-        break;
-    case OBJECT:
-        set_object(dst, src->u.o.size);
-        for (i = 0; i < src->u.o.size; ++i) {
-            auto v = set_object_value(dst, src->u.o.m[i].k, src->u.o.m[i].klen);
-            copy(v, &src->u.o.m[i].v);
+        arena_block* b = (arena_block*)malloc(sizeof(arena_block) + block_size);
+        b->next = a->blocks;
+        b->size = block_size;
+        a->blocks = b;
+        a->buf = (char*)(b + 1);
+        a->size = block_size;
+        offset = 0;
+    }
+    a->used = offset + size;
+    return a->buf + offset;
+}
+
+void arena_release(arena* a) {
+    assert(a != nullptr);
+    // 释放所有从堆上申请的块，调用者的缓冲区由调用者自己管理，重新从头开始使用
+    arena_block* b = a->blocks;
+    while (b != nullptr) {
+        arena_block* next = b->next;
+        free(b);
+        b = next;
+    }
+    a->blocks = nullptr;
+    a->buf = a->head;
+    a->size = a->head_size;
+    a->used = 0;
+}
+
+// 为解析结果分配内存，设置了arena时从arena中分配
+static void* context_alloc(context* c, size_t size) { return c->pool ? arena_alloc(c->pool, size) : malloc(size); }
+
+inline const char* STR(const value* v) { return v->tiny_flags & VALUE_FLAG_INLINE ? v->u.ss : v->u.s.s; }
+
+inline size_t STR_LEN(const value* v) {
+    return v->tiny_flags & VALUE_FLAG_INLINE ? v->tiny_flags >> INLINE_LEN_SHIFT : v->u.s.len;
+}
+
+inline unsigned char KEY_TAG(const member* m) { return (unsigned char)m->k.ss[MEMBER_INLINE_KEY]; }
+
+inline bool KEY_INLINE(const member* m) { return !(KEY_TAG(m) & KEY_TAG_LONG); }
+
+inline const char* KEY(const member* m) { return KEY_INLINE(m) ? m->k.ss : m->k.p.s; }
+
+inline size_t KEY_LEN(const member* m) {
+    return KEY_INLINE(m) ? MEMBER_INLINE_KEY - KEY_TAG(m) : (m->k.p.len >> KEY_LEN_SHIFT) & KEY_LEN_MAX;
+}
+
+// 设置k.p中的键，flags为KEY_FLAG_*；s为nullptr、长度为0时表示成员没有键
+inline void KEY_SET(member* m, const char* s, size_t len, unsigned char flags) {
+    assert(len <= KEY_LEN_MAX);
+    m->k.p.s = (char*)s;
+    m->k.p.len = len << KEY_LEN_SHIFT;
+    m->k.ss[MEMBER_INLINE_KEY] = (char)(KEY_TAG_LONG | flags);
+}
+
+// 字符串的副本，c为nullptr时从堆上分配，否则由context_alloc分配
+static char* string_dup(context* c, const char* s, size_t len) {
+    char* ret = (char*)(c ? context_alloc(c, len + 1) : malloc(len + 1));
+    if (len > 0) {
+        memcpy(ret, s, len);
+    }
+    ret[len] = '\0';
+    return ret;
+}
+
+// 设置字符串的内容，短字符串直接存放在节点内，不保留v原有的标志位以外的状态
+static void string_init(value* v, const char* s, size_t len, context* c) {
+    if (len <= VALUE_INLINE_STRING) {
+        if (len > 0) {
+            memcpy(v->u.ss, s, len);
         }
-        dst->u.o.size = src->u.o.size;
-        break;
-    default:
+        v->u.ss[len] = '\0';
+        v->tiny_flags |= VALUE_FLAG_INLINE | (unsigned int)len << INLINE_LEN_SHIFT;
+    } else {
+        v->u.s.s = string_dup(c, s, len);
+        v->u.s.len = len;
+    }
+    v->tiny_type = STRING;
+}
+
+// 设置成员的键，短键直接存放在成员内，keys非空时长键从中驻留
+static void key_init(member* m, const char* key, size_t klen, context* c, key_table* keys) {
+    if (klen <= MEMBER_INLINE_KEY) {
+        if (klen > 0) {
+            memcpy(m->k.ss, key, klen);
+        }
+        m->k.ss[klen] = '\0';
+        m->k.ss[MEMBER_INLINE_KEY] = (char)(MEMBER_INLINE_KEY - klen);
+    } else if (keys) {
+        KEY_SET(m, key_table_intern(keys, key, klen), klen, KEY_FLAG_SHARED);
+    } else {
+        KEY_SET(m, string_dup(c, key, klen), klen, 0);
+    }
+}
+
+// 释放键的内存，之后成员没有键
+static void free_key(member* m) {
+    if (KEY_TAG(m) == KEY_TAG_LONG) {
+        free(m->k.p.s);
+    }
+    KEY_SET(m, nullptr, 0, 0);
+}
+
+/* object的哈希索引
+ * 索引和成员数组放在同一块内存中：capacity个member之后是slots个uint32_t，slots为不小于2 * capacity的2的幂
+ * 每个槽存放成员下标 + 1，0表示空槽，冲突时线性探测
+ */
+static size_t index_slots(size_t capacity) {
+    size_t n = 1;
+    while (n < capacity * 2) {
+        n <<= 1;
+    }
+    return n;
+}
+
+// 成员数组加上索引需要的内存大小
+static size_t object_block_size(size_t capacity, bool indexed) {
+    return capacity * sizeof(member) + (indexed ? index_slots(capacity) * sizeof(uint32_t) : 0);
+}
+
+static uint32_t* object_index(const value* v) { return (uint32_t*)(v->u.o.m + v->u.o.capacity); }
+
+// FNV-1a
+static size_t hash_key(const char* key, size_t klen) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < klen; ++i) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+    return (size_t)(h ^ (h >> 32));
+}
+
+/* 键的驻留表
+ * 开放寻址、线性探测，装载因子不超过1/2；每个键单独分配，扩容时只移动槽，已经返回的指针一直有效
+ * 查找不加锁：槽一旦写入就不再改变，新的槽数组填好之后才发布，所以读到的非空槽总是完整的键
+ * 没找到时才加锁，在最新的槽数组上重新查找后再插入；扩容前的槽数组可能仍有线程在查找，留到key_table_free时释放
+ */
+inline const char* INTERNED_KEY(const char* block) { return block + sizeof(size_t); }
+
+inline size_t INTERNED_LEN(const char* block) { return *(const size_t*)block; }
+
+typedef struct key_slots {
+    size_t capacity;           // 2的幂
+    std::atomic<char*>* slots; // 每个非空槽指向一个 [size_t 长度][键]['\0'] 的块
+    struct key_slots* retired; // 扩容前的槽数组
+} key_slots;
+
+typedef struct {
+    std::atomic<key_slots*> current;
+    size_t count; // 受lock保护
+    std::mutex lock;
+} key_table_impl;
+
+inline key_table_impl* KEY_TABLE(const key_table* t) { return (key_table_impl*)t->impl; }
+
+void key_table_init(key_table* t) {
+    assert(t != nullptr);
+    key_table_impl* impl = new key_table_impl;
+    impl->current.store(nullptr, std::memory_order_relaxed);
+    impl->count = 0;
+    t->impl = impl;
+}
+
+void key_table_free(key_table* t) {
+    assert(t != nullptr);
+    key_table_impl* impl = KEY_TABLE(t);
+    key_slots* s = impl->current.load(std::memory_order_relaxed);
+    // 最新的槽数组包含所有的键，之前的槽数组中只是它们的一部分
+    for (size_t i = 0; s && i < s->capacity; ++i) {
+        free(s->slots[i].load(std::memory_order_relaxed));
+    }
+    while (s) {
+        key_slots* retired = s->retired;
+        delete[] s->slots;
+        delete s;
+        s = retired;
+    }
+    delete impl;
+    t->impl = nullptr;
+}
+
+// 在s中查找，找到时返回驻留的块，否则返回nullptr并把探测停下的空槽存入*slot
+static char* key_slots_find(const key_slots* s, const char* key, size_t klen, size_t hash, size_t* slot) {
+    size_t h = hash & (s->capacity - 1);
+    for (char* b; (b = s->slots[h].load(std::memory_order_acquire)) != nullptr; h = (h + 1) & (s->capacity - 1)) {
+        if (INTERNED_LEN(b) == klen && memcmp(INTERNED_KEY(b), key, klen) == 0) {
+            return b;
+        }
+    }
+    *slot = h;
+    return nullptr;
+}
+
+// 加锁时调用：把所有的键移入两倍大的新槽数组中再发布
+static key_slots* key_table_grow(key_table_impl* impl, key_slots* old) {
+    key_slots* s = new key_slots;
+    s->capacity = old ? old->capacity * 2 : 64;
+    s->slots = new std::atomic<char*>[s->capacity]();
+    s->retired = old;
+    for (size_t i = 0; old && i < old->capacity; ++i) {
+        char* b = old->slots[i].load(std::memory_order_relaxed);
+        if (b) {
+            size_t h = hash_key(INTERNED_KEY(b), INTERNED_LEN(b)) & (s->capacity - 1);
+            while (s->slots[h].load(std::memory_order_relaxed)) {
+                h = (h + 1) & (s->capacity - 1);
+            }
+            s->slots[h].store(b, std::memory_order_relaxed);
+        }
+    }
+    impl->current.store(s, std::memory_order_release);
+    return s;
+}
+
+const char* key_table_intern(key_table* t, const char* key, size_t klen) {
+    assert(t != nullptr && t->impl != nullptr && (key != nullptr || klen == 0));
+    key_table_impl* impl = KEY_TABLE(t);
+    size_t hash = hash_key(key, klen), h;
+    key_slots* s = impl->current.load(std::memory_order_acquire);
+    char* b;
+    if (s && (b = key_slots_find(s, key, klen, hash, &h)) != nullptr) {
+        return INTERNED_KEY(b);
+    }
+    std::lock_guard<std::mutex> guard(impl->lock);
+    s = impl->current.load(std::memory_order_relaxed);
+    if (!s || (impl->count + 1) * 2 > s->capacity) {
+        s = key_table_grow(impl, s);
+    }
+    // 其他线程可能在加锁之前插入了同一个键
+    if ((b = key_slots_find(s, key, klen, hash, &h)) != nullptr) {
+        return INTERNED_KEY(b);
+    }
+    b = (char*)malloc(sizeof(size_t) + klen + 1);
+    *(size_t*)b = klen;
+    if (klen > 0) {
+        memcpy(b + sizeof(size_t), key, klen);
+    }
+    b[sizeof(size_t) + klen] = '\0';
+    s->slots[h].store(b, std::memory_order_release);
+    ++impl->count;
+    return INTERNED_KEY(b);
+}
+
+size_t key_table_size(key_table* t) {
+    assert(t != nullptr && t->impl != nullptr);
+    key_table_impl* impl = KEY_TABLE(t);
+    std::lock_guard<std::mutex> guard(impl->lock);
+    return impl->count;
+}
+
+static void object_index_insert(value* v, size_t i) {
+    uint32_t* slots = object_index(v);
+    size_t mask = index_slots(v->u.o.capacity) - 1;
+    size_t h = hash_key(KEY(&v->u.o.m[i]), KEY_LEN(&v->u.o.m[i])) & mask;
+    while (slots[h] != 0) {
+        h = (h + 1) & mask;
+    }
+    slots[h] = (uint32_t)(i + 1);
+}
+
+// 按成员顺序重建索引，重复的键中靠前的成员先被找到，与线性查找的结果一致
+static void object_build_index(value* v) {
+    memset(object_index(v), 0, index_slots(v->u.o.capacity) * sizeof(uint32_t));
+    for (size_t i = 0; i < v->u.o.size; ++i) {
+        object_index_insert(v, i);
+    }
+}
+
+// 以新的容量重新分配成员数组，indexed表示是否需要索引
+static void object_realloc(value* v, size_t capacity, bool indexed) {
+    v->u.o.capacity = capacity;
+    size_t size = object_block_size(capacity, indexed);
+    if (size == 0) {
+        free(v->u.o.m);
+        v->u.o.m = nullptr;
+    } else {
+        v->u.o.m = (member*)realloc(v->u.o.m, size);
+    }
+    if (indexed) {
+        v->tiny_flags |= VALUE_FLAG_INDEXED;
+        object_build_index(v);
+    } else {
+        v->tiny_flags &= ~VALUE_FLAG_INDEXED;
+    }
+}
+
+// 在object末尾追加一个成员，不检查键是否已经存在
+static value* object_append(value* v, const char* key, size_t klen, key_table* keys) {
+    if (v->u.o.capacity == v->u.o.size) {
+        object_reserve(v, v->u.o.capacity == 0 ? 1 : v->u.o.capacity * EXPAND_COEFFICIENT);
+    }
+    auto size = v->u.o.size++;
+    key_init(&v->u.o.m[size], key, klen, nullptr, keys);
+    tiny_init(&v->u.o.m[size].v);
+    if (v->tiny_flags & VALUE_FLAG_INDEXED) {
+        object_index_insert(v, size);
+    } else if (v->u.o.size >= OBJECT_INDEX_THRESHOLD) {
+        object_realloc(v, v->u.o.capacity, true);
+    }
+    return &v->u.o.m[size].v;
+}
+
+/* tiny_free/copy/stringify/is_equal对树的非递归遍历
+ * 正在遍历的array/object保存在局部变量中，只有进入下一层时才把它压入context的堆栈，所以不含嵌套的节点不需要分配内存
+ */
+typedef struct {
+    const value* a; // 正在遍历的array/object
+    const value* b; // copy时为对应的目标节点，is_equal时为另一侧对应的节点
+    size_t i;       // 下一个要处理的元素
+} walk_frame;
+
+inline bool IS_CONTAINER(const value* v) { return v->tiny_type == ARRAY || v->tiny_type == OBJECT; }
+
+inline size_t CHILD_COUNT(const value* v) { return v->tiny_type == ARRAY ? v->u.a.size : v->u.o.size; }
+
+inline value* CHILD(const value* v, size_t i) { return v->tiny_type == ARRAY ? &v->u.a.e[i] : &v->u.o.m[i].v; }
+
+inline void walk_push(context* c, const walk_frame* f) {
+    memcpy(context_push(c, sizeof(walk_frame)), f, sizeof(walk_frame));
+}
+
+// 复制字符串或标量
+static void copy_scalar(value* dst, const value* src) {
+    if (src->tiny_type == STRING) {
+        set_string(dst, STR(src), STR_LEN(src));
+    } else {
         tiny_free(dst);
         memcpy(dst, src, sizeof(value));
-        break;
+        dst->tiny_flags = 0;
     }
 }
 
+void copy(value* dst, const value* src) {
+    assert(dst != nullptr && src != nullptr && dst != src);
+    if (!IS_CONTAINER(src)) {
+        copy_scalar(dst, src);
+        return;
+    }
+    context c;
+    context_init(&c, nullptr, 0);
+    walk_frame f = {src, dst, 0};
+    for (;;) {
+        value* d = (value*)f.b;
+        if (f.i == 0) {
+            // 第一次访问时按源节点的大小建立目标节点
+            if (f.a->tiny_type == ARRAY) {
+                set_array(d, f.a->u.a.size);
+            } else {
+                set_object(d, f.a->u.o.size);
+            }
+        }
+        if (f.i < CHILD_COUNT(f.a)) {
+            size_t i = f.i++;
+            value* e;
+            if (f.a->tiny_type == ARRAY) {
+                e = &d->u.a.e[d->u.a.size++];
+                tiny_init(e);
+            } else {
+                e = object_append(d, KEY(&f.a->u.o.m[i]), KEY_LEN(&f.a->u.o.m[i]), nullptr);
+            }
+            const value* s = CHILD(f.a, i);
+            if (IS_CONTAINER(s)) {
+                walk_push(&c, &f);
+                f.a = s;
+                f.b = e;
+                f.i = 0;
+            } else {
+                copy_scalar(e, s);
+            }
+            continue;
+        }
+        if (c.top == 0) {
+            break;
+        }
+        memcpy(&f, context_pop(&c, sizeof(walk_frame)), sizeof(walk_frame));
+    }
+    free(c.stack);
+}
+
 void move(value* dst, value* src) {
     assert(dst != nullptr && src != nullptr && dst != src);
     tiny_free(dst);
@@ -118,7 +628,7 @@ void swap(value* lhs, value* rhs) {
 /* ws = *(%x20 / %x09 / %x0A / %x0D) */
 static void parse_whitespace(context* c) {
     const char* p = c->json;
-    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+    while (p != c->end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
         ++p;
     }
     c->json = p;
@@ -128,7 +638,7 @@ static int parse_literal(context* c, value* v, const char* literal, type type) {
     EXPECT(c, literal[0]);
     size_t i;
     for (i = 0; literal[i + 1]; ++i) {
-        if (c->json[i] != literal[i + 1]) {
+        if (c->json + i == c->end || c->json[i] != literal[i + 1]) {
             return PARSE_INVALID_VALUE;
         }
     }
@@ -137,88 +647,837 @@ static int parse_literal(context* c, value* v, const char* literal, type type) {
     return PARSE_OK;
 }
 
-static int parse_number(context* c, value* v) {
-    const char* p = c->json;
-    // 数字合法性校验
-    // 负号直接跳过即可
-    if (*p == '-') {
-        ++p;
+/* 数字转换：校验语法的同时累积有效数字和十进制指数，然后按以下顺序转换成double，不依赖strtod和locale
+ * 1. Clinger快速路径：有效数字不超过2^53且指数绝对值不超过22时，一次浮点乘除法即可得到精确结果
+ * 2. Eisel-Lemire算法：用128位截断的5的幂把十进制转换为二进制，有效数字不超过19位时结果总是正确的
+ * 3. 有效数字超过19位且截断导致结果无法确定时，用高精度十进制移位的方法求出正确结果
+ */
+const int NUMBER_MAX_DIGITS = 19;     // uint64_t能精确表示的十进制有效数字位数
+const int POW5_MIN_EXPONENT = -342;   // 小于这个指数的结果一定下溢为0
+const int POW5_MAX_EXPONENT = 308;    // 大于这个指数的结果一定上溢为无穷大
+const int DOUBLE_MANTISSA_BITS = 52;
+const int DOUBLE_INFINITE_POWER = 0x7ff;
+
+// 5^q（q属于[-342, 308]）规格化后的高128位，每两个数为一组（高64位，低64位），由脚本生成
+static const uint64_t POW5_128[] = {
+    0xeef453d6923bd65a, 0x113faa2906a13b3f, 0x9558b4661b6565f8, 0x4ac7ca59a424c507,
+    0xbaaee17fa23ebf76, 0x5d79bcf00d2df649, 0xe95a99df8ace6f53, 0xf4d82c2c107973dc,
+    0x91d8a02bb6c10594, 0x79071b9b8a4be869, 0xb64ec836a47146f9, 0x9748e2826cdee284,
+    0xe3e27a444d8d98b7, 0xfd1b1b2308169b25, 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7,
+    0xb208ef855c969f4f, 0xbdbd2d335e51a935, 0xde8b2b66b3bc4723, 0xad2c788035e61382,
+    0x8b16fb203055ac76, 0x4c3bcb5021afcc31, 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d,
+    0xd953e8624b85dd78, 0xd71d6dad34a2af0d, 0x87d4713d6f33aa6b, 0x8672648c40e5ad68,
+    0xa9c98d8ccb009506, 0x680efdaf511f18c2, 0xd43bf0effdc0ba48, 0x0212bd1b2566def2,
+    0x84a57695fe98746d, 0x014bb630f7604b57, 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d,
+    0xcf42894a5dce35ea, 0x52064cac828675b9, 0x818995ce7aa0e1b2, 0x7343efebd1940993,
+    0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8, 0xca66fa129f9b60a6, 0xd41a26e077774ef6,
+    0xfd00b897478238d0, 0x8920b098955522b4, 0x9e20735e8cb16382, 0x55b46e5f5d5535b0,
+    0xc5a890362fddbc62, 0xeb2189f734aa831d, 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4,
+    0x9a6bb0aa55653b2d, 0x47b233c92125366e, 0xc1069cd4eabe89f8, 0x999ec0bb696e840a,
+    0xf148440a256e2c76, 0xc00670ea43ca250d, 0x96cd2a865764dbca, 0x380406926a5e5728,
+    0xbc807527ed3e12bc, 0xc605083704f5ecf2, 0xeba09271e88d976b, 0xf7864a44c633682e,
+    0x93445b8731587ea3, 0x7ab3ee6afbe0211d, 0xb8157268fdae9e4c, 0x5960ea05bad82964,
+    0xe61acf033d1a45df, 0x6fb92487298e33bd, 0x8fd0c16206306bab, 0xa5d3b6d479f8e056,
+    0xb3c4f1ba87bc8696, 0x8f48a4899877186c, 0xe0b62e2929aba83c, 0x331acdabfe94de87,
+    0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14, 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9,
+    0xdb71e91432b1a24a, 0xc9e82cd9f69d6150, 0x892731ac9faf056e, 0xbe311c083a225cd2,
+    0xab70fe17c79ac6ca, 0x6dbd630a48aaf406, 0xd64d3d9db981787d, 0x092cbbccdad5b108,
+    0x85f0468293f0eb4e, 0x25bbf56008c58ea5, 0xa76c582338ed2621, 0xaf2af2b80af6f24e,
+    0xd1476e2c07286faa, 0x1af5af660db4aee1, 0x82cca4db847945ca, 0x50d98d9fc890ed4d,
+    0xa37fce126597973c, 0xe50ff107bab528a0, 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8,
+    0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a, 0x9faacf3df73609b1, 0x77b191618c54e9ac,
+    0xc795830d75038c1d, 0xd59df5b9ef6a2417, 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d,
+    0x9becce62836ac577, 0x4ee367f9430aec32, 0xc2e801fb244576d5, 0x229c41f793cda73f,
+    0xf3a20279ed56d48a, 0x6b43527578c1110f, 0x9845418c345644d6, 0x830a13896b78aaa9,
+    0xbe5691ef416bd60c, 0x23cc986bc656d553, 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8,
+    0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9, 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53,
+    0xe858ad248f5c22c9, 0xd1b3400f8f9cff68, 0x91376c36d99995be, 0x23100809b9c21fa1,
+    0xb58547448ffffb2d, 0xabd40a0c2832a78a, 0xe2e69915b3fff9f9, 0x16c90c8f323f516c,
+    0x8dd01fad907ffc3b, 0xae3da7d97f6792e3, 0xb1442798f49ffb4a, 0x99cd11cfdf41779c,
+    0xdd95317f31c7fa1d, 0x40405643d711d583, 0x8a7d3eef7f1cfc52, 0x482835ea666b2572,
+    0xad1c8eab5ee43b66, 0xda3243650005eecf, 0xd863b256369d4a40, 0x90bed43e40076a82,
+    0x873e4f75e2224e68, 0x5a7744a6e804a291, 0xa90de3535aaae202, 0x711515d0a205cb36,
+    0xd3515c2831559a83, 0x0d5a5b44ca873e03, 0x8412d9991ed58091, 0xe858790afe9486c2,
+    0xa5178fff668ae0b6, 0x626e974dbe39a872, 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f,
+    0x80fa687f881c7f8e, 0x7ce66634bc9d0b99, 0xa139029f6a239f72, 0x1c1fffc1ebc44e80,
+    0xc987434744ac874e, 0xa327ffb266b56220, 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8,
+    0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9, 0xc4ce17b399107c22, 0xcb550fb4384d21d3,
+    0xf6019da07f549b2b, 0x7e2a53a146606a48, 0x99c102844f94e0fb, 0x2eda7444cbfc426d,
+    0xc0314325637a1939, 0xfa911155fefb5308, 0xf03d93eebc589f88, 0x793555ab7eba27ca,
+    0x96267c7535b763b5, 0x4bc1558b2f3458de, 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16,
+    0xea9c227723ee8bcb, 0x465e15a979c1cadc, 0x92a1958a7675175f, 0x0bfacd89ec191ec9,
+    0xb749faed14125d36, 0xcef980ec671f667b, 0xe51c79a85916f484, 0x82b7e12780e7401a,
+    0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810, 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15,
+    0xdfbdcece67006ac9, 0x67a791e093e1d49a, 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0,
+    0xaecc49914078536d, 0x58fae9f773886e18, 0xda7f5bf590966848, 0xaf39a475506a899e,
+    0x888f99797a5e012d, 0x6d8406c952429603, 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83,
+    0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64, 0x855c3be0a17fcd26, 0x5cf2eea09a55067f,
+    0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e, 0xd0601d8efc57b08b, 0xf13b94daf124da26,
+    0x823c12795db6ce57, 0x76c53d08d6b70858, 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e,
+    0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09, 0xfe5d54150b090b02, 0xd3f93b35435d7c4c,
+    0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf, 0xc6b8e9b0709f109a, 0x359ab6419ca1091b,
+    0xf867241c8cc6d4c0, 0xc30163d203c94b62, 0x9b407691d7fc44f8, 0x79e0de63425dcf1d,
+    0xc21094364dfb5636, 0x985915fc12f542e4, 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d,
+    0x979cf3ca6cec5b5a, 0xa705992ceecf9c42, 0xbd8430bd08277231, 0x50c6ff782a838353,
+    0xece53cec4a314ebd, 0xa4f8bf5635246428, 0x940f4613ae5ed136, 0x871b7795e136be99,
+    0xb913179899f68584, 0x28e2557b59846e3f, 0xe757dd7ec07426e5, 0x331aeada2fe589cf,
+    0x9096ea6f3848984f, 0x3ff0d2c85def7621, 0xb4bca50b065abe63, 0x0fed077a756b53a9,
+    0xe1ebce4dc7f16dfb, 0xd3e8495912c62894, 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c,
+    0xb080392cc4349dec, 0xbd8d794d96aacfb3, 0xdca04777f541c567, 0xecf0d7a0fc5583a0,
+    0x89e42caaf9491b60, 0xf41686c49db57244, 0xac5d37d5b79b6239, 0x311c2875c522ced5,
+    0xd77485cb25823ac7, 0x7d633293366b828b, 0x86a8d39ef77164bc, 0xae5dff9c02033197,
+    0xa8530886b54dbdeb, 0xd9f57f830283fdfc, 0xd267caa862a12d66, 0xd072df63c324fd7b,
+    0x8380dea93da4bc60, 0x4247cb9e59f71e6d, 0xa46116538d0deb78, 0x52d9be85f074e608,
+    0xcd795be870516656, 0x67902e276c921f8b, 0x806bd9714632dff6, 0x00ba1cd8a3db53b6,
+    0xa086cfcd97bf97f3, 0x80e8a40eccd228a4, 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd,
+    0xfad2a4b13d1b5d6c, 0x796b805720085f81, 0x9cc3a6eec6311a63, 0xcbe3303674053bb0,
+    0xc3f490aa77bd60fc, 0xbedbfc4411068a9c, 0xf4f1b4d515acb93b, 0xee92fb5515482d44,
+    0x991711052d8bf3c5, 0x751bdd152d4d1c4a, 0xbf5cd54678eef0b6, 0xd262d45a78a0635d,
+    0xef340a98172aace4, 0x86fb897116c87c34, 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0,
+    0xbae0a846d2195712, 0x8974836059cca109, 0xe998d258869facd7, 0x2bd1a438703fc94b,
+    0x91ff83775423cc06, 0x7b6306a34627ddcf, 0xb67f6455292cbf08, 0x1a3bc84c17b1d542,
+    0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93, 0x8e938662882af53e, 0x547eb47b7282ee9c,
+    0xb23867fb2a35b28d, 0xe99e619a4f23aa43, 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4,
+    0x8b3c113c38f9f37e, 0xde83bc408dd3dd04, 0xae0b158b4738705e, 0x9624ab50b148d445,
+    0xd98ddaee19068c76, 0x3badd624dd9b0957, 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6,
+    0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c, 0xd47487cc8470652b, 0x7647c3200069671f,
+    0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073, 0xa5fb0a17c777cf09, 0xf468107100525890,
+    0xcf79cc9db955c2cc, 0x7182148d4066eeb4, 0x81ac1fe293d599bf, 0xc6f14cd848405530,
+    0xa21727db38cb002f, 0xb8ada00e5a506a7c, 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c,
+    0xfd442e4688bd304a, 0x908f4a166d1da663, 0x9e4a9cec15763e2e, 0x9a598e4e043287fe,
+    0xc5dd44271ad3cdba, 0x40eff1e1853f29fd, 0xf7549530e188c128, 0xd12bee59e68ef47c,
+    0x9a94dd3e8cf578b9, 0x82bb74f8301958ce, 0xc13a148e3032d6e7, 0xe36a52363c1faf01,
+    0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1, 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9,
+    0xbcb2b812db11a5de, 0x7415d448f6b6f0e7, 0xebdf661791d60f56, 0x111b495b3464ad21,
+    0x936b9fcebb25c995, 0xcab10dd900beec34, 0xb84687c269ef3bfb, 0x3d5d514f40eea742,
+    0xe65829b3046b0afa, 0x0cb4a5a3112a5112, 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab,
+    0xb3f4e093db73a093, 0x59ed216765690f56, 0xe0f218b8d25088b8, 0x306869c13ec3532c,
+    0x8c974f7383725573, 0x1e414218c73a13fb, 0xafbd2350644eeacf, 0xe5d1929ef90898fa,
+    0xdbac6c247d62a583, 0xdf45f746b74abf39, 0x894bc396ce5da772, 0x6b8bba8c328eb783,
+    0xab9eb47c81f5114f, 0x066ea92f3f326564, 0xd686619ba27255a2, 0xc80a537b0efefebd,
+    0x8613fd0145877585, 0xbd06742ce95f5f36, 0xa798fc4196e952e7, 0x2c48113823b73704,
+    0xd17f3b51fca3a7a0, 0xf75a15862ca504c5, 0x82ef85133de648c4, 0x9a984d73dbe722fb,
+    0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba, 0xcc963fee10b7d1b3, 0x318df905079926a8,
+    0xffbbcfe994e5c61f, 0xfdf17746497f7052, 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633,
+    0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0, 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0,
+    0x9c1661a651213e2d, 0x06bea10ca65c084e, 0xc31bfa0fe5698db8, 0x486e494fcff30a62,
+    0xf3e2f893dec3f126, 0x5a89dba3c3efccfa, 0x986ddb5c6b3a76b7, 0xf89629465a75e01c,
+    0xbe89523386091465, 0xf6bbb397f1135823, 0xee2ba6c0678b597f, 0x746aa07ded582e2c,
+    0x94db483840b717ef, 0xa8c2a44eb4571cdc, 0xba121a4650e4ddeb, 0x92f34d62616ce413,
+    0xe896a0d7e51e1566, 0x77b020baf9c81d17, 0x915e2486ef32cd60, 0x0ace1474dc1d122e,
+    0xb5b5ada8aaff80b8, 0x0d819992132456ba, 0xe3231912d5bf60e6, 0x10e1fff697ed6c69,
+    0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1, 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2,
+    0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde, 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b,
+    0xad4ab7112eb3929d, 0x86c16c98d2c953c6, 0xd89d64d57a607744, 0xe871c7bf077ba8b7,
+    0x87625f056c7c4a8b, 0x11471cd764ad4972, 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf,
+    0xd389b47879823479, 0x4aff1d108d4ec2c3, 0x843610cb4bf160cb, 0xcedf722a585139ba,
+    0xa54394fe1eedb8fe, 0xc2974eb4ee658828, 0xce947a3da6a9273e, 0x733d226229feea32,
+    0x811ccc668829b887, 0x0806357d5a3f525f, 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7,
+    0xc9bcff6034c13052, 0xfc89b393dd02f0b5, 0xfc2c3f3841f17c67, 0xbbac2078d443ace2,
+    0x9d9ba7832936edc0, 0xd54b944b84aa4c0d, 0xc5029163f384a931, 0x0a9e795e65d4df11,
+    0xf64335bcf065d37d, 0x4d4617b5ff4a16d5, 0x99ea0196163fa42e, 0x504bced1bf8e4e45,
+    0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6, 0xf07da27a82c37088, 0x5d767327bb4e5a4c,
+    0x964e858c91ba2655, 0x3a6a07f8d510f86f, 0xbbe226efb628afea, 0x890489f70a55368b,
+    0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e, 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d,
+    0xb77ada0617e3bbcb, 0x09ce6ebb40173744, 0xe55990879ddcaabd, 0xcc420a6a101d0515,
+    0x8f57fa54c2a9eab6, 0x9fa946824a12232d, 0xb32df8e9f3546564, 0x47939822dc96abf9,
+    0xdff9772470297ebd, 0x59787e2b93bc56f7, 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a,
+    0xaefae51477a06b03, 0xede622920b6b23f1, 0xdab99e59958885c4, 0xe95fab368e45eced,
+    0x88b402f7fd75539b, 0x11dbcb0218ebb414, 0xaae103b5fcd2a881, 0xd652bdc29f26a119,
+    0xd59944a37c0752a2, 0x4be76d3346f0495f, 0x857fcae62d8493a5, 0x6f70a4400c562ddb,
+    0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952, 0xd097ad07a71f26b2, 0x7e2000a41346a7a7,
+    0x825ecc24c873782f, 0x8ed400668c0c28c8, 0xa2f67f2dfa90563b, 0x728900802f0f32fa,
+    0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9, 0xfea126b7d78186bc, 0xe2f610c84987bfa8,
+    0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9, 0xc6ede63fa05d3143, 0x91503d1c79720dbb,
+    0xf8a95fcf88747d94, 0x75a44c6397ce912a, 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba,
+    0xc24452da229b021b, 0xfbe85badce996168, 0xf2d56790ab41c2a2, 0xfae27299423fb9c3,
+    0x97c560ba6b0919a5, 0xdccd879fc967d41a, 0xbdb6b8e905cb600f, 0x5400e987bbc1c920,
+    0xed246723473e3813, 0x290123e9aab23b68, 0x9436c0760c86e30b, 0xf9a0b6720aaf6521,
+    0xb94470938fa89bce, 0xf808e40e8d5b3e69, 0xe7958cb87392c2c2, 0xb60b1d1230b20e04,
+    0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2, 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3,
+    0xe2280b6c20dd5232, 0x25c6da63c38de1b0, 0x8d590723948a535f, 0x579c487e5a38ad0e,
+    0xb0af48ec79ace837, 0x2d835a9df0c6d851, 0xdcdb1b2798182244, 0xf8e431456cf88e65,
+    0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff, 0xac8b2d36eed2dac5, 0xe272467e3d222f3f,
+    0xd7adf884aa879177, 0x5b0ed81dcc6abb0f, 0x86ccbb52ea94baea, 0x98e947129fc2b4e9,
+    0xa87fea27a539e9a5, 0x3f2398d747b36224, 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad,
+    0x83a3eeeef9153e89, 0x1953cf68300424ac, 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7,
+    0xcdb02555653131b6, 0x3792f412cb06794d, 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0,
+    0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4, 0xc8de047564d20a8b, 0xf245825a5a445275,
+    0xfb158592be068d2e, 0xeed6e2f0f0d56712, 0x9ced737bb6c4183d, 0x55464dd69685606b,
+    0xc428d05aa4751e4c, 0xaa97e14c3c26b886, 0xf53304714d9265df, 0xd53dd99f4b3066a8,
+    0x993fe2c6d07b7fab, 0xe546a8038efe4029, 0xbf8fdb78849a5f96, 0xde98520472bdd033,
+    0xef73d256a5c0f77c, 0x963e66858f6d4440, 0x95a8637627989aad, 0xdde7001379a44aa8,
+    0xbb127c53b17ec159, 0x5560c018580d5d52, 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6,
+    0x9226712162ab070d, 0xcab3961304ca70e8, 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22,
+    0xe45c10c42a2b3b05, 0x8cb89a7db77c506a, 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242,
+    0xb267ed1940f1c61c, 0x55f038b237591ed3, 0xdf01e85f912e37a3, 0x6b6c46dec52f6688,
+    0x8b61313bbabce2c6, 0x2323ac4b3b3da015, 0xae397d8aa96c1b77, 0xabec975e0a0d081a,
+    0xd9c7dced53c72255, 0x96e7bd358c904a21, 0x881cea14545c7575, 0x7e50d64177da2e54,
+    0xaa242499697392d2, 0xdde50bd1d5d0b9e9, 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864,
+    0x84ec3c97da624ab4, 0xbd5af13bef0b113e, 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e,
+    0xcfb11ead453994ba, 0x67de18eda5814af2, 0x81ceb32c4b43fcf4, 0x80eacf948770ced7,
+    0xa2425ff75e14fc31, 0xa1258379a94d028d, 0xcad2f7f5359a3b3e, 0x096ee45813a04330,
+    0xfd87b5f28300ca0d, 0x8bca9d6e188853fc, 0x9e74d1b791e07e48, 0x775ea264cf55347e,
+    0xc612062576589dda, 0x95364afe032a819e, 0xf79687aed3eec551, 0x3a83ddbd83f52205,
+    0x9abe14cd44753b52, 0xc4926a9672793543, 0xc16d9a0095928a27, 0x75b7053c0f178294,
+    0xf1c90080baf72cb1, 0x5324c68b12dd6339, 0x971da05074da7bee, 0xd3f6fc16ebca5e04,
+    0xbce5086492111aea, 0x88f4bb1ca6bcf585, 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6,
+    0x9392ee8e921d5d07, 0x3aff322e62439fd0, 0xb877aa3236a4b449, 0x09befeb9fad487c3,
+    0xe69594bec44de15b, 0x4c2ebe687989a9b4, 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11,
+    0xb424dc35095cd80f, 0x538484c19ef38c95, 0xe12e13424bb40e13, 0x2865a5f206b06fba,
+    0x8cbccc096f5088cb, 0xf93f87b7442e45d4, 0xafebff0bcb24aafe, 0xf78f69a51539d749,
+    0xdbe6fecebdedd5be, 0xb573440e5a884d1c, 0x89705f4136b4a597, 0x31680a88f8953031,
+    0xabcc77118461cefc, 0xfdc20d2b36ba7c3e, 0xd6bf94d5e57a42bc, 0x3d32907604691b4d,
+    0x8637bd05af6c69b5, 0xa63f9a49c2c1b110, 0xa7c5ac471b478423, 0x0fcf80dc33721d54,
+    0xd1b71758e219652b, 0xd3c36113404ea4a9, 0x83126e978d4fdf3b, 0x645a1cac083126ea,
+    0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4, 0xcccccccccccccccc, 0xcccccccccccccccd,
+    0x8000000000000000, 0x0000000000000000, 0xa000000000000000, 0x0000000000000000,
+    0xc800000000000000, 0x0000000000000000, 0xfa00000000000000, 0x0000000000000000,
+    0x9c40000000000000, 0x0000000000000000, 0xc350000000000000, 0x0000000000000000,
+    0xf424000000000000, 0x0000000000000000, 0x9896800000000000, 0x0000000000000000,
+    0xbebc200000000000, 0x0000000000000000, 0xee6b280000000000, 0x0000000000000000,
+    0x9502f90000000000, 0x0000000000000000, 0xba43b74000000000, 0x0000000000000000,
+    0xe8d4a51000000000, 0x0000000000000000, 0x9184e72a00000000, 0x0000000000000000,
+    0xb5e620f480000000, 0x0000000000000000, 0xe35fa931a0000000, 0x0000000000000000,
+    0x8e1bc9bf04000000, 0x0000000000000000, 0xb1a2bc2ec5000000, 0x0000000000000000,
+    0xde0b6b3a76400000, 0x0000000000000000, 0x8ac7230489e80000, 0x0000000000000000,
+    0xad78ebc5ac620000, 0x0000000000000000, 0xd8d726b7177a8000, 0x0000000000000000,
+    0x878678326eac9000, 0x0000000000000000, 0xa968163f0a57b400, 0x0000000000000000,
+    0xd3c21bcecceda100, 0x0000000000000000, 0x84595161401484a0, 0x0000000000000000,
+    0xa56fa5b99019a5c8, 0x0000000000000000, 0xcecb8f27f4200f3a, 0x0000000000000000,
+    0x813f3978f8940984, 0x4000000000000000, 0xa18f07d736b90be5, 0x5000000000000000,
+    0xc9f2c9cd04674ede, 0xa400000000000000, 0xfc6f7c4045812296, 0x4d00000000000000,
+    0x9dc5ada82b70b59d, 0xf020000000000000, 0xc5371912364ce305, 0x6c28000000000000,
+    0xf684df56c3e01bc6, 0xc732000000000000, 0x9a130b963a6c115c, 0x3c7f400000000000,
+    0xc097ce7bc90715b3, 0x4b9f100000000000, 0xf0bdc21abb48db20, 0x1e86d40000000000,
+    0x96769950b50d88f4, 0x1314448000000000, 0xbc143fa4e250eb31, 0x17d955a000000000,
+    0xeb194f8e1ae525fd, 0x5dcfab0800000000, 0x92efd1b8d0cf37be, 0x5aa1cae500000000,
+    0xb7abc627050305ad, 0xf14a3d9e40000000, 0xe596b7b0c643c719, 0x6d9ccd05d0000000,
+    0x8f7e32ce7bea5c6f, 0xe4820023a2000000, 0xb35dbf821ae4f38b, 0xdda2802c8a800000,
+    0xe0352f62a19e306e, 0xd50b2037ad200000, 0x8c213d9da502de45, 0x4526f422cc340000,
+    0xaf298d050e4395d6, 0x9670b12b7f410000, 0xdaf3f04651d47b4c, 0x3c0cdd765f114000,
+    0x88d8762bf324cd0f, 0xa5880a69fb6ac800, 0xab0e93b6efee0053, 0x8eea0d047a457a00,
+    0xd5d238a4abe98068, 0x72a4904598d6d880, 0x85a36366eb71f041, 0x47a6da2b7f864750,
+    0xa70c3c40a64e6c51, 0x999090b65f67d924, 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d,
+    0x82818f1281ed449f, 0xbff8f10e7a8921a4, 0xa321f2d7226895c7, 0xaff72d52192b6a0d,
+    0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490, 0xfee50b7025c36a08, 0x02f236d04753d5b4,
+    0x9f4f2726179a2245, 0x01d762422c946590, 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5,
+    0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2, 0x9b934c3b330c8577, 0x63cc55f49f88eb2f,
+    0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb, 0xf316271c7fc3908a, 0x8bef464e3945ef7a,
+    0x97edd871cfda3a56, 0x97758bf0e3cbb5ac, 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317,
+    0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd, 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a,
+    0xb975d6b6ee39e436, 0xb3e2fd538e122b44, 0xe7d34c64a9c85d44, 0x60dbbca87196b616,
+    0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd, 0xb51d13aea4a488dd, 0x6babab6398bdbe41,
+    0xe264589a4dcdab14, 0xc696963c7eed2dd1, 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2,
+    0xb0de65388cc8ada8, 0x3b25a55f43294bcb, 0xdd15fe86affad912, 0x49ef0eb713f39ebe,
+    0x8a2dbf142dfcc7ab, 0x6e3569326c784337, 0xacb92ed9397bf996, 0x49c2c37f07965404,
+    0xd7e77a8f87daf7fb, 0xdc33745ec97be906, 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3,
+    0xa8acd7c0222311bc, 0xc40832ea0d68ce0c, 0xd2d80db02aabd62b, 0xf50a3fa490c30190,
+    0x83c7088e1aab65db, 0x792667c6da79e0fa, 0xa4b8cab1a1563f52, 0x577001b891185938,
+    0xcde6fd5e09abcf26, 0xed4c0226b55e6f86, 0x80b05e5ac60b6178, 0x544f8158315b05b4,
+    0xa0dc75f1778e39d6, 0x696361ae3db1c721, 0xc913936dd571c84c, 0x03bc3a19cd1e38e9,
+    0xfb5878494ace3a5f, 0x04ab48a04065c723, 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76,
+    0xc45d1df942711d9a, 0x3ba5d0bd324f8394, 0xf5746577930d6500, 0xca8f44ec7ee36479,
+    0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb, 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e,
+    0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e, 0x95d04aee3b80ece5, 0xbba1f1d158724a12,
+    0xbb445da9ca61281f, 0x2a8a6e45ae8edc97, 0xea1575143cf97226, 0xf52d09d71a3293bd,
+    0x924d692ca61be758, 0x593c2626705f9c56, 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c,
+    0xe498f455c38b997a, 0x0b6dfb9c0f956447, 0x8edf98b59a373fec, 0x4724bd4189bd5eac,
+    0xb2977ee300c50fe7, 0x58edec91ec2cb657, 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed,
+    0x8b865b215899f46c, 0xbd79e0d20082ee74, 0xae67f1e9aec07187, 0xecd8590680a3aa11,
+    0xda01ee641a708de9, 0xe80e6f4820cc9495, 0x884134fe908658b2, 0x3109058d147fdcdd,
+    0xaa51823e34a7eede, 0xbd4b46f0599fd415, 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a,
+    0x850fadc09923329e, 0x03e2cf6bc604ddb0, 0xa6539930bf6bff45, 0x84db8346b786151c,
+    0xcfe87f7cef46ff16, 0xe612641865679a63, 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e,
+    0xa26da3999aef7749, 0xe3be5e330f38f09d, 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5,
+    0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6, 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa,
+    0xc646d63501a1511d, 0xb281e1fd541501b8, 0xf7d88bc24209a565, 0x1f225a7ca91a4226,
+    0x9ae757596946075f, 0x3375788de9b06958, 0xc1a12d2fc3978937, 0x0052d6b1641c83ae,
+    0xf209787bb47d6b84, 0xc0678c5dbd23a49a, 0x9745eb4d50ce6332, 0xf840b7ba963646e0,
+    0xbd176620a501fbff, 0xb650e5a93bc3d898, 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe,
+    0x93ba47c980e98cdf, 0xc66f336c36b10137, 0xb8a8d9bbe123f017, 0xb80b0047445d4184,
+    0xe6d3102ad96cec1d, 0xa60dc059157491e5, 0x9043ea1ac7e41392, 0x87c89837ad68db2f,
+    0xb454e4a179dd1877, 0x29babe4598c311fb, 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a,
+    0x8ce2529e2734bb1d, 0x1899e4a65f58660c, 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f,
+    0xdc21a1171d42645d, 0x76707543f4fa1f73, 0x899504ae72497eba, 0x6a06494a791c53a8,
+    0xabfa45da0edbde69, 0x0487db9d17636892, 0xd6f8d7509292d603, 0x45a9d2845d3c42b6,
+    0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2, 0xa7f26836f282b732, 0x8e6cac7768d7141e,
+    0xd1ef0244af2364ff, 0x3207d795430cd926, 0x8335616aed761f1f, 0x7f44e6bd49e807b8,
+    0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6, 0xcd036837130890a1, 0x36dba887c37a8c0f,
+    0x802221226be55a64, 0xc2494954da2c9789, 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c,
+    0xc83553c5c8965d3d, 0x6f92829494e5acc7, 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9,
+    0x9c69a97284b578d7, 0xff2a760414536efb, 0xc38413cf25e2d70d, 0xfef5138519684aba,
+    0xf46518c2ef5b8cd1, 0x7eb258665fc25d69, 0x98bf2f79d5993802, 0xef2f773ffbd97a61,
+    0xbeeefb584aff8603, 0xaafb550ffacfd8fa, 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38,
+    0x952ab45cfa97a0b2, 0xdd945a747bf26183, 0xba756174393d88df, 0x94f971119aeef9e4,
+    0xe912b9d1478ceb17, 0x7a37cd5601aab85d, 0x91abb422ccb812ee, 0xac62e055c10ab33a,
+    0xb616a12b7fe617aa, 0x577b986b314d6009, 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b,
+    0x8e41ade9fbebc27d, 0x14588f13be847307, 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8,
+    0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb, 0x8aec23d680043bee, 0x25de7bb9480d5854,
+    0xada72ccc20054ae9, 0xaf561aa79a10ae6a, 0xd910f7ff28069da4, 0x1b2ba1518094da04,
+    0x87aa9aff79042286, 0x90fb44d2f05d0842, 0xa99541bf57452b28, 0x353a1607ac744a53,
+    0xd3fa922f2d1675f2, 0x42889b8997915ce8, 0x847c9b5d7c2e09b7, 0x69956135febada11,
+    0xa59bc234db398c25, 0x43fab9837e699095, 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb,
+    0x8161afb94b44f57d, 0x1d1be0eebac278f5, 0xa1ba1ba79e1632dc, 0x6462d92a69731732,
+    0xca28a291859bbf93, 0x7d7b8f7503cfdcfe, 0xfcb2cb35e702af78, 0x5cda735244c3d43e,
+    0x9defbf01b061adab, 0x3a0888136afa64a7, 0xc56baec21c7a1916, 0x088aaa1845b8fdd0,
+    0xf6c69a72a3989f5b, 0x8aad549e57273d45, 0x9a3c2087a63f6399, 0x36ac54e2f678864b,
+    0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd, 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5,
+    0x969eb7c47859e743, 0x9f644ae5a4b1b325, 0xbc4665b596706114, 0x873d5d9f0dde1fee,
+    0xeb57ff22fc0c7959, 0xa90cb506d155a7ea, 0x9316ff75dd87cbd8, 0x09a7f12442d588f2,
+    0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f, 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa,
+    0x8fa475791a569d10, 0xf96e017d694487bc, 0xb38d92d760ec4455, 0x37c981dcc395a9ac,
+    0xe070f78d3927556a, 0x85bbe253f47b1417, 0x8c469ab843b89562, 0x93956d7478ccec8e,
+    0xaf58416654a6babb, 0x387ac8d1970027b2, 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e,
+    0x88fcf317f22241e2, 0x441fece3bdf81f03, 0xab3c2fddeeaad25a, 0xd527e81cad7626c3,
+    0xd60b3bd56a5586f1, 0x8a71e223d8d3b074, 0x85c7056562757456, 0xf6872d5667844e49,
+    0xa738c6bebb12d16c, 0xb428f8ac016561db, 0xd106f86e69d785c7, 0xe13336d701beba52,
+    0x82a45b450226b39c, 0xecc0024661173473, 0xa34d721642b06084, 0x27f002d7f95d0190,
+    0xcc20ce9bd35c78a5, 0x31ec038df7b441f4, 0xff290242c83396ce, 0x7e67047175a15271,
+    0x9f79a169bd203e41, 0x0f0062c6e984d386, 0xc75809c42c684dd1, 0x52c07b78a3e60868,
+    0xf92e0c3537826145, 0xa7709a56ccdf8a82, 0x9bbcc7a142b17ccb, 0x88a66076400bb691,
+    0xc2abf989935ddbfe, 0x6acff893d00ea435, 0xf356f7ebf83552fe, 0x0583f6b8c4124d43,
+    0x98165af37b2153de, 0xc3727a337a8b704a, 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c,
+    0xeda2ee1c7064130c, 0x1162def06f79df73, 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8,
+    0xb9a74a0637ce2ee1, 0x6d953e2bd7173692, 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437,
+    0x910ab1d4db9914a0, 0x1d9c9892400a22a2, 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b,
+    0xe2a0b5dc971f303a, 0x2e44ae64840fd61d, 0x8da471a9de737e24, 0x5ceaecfed289e5d2,
+    0xb10d8e1456105dad, 0x7425a83e872c5f47, 0xdd50f1996b947518, 0xd12f124e28f77719,
+    0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f, 0xace73cbfdc0bfb7b, 0x636cc64d1001550b,
+    0xd8210befd30efa5a, 0x3c47f7e05401aa4e, 0x8714a775e3e95c78, 0x65acfaec34810a71,
+    0xa8d9d1535ce3b396, 0x7f1839a741a14d0d, 0xd31045a8341ca07c, 0x1ede48111209a050,
+    0x83ea2b892091e44d, 0x934aed0aab460432, 0xa4e4b66b68b65d60, 0xf81da84d5617853f,
+    0xce1de40642e3f4b9, 0x36251260ab9d668e, 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019,
+    0xa1075a24e4421730, 0xb24cf65b8612f81f, 0xc94930ae1d529cfc, 0xdee033f26797b627,
+    0xfb9b7cd9a4a7443c, 0x169840ef017da3b1, 0x9d412e0806e88aa5, 0x8e1f289560ee864e,
+    0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2, 0xf5b5d7ec8acb58a2, 0xae10af696774b1db,
+    0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29, 0xbff610b0cc6edd3f, 0x17fd090a58d32af3,
+    0xeff394dcff8a948e, 0xddfc4b4cef07f5b0, 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e,
+    0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1, 0xea53df5fd18d5513, 0x84c86189216dc5ed,
+    0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4, 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1,
+    0xe4d5e82392a40515, 0x0fabaf3feaa5334a, 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e,
+    0xb2c71d5bca9023f8, 0x743e20e9ef511012, 0xdf78e4b2bd342cf6, 0x914da9246b255416,
+    0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e, 0xae9672aba3d0c320, 0xa184ac2473b529b1,
+    0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e, 0x8865899617fb1871, 0x7e2fa67c7a658892,
+    0xaa7eebfb9df9de8d, 0xddbb901b98feeab7, 0xd51ea6fa85785631, 0x552a74227f3ea565,
+    0x8533285c936b35de, 0xd53a88958f87275f, 0xa67ff273b8460356, 0x8a892abaf368f137,
+    0xd01fef10a657842c, 0x2d2b7569b0432d85, 0x8213f56a67f6b29b, 0x9c3b29620e29fc73,
+    0xa298f2c501f45f42, 0x8349f3ba91b47b8f, 0xcb3f2f7642717713, 0x241c70a936219a73,
+    0xfe0efb53d30dd4d7, 0xed238cd383aa0110, 0x9ec95d1463e8a506, 0xf4363804324a40aa,
+    0xc67bb4597ce2ce48, 0xb143c6053edcd0d5, 0xf81aa16fdc1b81da, 0xdd94b7868e94050a,
+    0x9b10a4e5e9913128, 0xca7cf2b4191c8326, 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0,
+    0xf24a01a73cf2dccf, 0xbc633b39673c8cec, 0x976e41088617ca01, 0xd5be0503e085d813,
+    0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18, 0xec9c459d51852ba2, 0xddf8e7d60ed1219e,
+    0x93e1ab8252f33b45, 0xcabb90e5c942b503, 0xb8da1662e7b00a17, 0x3d6a751f3b936243,
+    0xe7109bfba19c0c9d, 0x0cc512670a783ad4, 0x906a617d450187e2, 0x27fb2b80668b24c5,
+    0xb484f9dc9641e9da, 0xb1f9f660802dedf6, 0xe1a63853bbd26451, 0x5e7873f8a0396973,
+    0x8d07e33455637eb2, 0xdb0b487b6423e1e8, 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62,
+    0xdc5c5301c56b75f7, 0x7641a140cc7810fb, 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d,
+    0xac2820d9623bf429, 0x546345fa9fbdcd44, 0xd732290fbacaf133, 0xa97c177947ad4095,
+    0x867f59a9d4bed6c0, 0x49ed8eabcccc485d, 0xa81f301449ee8c70, 0x5c68f256bfff5a74,
+    0xd226fc195c6a2f8c, 0x73832eec6fff3111, 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab,
+    0xa42e74f3d032f525, 0xba3e7ca8b77f5e55, 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb,
+    0x80444b5e7aa7cf85, 0x7980d163cf5b81b3, 0xa0555e361951c366, 0xd7e105bcc332621f,
+    0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7, 0xfa856334878fc150, 0xb14f98f6f0feb951,
+    0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3, 0xc3b8358109e84f07, 0x0a862f80ec4700c8,
+    0xf4a642e14c6262c8, 0xcd27bb612758c0fa, 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c,
+    0xbf21e44003acdd2c, 0xe0470a63e6bd56c3, 0xeeea5d5004981478, 0x1858ccfce06cac74,
+    0x95527a5202df0ccb, 0x0f37801e0c43ebc8, 0xbaa718e68396cffd, 0xd30560258f54e6ba,
+    0xe950df20247c83fd, 0x47c6b82ef32a2069, 0x91d28b7416cdd27e, 0x4cdc331d57fa5441,
+    0xb6472e511c81471d, 0xe0133fe4adf8e952, 0xe3d8f9e563a198e5, 0x58180fddd97723a6,
+    0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648,
+};
+
+static const double POW10_EXACT[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// 64位乘64位得到128位结果
+static void mul128(uint64_t a, uint64_t b, uint64_t* hi, uint64_t* lo) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    *lo = (uint64_t)r;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    *lo = (mid << 32) | (uint32_t)ll;
+#endif
+}
+
+inline int CLZ64(uint64_t x) {
+    assert(x != 0);
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return 63 - (int)i;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+// 由尾数和二进制指数拼出double，power2为偏置后的指数
+static double make_double(bool negative, uint64_t mantissa, int power2) {
+    uint64_t bits = (mantissa & ((uint64_t(1) << DOUBLE_MANTISSA_BITS) - 1)) | (uint64_t)power2 << DOUBLE_MANTISSA_BITS;
+    if (negative) {
+        bits |= uint64_t(1) << 63;
     }
-    // 校验第一个数字
-    if (*p == '0') {
-        // 第一个数字为'0'，则这个数字应该是0，跟负号处理相同
-        ++p;
-    } else {
-        // 否则需要保证第一个数字为1-9中的一个
-        if (!ISDIGIT1TO9(*p)) {
-            return PARSE_INVALID_VALUE;
-        }
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
 
-        // 跳过所有数字即可
-        for (++p; ISDIGIT(*p); ++p) {}
+// Eisel-Lemire算法，计算w * 10^q，结果写入*mantissa和*power2
+static void eisel_lemire(int64_t q, uint64_t w, uint64_t* mantissa, int* power2) {
+    if (w == 0 || q < POW5_MIN_EXPONENT) {
+        *mantissa = 0;
+        *power2 = 0;
+        return;
+    }
+    if (q > POW5_MAX_EXPONENT) {
+        *mantissa = 0;
+        *power2 = DOUBLE_INFINITE_POWER;
+        return;
     }
+    int lz = CLZ64(w);
+    w <<= lz;
 
-    // 出现小数点要跳过
-    if (*p == '.') {
-        ++p;
-        // 小数点后需保证有数字
-        if (!ISDIGIT(*p)) {
-            return PARSE_INVALID_VALUE;
+    // 乘以5^q的高64位，低位可能影响结果时再乘上低64位修正
+    const int index = 2 * (int)(q - POW5_MIN_EXPONENT);
+    const uint64_t precision_mask = UINT64_MAX >> (DOUBLE_MANTISSA_BITS + 3);
+    uint64_t hi, lo;
+    mul128(w, POW5_128[index], &hi, &lo);
+    if ((hi & precision_mask) == precision_mask) {
+        uint64_t hi2, lo2;
+        mul128(w, POW5_128[index + 1], &hi2, &lo2);
+        lo += hi2;
+        if (hi2 > lo) {
+            ++hi;
         }
-        for (++p; ISDIGIT(*p); ++p) {}
     }
 
-    // 如果出现大小写E，则表示存在指数部分，跳过E之后可以有一个正或负号，有的话就跳过
-    if (*p == 'E' || *p == 'e') {
-        ++p;
-        if (*p == '+' || *p == '-')
-            ++p;
-        // E之后必须有数字
-        if (!ISDIGIT(*p)) {
-            return PARSE_INVALID_VALUE;
+    int upperbit = (int)(hi >> 63);
+    int shift = upperbit + 64 - DOUBLE_MANTISSA_BITS - 3;
+    uint64_t m = hi >> shift;
+    // floor(log2(10^q)) = floor(q * log2(10)) + 63，-1023为double的最小指数
+    int p2 = (int)((((152170 + 65536) * q) >> 16) + 63) + upperbit - lz + 1023;
+    if (p2 <= 0) {
+        // 非规格化数
+        if (-p2 + 1 >= 64) {
+            *mantissa = 0;
+            *power2 = 0;
+            return;
         }
-        for (++p; ISDIGIT(*p); ++p) {}
+        m >>= -p2 + 1;
+        m += m & 1;
+        m >>= 1;
+        *mantissa = m;
+        *power2 = m < (uint64_t(1) << DOUBLE_MANTISSA_BITS) ? 0 : 1;
+        return;
     }
-
-    errno = 0;
-    v->u.n = strtod(c->json, nullptr);
-    if (errno == ERANGE && (v->u.n == HUGE_VAL || v->u.n == -HUGE_VAL)) {
-        return PARSE_NUMBER_TOO_BIG;
+    // 恰好位于两个double中间时要向偶数舍入，只有q在[-4, 23]内时才可能精确落在中间
+    if (lo <= 1 && q >= -4 && q <= 23 && (m & 3) == 1 && (m << shift) == hi) {
+        m &= ~uint64_t(1);
     }
-
-    c->json = p;
-    v->tiny_type = NUMBER;
-    return PARSE_OK;
+    m += m & 1;
+    m >>= 1;
+    if (m >= (uint64_t(2) << DOUBLE_MANTISSA_BITS)) {
+        m = uint64_t(1) << DOUBLE_MANTISSA_BITS;
+        ++p2;
+    }
+    m &= ~(uint64_t(1) << DOUBLE_MANTISSA_BITS);
+    if (p2 >= DOUBLE_INFINITE_POWER) {
+        p2 = DOUBLE_INFINITE_POWER;
+        m = 0;
+    }
+    *mantissa = m;
+    *power2 = p2;
 }
 
-#define STRING_ERROR(ret)                                                                                              \
-    do {                                                                                                               \
-        c->top = head;                                                                                                 \
-        return ret;                                                                                                    \
-    } while (0)
+/* 高精度十进制数，用于有效数字过多时的精确转换
+ * 表示的值为0.d[0]d[1]...d[nd-1] * 10^dp，trunc表示超出容量的部分存在非0数字
+ */
+const int DECIMAL_MAX_DIGITS = 800;
+const int DECIMAL_MAX_SHIFT = 60;
 
-static const char* parse_hex4(const char* p, unsigned int* u) {
-    int i;
-    *u = 0;
-    for (i = 0; i < 4; ++i) {
-        char ch = *p++;
-        *u <<= 4;
-        if (ISDIGIT(ch)) {
-            *u |= ch - '0';
-        } else if (ISALPHA_ATOF(ch)) {
-            *u |= ch - 'A' + 0xa;
-        } else if (ISALPHA_aTOf(ch)) {
-            *u |= ch - 'a' + 0xa;
-        } else {
-            return nullptr;
+typedef struct {
+    unsigned char d[DECIMAL_MAX_DIGITS];
+    int nd, dp;
+    bool trunc;
+} decimal;
+
+static void decimal_trim(decimal* a) {
+    while (a->nd > 0 && a->d[a->nd - 1] == 0) {
+        --a->nd;
+    }
+    if (a->nd == 0) {
+        a->dp = 0;
+    }
+}
+
+// 乘以2^k，k不超过DECIMAL_MAX_SHIFT
+static void decimal_left_shift(decimal* a, unsigned int k) {
+    unsigned char buf[DECIMAL_MAX_DIGITS + 20];
+    int w = (int)sizeof(buf);
+    uint64_t n = 0;
+    for (int r = a->nd - 1; r >= 0; --r) {
+        n += (uint64_t)a->d[r] << k;
+        buf[--w] = (unsigned char)(n % 10);
+        n /= 10;
+    }
+    while (n > 0) {
+        buf[--w] = (unsigned char)(n % 10);
+        n /= 10;
+    }
+    int nd = (int)sizeof(buf) - w;
+    a->dp += nd - a->nd;
+    if (nd > DECIMAL_MAX_DIGITS) {
+        for (int i = DECIMAL_MAX_DIGITS; i < nd; ++i) {
+            if (buf[w + i] != 0) {
+                a->trunc = true;
+            }
         }
+        nd = DECIMAL_MAX_DIGITS;
     }
-    return p;
+    memcpy(a->d, buf + w, nd);
+    a->nd = nd;
+    decimal_trim(a);
 }
 
-static void encode_utf8(context* c, unsigned int u) {
-    if (u <= 0x7f) {
-        // 通过判断可以保证u是小于256的，不会产生截断，为避免编译器警告与上0xff，编译时编译器会进行优化忽略掉这个操作
+// 除以2^k，k不超过DECIMAL_MAX_SHIFT
+static void decimal_right_shift(decimal* a, unsigned int k) {
+    int r = 0, w = 0;
+    uint64_t n = 0;
+    for (; (n >> k) == 0; ++r) {
+        if (r >= a->nd) {
+            if (n == 0) {
+                a->nd = 0;
+                return;
+            }
+            while ((n >> k) == 0) {
+                n *= 10;
+                ++r;
+            }
+            break;
+        }
+        n = n * 10 + a->d[r];
+    }
+    a->dp -= r - 1;
+    const uint64_t mask = (uint64_t(1) << k) - 1;
+    for (; r < a->nd; ++r) {
+        a->d[w++] = (unsigned char)(n >> k);
+        n = (n & mask) * 10 + a->d[r];
+    }
+    while (n > 0) {
+        unsigned char dig = (unsigned char)(n >> k);
+        n = (n & mask) * 10;
+        if (w < DECIMAL_MAX_DIGITS) {
+            a->d[w++] = dig;
+        } else if (dig > 0) {
+            a->trunc = true;
+        }
+    }
+    a->nd = w;
+    decimal_trim(a);
+}
+
+static void decimal_shift(decimal* a, int k) {
+    if (a->nd == 0) {
+        return;
+    }
+    for (; k > DECIMAL_MAX_SHIFT; k -= DECIMAL_MAX_SHIFT) {
+        decimal_left_shift(a, DECIMAL_MAX_SHIFT);
+    }
+    for (; k < -DECIMAL_MAX_SHIFT; k += DECIMAL_MAX_SHIFT) {
+        decimal_right_shift(a, DECIMAL_MAX_SHIFT);
+    }
+    if (k > 0) {
+        decimal_left_shift(a, k);
+    } else if (k < 0) {
+        decimal_right_shift(a, -k);
+    }
+}
+
+// 取整数部分，按四舍六入五成双舍入
+static uint64_t decimal_rounded_integer(const decimal* a) {
+    if (a->dp > 20) {
+        return UINT64_MAX;
+    }
+    uint64_t n = 0;
+    int i;
+    for (i = 0; i < a->dp && i < a->nd; ++i) {
+        n = n * 10 + a->d[i];
+    }
+    for (; i < a->dp; ++i) {
+        n *= 10;
+    }
+    bool round_up = false;
+    if (a->dp >= 0 && a->dp < a->nd) {
+        if (a->d[a->dp] == 5 && a->dp + 1 == a->nd) {
+            round_up = a->trunc || (a->dp > 0 && (a->d[a->dp - 1] & 1));
+        } else {
+            round_up = a->d[a->dp] >= 5;
+        }
+    }
+    return round_up ? n + 1 : n;
+}
+
+// 把十进制数转换为double的尾数和偏置后的指数
+static void decimal_to_double(decimal* a, uint64_t* mantissa, int* power2) {
+    static const int POWTAB[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+    const int POWTAB_SIZE = (int)(sizeof(POWTAB) / sizeof(POWTAB[0]));
+    const int BIAS = -1023;
+    int exp = 0;
+    uint64_t m;
+    if (a->nd == 0 || a->dp < -330) {
+        *mantissa = 0;
+        *power2 = 0;
+        return;
+    }
+    if (a->dp > 310) {
+        *mantissa = 0;
+        *power2 = DOUBLE_INFINITE_POWER;
+        return;
+    }
+    // 用2的幂缩放到[0.5, 1)之间
+    while (a->dp > 0) {
+        int n = a->dp >= POWTAB_SIZE ? 27 : POWTAB[a->dp];
+        decimal_shift(a, -n);
+        exp += n;
+    }
+    while (a->dp < 0 || (a->dp == 0 && a->d[0] < 5)) {
+        int n = -a->dp >= POWTAB_SIZE ? 27 : POWTAB[-a->dp];
+        decimal_shift(a, n);
+        exp -= n;
+    }
+    // 范围从[0.5, 1)变为double的[1, 2)
+    --exp;
+    if (exp < BIAS + 1) {
+        int n = BIAS + 1 - exp;
+        decimal_shift(a, -n);
+        exp += n;
+    }
+    if (exp - BIAS >= DOUBLE_INFINITE_POWER) {
+        *mantissa = 0;
+        *power2 = DOUBLE_INFINITE_POWER;
+        return;
+    }
+    decimal_shift(a, 1 + DOUBLE_MANTISSA_BITS);
+    m = decimal_rounded_integer(a);
+    // 舍入可能进位，需要再右移一位
+    if (m == (uint64_t(2) << DOUBLE_MANTISSA_BITS)) {
+        m >>= 1;
+        ++exp;
+        if (exp - BIAS >= DOUBLE_INFINITE_POWER) {
+            *mantissa = 0;
+            *power2 = DOUBLE_INFINITE_POWER;
+            return;
+        }
+    }
+    if (!(m & (uint64_t(1) << DOUBLE_MANTISSA_BITS))) {
+        exp = BIAS; // 非规格化数
+    }
+    *mantissa = m;
+    *power2 = exp - BIAS;
+}
+
+// 慢速路径：按原文把所有数字读入高精度十进制数再转换，p和end为已经校验过的数字
+static double parse_number_slow(const char* p, const char* end, bool negative) {
+    decimal a;
+    a.nd = a.dp = 0;
+    a.trunc = false;
+    if (*p == '-') {
+        ++p;
+    }
+    bool fraction = false;
+    for (; p != end && *p != 'e' && *p != 'E'; ++p) {
+        if (*p == '.') {
+            fraction = true;
+            continue;
+        }
+        unsigned char d = (unsigned char)(*p - '0');
+        if (a.nd == 0 && d == 0) {
+            // 前导0不是有效数字，小数部分的前导0使小数点左移
+            if (fraction) {
+                --a.dp;
+            }
+            continue;
+        }
+        if (a.nd < DECIMAL_MAX_DIGITS) {
+            a.d[a.nd++] = d;
+        } else if (d != 0) {
+            a.trunc = true;
+        }
+        if (!fraction) {
+            ++a.dp;
+        }
+    }
+    if (p != end) {
+        bool exp_negative = false;
+        int exp = 0;
+        ++p;
+        if (*p == '+' || *p == '-') {
+            exp_negative = *p++ == '-';
+        }
+        for (; p != end; ++p) {
+            if (exp < 100000) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        a.dp += exp_negative ? -exp : exp;
+    }
+    decimal_trim(&a);
+    uint64_t mantissa;
+    int power2;
+    decimal_to_double(&a, &mantissa, &power2);
+    return make_double(negative, mantissa, power2);
+}
+
+// 计算(-1)^negative * w * 10^exp10，truncated时用[begin, end)中的原文做精确转换
+static double number_to_double(bool negative, uint64_t w, int64_t exp10, bool truncated, const char* begin,
+                               const char* end) {
+    if (w == 0) {
+        return negative ? -0.0 : 0.0;
+    }
+    if (!truncated && w <= (uint64_t(1) << 53) && exp10 >= -22 && exp10 <= 22) {
+        double n = (double)w;
+        n = exp10 < 0 ? n / POW10_EXACT[-exp10] : n * POW10_EXACT[exp10];
+        return negative ? -n : n;
+    }
+    uint64_t mantissa, mantissa2;
+    int power2, power2_2;
+    eisel_lemire(exp10, w, &mantissa, &power2);
+    if (truncated) {
+        // 真实值介于w和w+1之间，两者结果相同时才能确定，否则走慢速路径
+        eisel_lemire(exp10, w + 1, &mantissa2, &power2_2);
+        if (mantissa != mantissa2 || power2 != power2_2) {
+            return parse_number_slow(begin, end, negative);
+        }
+    }
+    return make_double(negative, mantissa, power2);
+}
+
+static int parse_number(context* c, value* v) {
+    const char* p = c->json;
+    const char* end = c->end;
+    bool negative = false;
+    uint64_t w = 0;         // 前19位有效数字
+    int digits = 0;         // w中有效数字的个数
+    int64_t exp10 = 0;      // 数值等于w * 10^exp10
+    bool truncated = false; // 超过19位的部分存在非0数字
+    // 数字合法性校验
+    // 负号直接跳过即可
+    if (p != end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    // 校验第一个数字
+    if (p != end && *p == '0') {
+        // 第一个数字为'0'，则这个数字应该是0，跟负号处理相同
+        ++p;
+    } else {
+        // 否则需要保证第一个数字为1-9中的一个
+        if (p == end || !ISDIGIT1TO9(*p)) {
+            return PARSE_INVALID_VALUE;
+        }
+
+        // 跳过所有数字，同时累积有效数字
+        for (; p != end && ISDIGIT(*p); ++p) {
+            if (digits < NUMBER_MAX_DIGITS) {
+                w = w * 10 + (*p - '0');
+                ++digits;
+            } else {
+                truncated |= *p != '0';
+                ++exp10;
+            }
+        }
+    }
+
+    // 出现小数点要跳过
+    if (p != end && *p == '.') {
+        ++p;
+        // 小数点后需保证有数字
+        if (p == end || !ISDIGIT(*p)) {
+            return PARSE_INVALID_VALUE;
+        }
+        for (; p != end && ISDIGIT(*p); ++p) {
+            if (digits < NUMBER_MAX_DIGITS) {
+                // 小数部分的前导0不是有效数字
+                if (w != 0 || *p != '0') {
+                    w = w * 10 + (*p - '0');
+                    ++digits;
+                }
+                --exp10;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+
+    // 如果出现大小写E，则表示存在指数部分，跳过E之后可以有一个正或负号，有的话就跳过
+    if (p != end && (*p == 'E' || *p == 'e')) {
+        bool exp_negative = false;
+        int64_t exp = 0;
+        ++p;
+        if (p != end && (*p == '+' || *p == '-')) {
+            exp_negative = *p++ == '-';
+        }
+        // E之后必须有数字
+        if (p == end || !ISDIGIT(*p)) {
+            return PARSE_INVALID_VALUE;
+        }
+        for (; p != end && ISDIGIT(*p); ++p) {
+            // 指数足够大时结果已经确定是0或无穷大，不再累积以免溢出
+            if (exp < 100000) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        exp10 += exp_negative ? -exp : exp;
+    }
+
+    double n = number_to_double(negative, w, exp10, truncated, c->json, p);
+    if (n == HUGE_VAL || n == -HUGE_VAL) {
+        return PARSE_NUMBER_TOO_BIG;
+    }
+
+    v->u.n = n;
+    c->json = p;
+    v->tiny_type = NUMBER;
+    return PARSE_OK;
+}
+
+#define STRING_ERROR(ret)                                                                                              \
+    do {                                                                                                               \
+        c->top = head;                                                                                                 \
+        return ret;                                                                                                    \
+    } while (0)
+
+static const char* parse_hex4(const char* p, const char* end, unsigned int* u) {
+    int i;
+    *u = 0;
+    if (end - p < 4) {
+        return nullptr;
+    }
+    for (i = 0; i < 4; ++i) {
+        char ch = *p++;
+        *u <<= 4;
+        if (ISDIGIT(ch)) {
+            *u |= ch - '0';
+        } else if (ISALPHA_ATOF(ch)) {
+            *u |= ch - 'A' + 0xa;
+        } else if (ISALPHA_aTOf(ch)) {
+            *u |= ch - 'a' + 0xa;
+        } else {
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+static void encode_utf8(context* c, unsigned int u) {
+    if (u <= 0x7f) {
+        // 通过判断可以保证u是小于256的，不会产生截断，为避免编译器警告与上0xff，编译时编译器会进行优化忽略掉这个操作
         PUTC(c, u & 0xff);
     } else if (u <= 0x7ff) {
         PUTC(c, 0xc0 | ((u >> 6) & 0xff));
@@ -235,13 +1494,101 @@ static void encode_utf8(context* c, unsigned int u) {
     }
 }
 
-static int parse_string_raw(context* c, char** str, size_t* len) {
+// 返回p之后第一个需要特殊处理的字符（双引号、反斜杠或控制字符）的位置，没有则返回end
+static const char* scan_string_scalar(const char* p, const char* end) {
+    while (p != end && *p != '\"' && *p != '\\' && (unsigned char)*p >= 0x20) {
+        ++p;
+    }
+    return p;
+}
+
+#ifdef TINYJSON_SSE2
+// 每次检查16个字节，只在剩余字节足够时才整块读取，不会越过end
+static const char* scan_string_sse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    while (end - p >= 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)p);
+        // 无符号比较s <= 0x1f等价于max(s, 0x1f) == 0x1f
+        __m128i x = _mm_or_si128(_mm_cmpeq_epi8(s, quote), _mm_cmpeq_epi8(s, backslash));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(_mm_max_epu8(s, control), control));
+        int mask = _mm_movemask_epi8(x);
+        if (mask != 0) {
+            return p + CTZ(mask);
+        }
+        p += 16;
+    }
+    return scan_string_scalar(p, end);
+}
+#endif
+
+#ifdef TINYJSON_AVX2
+__attribute__((target("avx2"))) static const char* scan_string_avx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1f);
+    while (end - p >= 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)p);
+        __m256i x = _mm256_or_si256(_mm256_cmpeq_epi8(s, quote), _mm256_cmpeq_epi8(s, backslash));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(_mm256_max_epu8(s, control), control));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(x);
+        if (mask != 0) {
+            return p + CTZ(mask);
+        }
+        p += 32;
+    }
+    return scan_string_sse2(p, end);
+}
+#endif
+
+typedef const char* (*scan_string_fn)(const char* p, const char* end);
+
+// 根据CPU支持的指令集选择实现，只在第一次调用时检测
+static scan_string_fn select_scan_string() {
+#ifdef TINYJSON_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return scan_string_avx2;
+    }
+#endif
+#ifdef TINYJSON_SSE2
+    return scan_string_sse2;
+#else
+    return scan_string_scalar;
+#endif
+}
+
+static const char* scan_string(const char* p, const char* end) {
+    static const scan_string_fn fn = select_scan_string();
+    return fn(p, end);
+}
+
+// 解析字符串，不含转义时*str直接指向输入缓冲区并且*in_input为true，否则*str指向context的堆栈
+static int parse_string_raw(context* c, const char** str, size_t* len, bool* in_input) {
     size_t head = c->top;
     const char* p;
     EXPECT(c, '\"'); // 匹配到开始的双引号
     p = c->json;
+    *in_input = false;
     for (;;) {
         unsigned int u, u2;
+        // 批量跳过连续的普通字符，整段拷贝到堆栈中
+        const char* q = scan_string(p, c->end);
+        if (p == c->json && q != c->end && *q == '\"') {
+            // 第一段普通字符之后紧接着就是结束的双引号，说明字符串不含转义，直接引用输入缓冲区
+            *str = p;
+            *len = q - p;
+            *in_input = true;
+            c->json = q + 1;
+            return PARSE_OK;
+        }
+        if (q != p) {
+            PUTS(c, p, q - p);
+            p = q;
+        }
+        if (p == c->end) {
+            STRING_ERROR(PARSE_MISS_QUOTATION_MARK);
+        }
         char ch = *p++;
         switch (ch) {
         case '\"': // 匹配到结束的双引号
@@ -250,19 +1597,22 @@ static int parse_string_raw(context* c, char** str, size_t* len) {
             c->json = p;
             return PARSE_OK;
         case '\\': // 第一个\是转义负号，表示这个字符是'\'
+            if (p == c->end) {
+                STRING_ERROR(PARSE_MISS_QUOTATION_MARK);
+            }
             switch (*p++) {
             case 'u': // 处理UTF-8编码
-                if (!(p = parse_hex4(p, &u))) {
+                if (!(p = parse_hex4(p, c->end, &u))) {
                     STRING_ERROR(PARSE_INVALID_UNICODE_HEX);
                 }
                 if (u >= 0xd800 && u <= 0xdbff) {
-                    if (*p++ != '\\') {
+                    if (c->end - p < 2 || *p++ != '\\') {
                         STRING_ERROR(PARSE_INVALID_UNICODE_SURROGATE);
                     }
                     if (*p++ != 'u') {
                         STRING_ERROR(PARSE_INVALID_UNICODE_SURROGATE);
                     }
-                    if (!(p = parse_hex4(p, &u2))) {
+                    if (!(p = parse_hex4(p, c->end, &u2))) {
                         STRING_ERROR(PARSE_INVALID_UNICODE_HEX);
                     }
                     if (u2 < 0xdc00 || u2 > 0xdfff) {
@@ -301,9 +1651,8 @@ static int parse_string_raw(context* c, char** str, size_t* len) {
             }
             break;
 
-        case '\0':
-            STRING_ERROR(PARSE_MISS_QUOTATION_MARK);
         default:
+            // 输入由长度界定，字符串中间出现的'\0'同其他控制字符一样是非法字符
             if ((unsigned char)ch < 0x20) {
                 STRING_ERROR(PARSE_INVALID_STRING_CHAR);
             }
@@ -312,144 +1661,203 @@ static int parse_string_raw(context* c, char** str, size_t* len) {
     }
 }
 
+// 把解析出的字符串拷贝到context_alloc分配的内存中，并在末尾添加'\0'
 static int parse_string(context* c, value* v) {
-    char* s;
+    const char* s;
     int ret;
     size_t len;
-    if ((ret = parse_string_raw(c, &s, &len)) == PARSE_OK) {
-        set_string(v, s, len);
+    bool in_input;
+    if ((ret = parse_string_raw(c, &s, &len, &in_input)) == PARSE_OK) {
+        if (in_input && (c->flags & PARSE_FLAG_STRING_VIEW)) {
+            v->u.s.s = (char*)s;
+            v->u.s.len = len;
+            v->tiny_flags |= VALUE_FLAG_VIEW;
+            v->tiny_type = STRING;
+        } else {
+            string_init(v, s, len, c);
+        }
     }
     return ret;
 }
 
-static int parse_value(context* c, value* v); // 前置声明
-static int parse_array(context* c, value* v) {
-    size_t i, size = 0;
-    int ret;
-    EXPECT(c, '[');
-    // 考虑到数组的空格分割特性，在三个位置添加跳过空格：检测到'['后，检测到','后，parse完元素后
-    parse_whitespace(c);
-    if (*c->json == ']') {
-        c->json++;
-        set_array(v, 0);
-        return PARSE_OK;
-    }
-    for (;;) {
-        value tmp_v;
-        tiny_init(&tmp_v);
-        if ((ret = parse_value(c, &tmp_v)) != PARSE_OK) {
-            break;
-        }
-        parse_whitespace(c);
-        /* 使用临时value变量存储解析结果再将其内存拷贝到c中而不是直接在c中的内存直接存储变量的原因：
-        因为在存储value的过程中会调用contex_push，如果发现堆栈满了会调用realloc函数，而这时如果直接在c中的内存存储变量的话，这个指针此时就已经是悬空指针，
-        后面当需要把解析结果存储到对应的内存时因为这个指针已经变成了悬空指针，就会发生错误
-        */
-        memcpy(context_push(c, sizeof(value)), &tmp_v, sizeof(value));
-        ++size;
-        if (*c->json == ',') {
-            ++c->json;
-            parse_whitespace(c);
-        } else if (*c->json == ']') {
-            ++c->json;
-            set_array(v, size);
-            v->u.a.size = size;
-            size *= sizeof(value);
-            memcpy(v->u.a.e = (value*)malloc(size), context_pop(c, size), size);
-            return PARSE_OK;
-        } else {
-            ret = PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
-            break;
-        }
-    }
+/* array/object不再递归解析：每进入一层array/object，就在context的堆栈上压入一个parse_frame，
+ * 之后解析出的元素/成员依次压在它上面，遇到结束的括号时把它们一次性拷贝到新分配的内存中，再弹出frame
+ * 所以嵌套层数只受c->max_depth限制，不会耗尽C的调用栈
+ * 设置PARSE_FLAG_IN_PLACE时，元素/成员较多的frame把它们移入自己持有的按倍数增长的块中，之后直接放入块中，结束时只需收缩这个块
+ * 小的array/object仍然使用堆栈：它们拷贝的代价很小，为它们单独增长和收缩内存块反而更慢
+ */
+const size_t NO_FRAME = (size_t)-1;
 
-    // pop堆栈中的内存并释放这块内存
-    for (i = 0; i < size; ++i) {
-        tiny_free((value*)context_pop(c, sizeof(value)));
-    }
+typedef struct {
+    size_t parent; // 外层frame在堆栈中的位置，最外层为NO_FRAME
+    size_t size;   // 已经解析出的元素/成员个数
+    member key;     // object中正在解析的成员，只使用其中的键
+    type tiny_type; // ARRAY或OBJECT
+    char* block;    // 非空时元素/成员存放在这里而不是堆栈上
+    size_t capacity;
+} parse_frame;
 
-    return ret;
+inline parse_frame* FRAME(context* c, size_t frame) { return (parse_frame*)(c->stack + frame); }
+
+// arena中的内存无法增长，设置了pool时仍然先压入堆栈
+inline bool IN_PLACE(const context* c) { return (c->flags & PARSE_FLAG_IN_PLACE) && !c->pool; }
+
+static size_t push_frame(context* c, size_t parent, type t) {
+    size_t frame = c->top;
+    parse_frame* f = (parse_frame*)context_push(c, sizeof(parse_frame));
+    f->parent = parent;
+    f->size = 0;
+    KEY_SET(&f->key, nullptr, 0, 0);
+    f->tiny_type = t;
+    f->block = nullptr;
+    f->capacity = 0;
+    return frame;
 }
 
-static int parse_object(context* c, value* v) {
-    size_t size;
-    member m;
+// 把parse_string_raw解析出的键存入m，PARSE_FLAG_STRING_VIEW时不含转义的键直接引用输入缓冲区
+static void member_key_init(context* c, member* m, const char* str, size_t len, bool in_input) {
+    if (in_input && (c->flags & PARSE_FLAG_STRING_VIEW)) {
+        KEY_SET(m, str, len, KEY_FLAG_VIEW);
+    } else {
+        key_init(m, str, len, c, c->keys);
+    }
+}
+
+// 解析object成员的 key ws ':' ws 部分，键暂存在frame中
+static int parse_member_key(context* c, size_t frame) {
+    const char* str;
+    size_t len;
+    bool in_input;
     int ret;
-    EXPECT(c, '{');
+    if (PEEK(c) != '"') {
+        return PARSE_MISS_KEY;
+    }
+    if ((ret = parse_string_raw(c, &str, &len, &in_input)) != PARSE_OK) {
+        return ret;
+    }
+    // parse_string_raw可能realloc堆栈，之后才能取frame的地址
+    member_key_init(c, &FRAME(c, frame)->key, str, len, in_input);
+
+    // parse ws colon ws
     parse_whitespace(c);
-    if (*c->json == '}') {
-        c->json++;
-        v->tiny_type = OBJECT;
-        v->u.o.size = 0;
-        v->u.o.m = nullptr;
-        return PARSE_OK;
+    if (PEEK(c) != ':') {
+        return PARSE_MISS_COLON;
     }
-    m.k = nullptr;
-    size = 0;
-    for (;;) {
-        char* str;
-        tiny_init(&m.v);
-        // parse key
-        if (*c->json != '"') {
-            ret = PARSE_MISS_KEY;
-            break;
-        }
-        if ((ret = parse_string_raw(c, &str, &m.klen)) != PARSE_OK) {
-            break;
-        }
-        memcpy(m.k = (char*)malloc(m.klen + 1), str, m.klen);
-        m.k[m.klen] = '\0';
+    c->json++;
+    parse_whitespace(c);
+    return PARSE_OK;
+}
 
-        // parse ws colon ws
-        parse_whitespace(c);
-        if (*c->json != ':') {
-            ret = PARSE_MISS_COLON;
-            break;
+// 为下一个元素/成员分配位置：默认压入堆栈，PARSE_FLAG_IN_PLACE时较多的元素/成员放在frame的块中
+static void* frame_slot(context* c, size_t frame, size_t size) {
+    parse_frame* f = FRAME(c, frame);
+    if (!f->block) {
+        if (!IN_PLACE(c) || f->size < PARSE_IN_PLACE_THRESHOLD) {
+            return context_push(c, size);
         }
-        c->json++;
-        parse_whitespace(c);
+        // 把堆栈上已有的元素/成员移入块中，这是它们唯一一次被移动
+        f->capacity = f->size * EXPAND_COEFFICIENT;
+        f->block = (char*)malloc(f->capacity * size);
+        memcpy(f->block, c->stack + frame + sizeof(parse_frame), f->size * size);
+        c->top = frame + sizeof(parse_frame);
+    } else if (f->size == f->capacity) {
+        f->capacity = f->capacity * EXPAND_COEFFICIENT;
+        f->block = (char*)realloc(f->block, f->capacity * size);
+    }
+    return f->block + f->size * size;
+}
 
-        // parse value
-        if ((ret = parse_value(c, &m.v)) != PARSE_OK) {
-            break;
-        }
-        memcpy(context_push(c, sizeof(member)), &m, sizeof(member));
-        ++size;
-        m.k = nullptr; // 所有值转移到栈上
+// 把解析完的值放入frame中，object的成员使用frame中暂存的键
+static void frame_add(context* c, size_t frame, const value* v) {
+    if (FRAME(c, frame)->tiny_type == ARRAY) {
+        memcpy(frame_slot(c, frame, sizeof(value)), v, sizeof(value));
+    } else {
+        member* m = (member*)frame_slot(c, frame, sizeof(member));
+        // frame_slot可能realloc堆栈，需要重新取frame的地址
+        parse_frame* f = FRAME(c, frame);
+        m->k = f->key.k;
+        memcpy(&m->v, v, sizeof(value));
+        KEY_SET(&f->key, nullptr, 0, 0); // 键转移到成员中
+    }
+    FRAME(c, frame)->size++;
+}
 
-        // parse ws [comma | right-curly-brace] ws，逗号或者右花括号
-        parse_whitespace(c);
-        if (*c->json == ',') {
-            c->json++;
-            parse_whitespace(c);
-        } else if (*c->json == '}') {
-            c->json++;
-            size_t s = sizeof(member) * size;
+// array/object结束，把堆栈上的元素/成员移动到v中并弹出frame，返回外层frame
+static size_t frame_finish(context* c, size_t frame, value* v) {
+    parse_frame* f = FRAME(c, frame);
+    size_t size = f->size;
+    size_t parent = f->parent;
+    if (f->block) {
+        // 元素/成员已经在最终的位置上，只需把块收缩到恰好的大小，通常不会移动
+        if (f->tiny_type == ARRAY) {
+            v->tiny_type = ARRAY;
+            v->u.a.size = v->u.a.capacity = size;
+            v->u.a.e = (value*)realloc(f->block, sizeof(value) * size);
+        } else {
             v->tiny_type = OBJECT;
             v->u.o.size = size;
-            memcpy(v->u.o.m = (member*)malloc(s), context_pop(c, s), s);
-            ret = PARSE_OK;
-            break;
-        } else {
-            ret = PARSE_MISS_COMMA_OR_CURLY_BRACKET;
-            break;
+            v->u.o.capacity = f->capacity;
+            v->u.o.m = (member*)f->block;
+            object_realloc(v, size, size >= OBJECT_INDEX_THRESHOLD);
         }
+        assert(c->top == frame + sizeof(parse_frame));
+        c->top = frame;
+        return parent;
     }
-    if (ret != PARSE_OK) {
-        // pop and free members on the stack
-        free(m.k);
-        for (int i = 0; i < size; ++i) {
-            member* m = (member*)context_pop(c, sizeof(member));
-            free(m->k);
-            tiny_free(&m->v);
+    char* elements = c->stack + frame + sizeof(parse_frame);
+    if (f->tiny_type == ARRAY) {
+        size_t s = sizeof(value) * size;
+        v->tiny_type = ARRAY;
+        v->u.a.size = v->u.a.capacity = size;
+        memcpy(v->u.a.e = (value*)context_alloc(c, s), elements, s);
+    } else {
+        size_t s = sizeof(member) * size;
+        bool indexed = size >= OBJECT_INDEX_THRESHOLD;
+        v->tiny_type = OBJECT;
+        v->u.o.size = v->u.o.capacity = size;
+        memcpy(v->u.o.m = (member*)context_alloc(c, object_block_size(size, indexed)), elements, s);
+        if (indexed) {
+            v->tiny_flags |= VALUE_FLAG_INDEXED;
+            object_build_index(v);
         }
-        v->tiny_type = TINYNULL;
     }
-    return ret;
+    assert(c->top == frame + sizeof(parse_frame) + size * (v->tiny_type == ARRAY ? sizeof(value) : sizeof(member)));
+    c->top = frame;
+    return parent;
+}
+
+// 出错时释放所有尚未结束的frame以及其中已经解析出的元素/成员
+static void frame_free_all(context* c, size_t frame) {
+    while (frame != NO_FRAME) {
+        parse_frame* f = FRAME(c, frame);
+        char* elements = f->block ? f->block : c->stack + frame + sizeof(parse_frame);
+        if (f->tiny_type == ARRAY) {
+            for (size_t i = 0; i < f->size; ++i) {
+                tiny_free((value*)elements + i);
+            }
+        } else {
+            for (size_t i = 0; i < f->size; ++i) {
+                member* m = (member*)elements + i;
+                if (!c->pool) {
+                    free_key(m);
+                }
+                tiny_free(&m->v);
+            }
+            if (!c->pool) {
+                free_key(&f->key);
+            }
+        }
+        free(f->block);
+        c->top = frame;
+        frame = f->parent;
+    }
 }
 
-/* value = null / false / true / number / string /*/
-static int parse_value(context* c, value* v) {
+/* null / false / true / number / string */
+static int parse_scalar(context* c, value* v) {
+    if (c->json == c->end) {
+        return PARSE_EXPECT_VALUE;
+    }
     switch (*c->json) {
     case 'n':
         return parse_literal(c, v, "null", TINYNULL);
@@ -457,34 +1865,121 @@ static int parse_value(context* c, value* v) {
         return parse_literal(c, v, "true", TRUE);
     case 'f':
         return parse_literal(c, v, "false", FALSE);
-    default:
-        return parse_number(c, v);
     case '"':
         return parse_string(c, v);
-    case '[':
-        return parse_array(c, v);
-    case '{':
-        return parse_object(c, v);
-    case '\0':
-        return PARSE_EXPECT_VALUE;
+    default:
+        return parse_number(c, v);
     }
 }
 
-// JSON-text = ws value ws
-int parse(value* v, const char* json) {
+/* value = null / false / true / number / string / array / object */
+static int parse_value(context* c, value* root) {
+    size_t frame = NO_FRAME;
+    size_t depth = 0;
+    int ret = PARSE_OK;
+    value v;
+    while (ret == PARSE_OK) {
+        // 解析一个值，遇到非空的array/object时压入frame，接着解析它的第一个元素
+        char ch = PEEK(c);
+        tiny_init(&v);
+        if (ch == '[' || ch == '{') {
+            if (depth == c->max_depth) {
+                ret = PARSE_TOO_DEEP;
+                break;
+            }
+            // 考虑到数组的空格分割特性，在三个位置添加跳过空格：检测到'['后，检测到','后，parse完元素后
+            c->json++;
+            parse_whitespace(c);
+            if (PEEK(c) == (ch == '[' ? ']' : '}')) {
+                c->json++;
+                if (ch == '[') {
+                    v.tiny_type = ARRAY;
+                    v.u.a.size = v.u.a.capacity = 0;
+                    v.u.a.e = nullptr;
+                } else {
+                    v.tiny_type = OBJECT;
+                    v.u.o.size = v.u.o.capacity = 0;
+                    v.u.o.m = nullptr;
+                }
+            } else {
+                ++depth;
+                frame = push_frame(c, frame, ch == '[' ? ARRAY : OBJECT);
+                if (ch == '{') {
+                    ret = parse_member_key(c, frame);
+                }
+                continue;
+            }
+        } else if ((ret = parse_scalar(c, &v)) != PARSE_OK) {
+            break;
+        }
+
+        // 值已经完整，放入外层的array/object；外层随之结束时继续向上，直到需要解析下一个值
+        for (;;) {
+            if (c->pool) {
+                v.tiny_flags |= VALUE_FLAG_ARENA;
+            }
+            if (frame == NO_FRAME) {
+                memcpy(root, &v, sizeof(value));
+                return PARSE_OK;
+            }
+            frame_add(c, frame, &v);
+            bool is_object = FRAME(c, frame)->tiny_type == OBJECT;
+
+            // parse ws [comma | right-bracket] ws
+            parse_whitespace(c);
+            ch = PEEK(c);
+            if (ch == ',') {
+                c->json++;
+                parse_whitespace(c);
+                if (is_object) {
+                    ret = parse_member_key(c, frame);
+                }
+                break;
+            }
+            if (ch != (is_object ? '}' : ']')) {
+                ret = is_object ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                break;
+            }
+            c->json++;
+            tiny_init(&v);
+            frame = frame_finish(c, frame, &v);
+            --depth;
+        }
+    }
+    frame_free_all(c, frame);
+    return ret;
+}
+
+int parse(value* v, const char* json) {
+    assert(json != nullptr);
+    return parse(v, json, strlen(json));
+}
+
+// JSON-text = ws value ws
+int parse(value* v, const char* json, size_t len) { return parse(v, json, len, nullptr); }
+
+int parse(value* v, const char* json, size_t len, const parse_options* opt) {
     context c;
-    assert(v != nullptr);
-    c.json = json;
-    c.stack = nullptr;
-    c.size = c.top = 0;
+    assert(v != nullptr && (json != nullptr || len == 0));
+    context_init(&c, json, len);
+    if (opt) {
+        c.pool = opt->pool;
+        c.flags = opt->flags;
+        c.max_depth = opt->max_depth;
+        c.keys = opt->keys;
+        if (opt->work) {
+            c.stack = opt->work->stack;
+            c.size = opt->work->size;
+        }
+    }
     tiny_init(v);
     parse_whitespace(&c);
 
     int ret;
     if ((ret = parse_value(&c, v)) == PARSE_OK) {
         parse_whitespace(&c);
-        if (*c.json != '\0') {
-            v->tiny_type = TINYNULL;
+        if (c.json != c.end) {
+            tiny_free(v);
             ret = PARSE_ROOT_NOT_SINGULAR;
         }
     }
@@ -517,428 +2012,3475 @@ int parse(value* v, const char* json) {
     }
 #endif
     assert(c.top == 0);
-    free(c.stack);
+    if (opt && opt->work) {
+        opt->work->stack = c.stack;
+        opt->work->size = c.size;
+        shrink_buffer(&opt->work->stack, &opt->work->size, opt->work->retain);
+    } else {
+        free(c.stack);
+    }
 
     return ret;
 }
 
-static void stringify_string(context* c, const char* s, size_t len) {
-    assert(s != nullptr);
-    PUTC(c, '"');
-    for (size_t i = 0; i < len; ++i) {
-        unsigned char ch = (unsigned char)s[i];
-        switch (ch) {
-        case '\"':
-            PUTS(c, "\\\"", 2);
-            break;
-        case '\\':
-            PUTS(c, "\\\\", 2);
-            break;
-        case '\b':
-            PUTS(c, "\\b", 2);
-            break;
-        case '\t':
-            PUTS(c, "\\t", 2);
-            break;
-        case '\r':
-            PUTS(c, "\\r", 2);
-            break;
-        case '\n':
-            PUTS(c, "\\n", 2);
-            break;
-        case '\f':
-            PUTS(c, "\\f", 2);
-            break;
-        default:
-            if (ch < 0x20) {
-                char buffer[7];
-                sprintf(buffer, "\\u%04X", ch);
-                PUTS(c, buffer, 6);
-            } else {
-                PUTC(c, s[i]);
-            }
-        }
+/* 单个大文档的并行解析
+ * 第一阶段建立结构索引：向量化地找出双引号、反斜杠、逗号和括号，跟踪字符串和嵌套层数，
+ * 只记录根array/object中直接的逗号，并按字节数在这些逗号处把元素/成员切成若干段
+ * 第二阶段由多个线程各自领取段来解析，元素/成员直接写入根节点最终的内存块中
+ * 索引只负责切分，每段仍由parse_value完整地校验；任何一段出错，或者索引发现结构不完整时，
+ * 丢弃已有的结果改为顺序解析，得到与parse完全相同的错误码
+ */
+const size_t PARALLEL_CHUNKS_PER_THREAD = 4; // 段数为线程数的倍数，解析较快的线程可以多领几段
+
+typedef struct {
+    const char* begin; // 段的范围[begin, end)，不含两端的逗号
+    const char* end;
+    size_t first, count; // 段中第一个元素/成员的序号和元素/成员个数
+    size_t done;         // 已经解析完成的个数，出错时只释放这些
+} parallel_chunk;
+
+typedef struct {
+    const char* skip;  // 字符串中被反斜杠转义的字符，不作为结构字符处理
+    const char* close; // 根的右括号，找到之前为nullptr
+    size_t depth;
+    size_t commas; // 根中直接的逗号个数，元素/成员的个数为commas + 1
+    bool in_string;
+    const char* chunk_begin; // 当前段的起始位置
+    size_t chunk_first, chunk_size;
+    parallel_chunk* chunks;
+    size_t nchunks, capacity;
+} structural_index;
+
+static void index_add_chunk(structural_index* x, const char* end) {
+    if (x->nchunks == x->capacity) {
+        x->capacity = x->capacity == 0 ? 16 : x->capacity * 2;
+        x->chunks = (parallel_chunk*)realloc(x->chunks, x->capacity * sizeof(parallel_chunk));
     }
-    PUTC(c, '"');
+    parallel_chunk* ch = &x->chunks[x->nchunks++];
+    ch->begin = x->chunk_begin;
+    ch->end = end;
+    ch->first = x->chunk_first;
+    ch->count = x->commas + 1 - x->chunk_first;
+    ch->done = 0;
 }
 
-static void stringify_value(context* c, const value* v) {
-    switch (v->tiny_type) {
-    case TINYNULL:
-        PUTS(c, "null", 4);
-        break;
-    case TRUE:
-        PUTS(c, "true", 4);
-        break;
-    case FALSE:
-        PUTS(c, "false", 5);
-        break;
-    case NUMBER:
-        c->top -= 32 - sprintf((char*)context_push(c, 32), "%.17g", v->u.n);
+// 处理一个可能是结构字符的字符，找到根的右括号时返回false
+inline bool index_char(structural_index* x, const char* p) {
+    if (p == x->skip) {
+        return true;
+    }
+    char ch = *p;
+    if (x->in_string) {
+        if (ch == '\\') {
+            x->skip = p + 1;
+        } else if (ch == '\"') {
+            x->in_string = false;
+        }
+        return true;
+    }
+    switch (ch) {
+    case '\"':
+        x->in_string = true;
         break;
-    case STRING:
-        stringify_string(c, v->u.s.s, v->u.s.len);
+    case '[':
+    case '{':
+        ++x->depth;
         break;
-    case ARRAY:
-        PUTC(c, '[');
-        for (size_t i = 0; i < v->u.a.size; ++i) {
-            if (i != 0) {
-                PUTC(c, ',');
-            }
-            stringify_value(c, &v->u.a.e[i]);
+    case ']':
+    case '}':
+        if (--x->depth == 0) {
+            x->close = p;
+            index_add_chunk(x, p);
+            return false;
         }
-        PUTC(c, ']');
         break;
-    case OBJECT:
-        PUTC(c, '{');
-        for (size_t i = 0; i < v->u.o.size; ++i) {
-            if (i != 0) {
-                PUTC(c, ',');
+    case ',':
+        if (x->depth == 1) {
+            if ((size_t)(p - x->chunk_begin) >= x->chunk_size) {
+                index_add_chunk(x, p);
+                x->chunk_begin = p + 1;
+                x->chunk_first = x->commas + 1;
             }
-            stringify_string(c, v->u.o.m[i].k, v->u.o.m->klen);
-            PUTC(c, ':');
-            stringify_value(c, &v->u.o.m[i].v);
+            ++x->commas;
         }
-        PUTC(c, '}');
         break;
     default:
         break;
     }
+    return true;
 }
 
-char* stringify(const value* v, size_t* len) {
-    context c;
-    assert(v != nullptr);
-    c.stack = (char*)malloc(c.size = PARSE_STACK_INIT_SIZE);
-    c.top = 0;
-    stringify_value(&c, v);
-    if (len) {
-        *len = c.top;
+static void index_structural_scalar(structural_index* x, const char* p, const char* end) {
+    while (p != end && index_char(x, p)) {
+        ++p;
     }
-    PUTC(&c, '\0');
-    return c.stack;
 }
 
-type get_type(const value* v) {
-    assert(v != nullptr);
-    return v->tiny_type;
+#ifdef TINYJSON_SSE2
+// 双引号、反斜杠、逗号和四种括号：'['和'{'、']'和'}'只差0x20这一位，或上0x20后各用一次比较
+static void index_structural_sse2(structural_index* x, const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    while (end - p >= 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)p);
+        __m128i t = _mm_or_si128(s, lower);
+        __m128i x1 = _mm_or_si128(_mm_cmpeq_epi8(s, quote), _mm_cmpeq_epi8(s, backslash));
+        __m128i x2 = _mm_or_si128(_mm_cmpeq_epi8(t, open), _mm_cmpeq_epi8(t, close));
+        x1 = _mm_or_si128(_mm_or_si128(x1, x2), _mm_cmpeq_epi8(s, comma));
+        for (unsigned int mask = (unsigned int)_mm_movemask_epi8(x1); mask != 0; mask &= mask - 1) {
+            if (!index_char(x, p + CTZ(mask))) {
+                return;
+            }
+        }
+        p += 16;
+    }
+    index_structural_scalar(x, p, end);
 }
+#endif
 
-double get_number(const value* v) {
-    assert(v != nullptr && v->tiny_type == NUMBER);
-    return v->u.n;
+#ifdef TINYJSON_AVX2
+__attribute__((target("avx2"))) static void index_structural_avx2(structural_index* x, const char* p,
+                                                                   const char* end) {
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    while (end - p >= 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)p);
+        __m256i t = _mm256_or_si256(s, lower);
+        __m256i x1 = _mm256_or_si256(_mm256_cmpeq_epi8(s, quote), _mm256_cmpeq_epi8(s, backslash));
+        __m256i x2 = _mm256_or_si256(_mm256_cmpeq_epi8(t, open), _mm256_cmpeq_epi8(t, close));
+        x1 = _mm256_or_si256(_mm256_or_si256(x1, x2), _mm256_cmpeq_epi8(s, comma));
+        for (unsigned int mask = (unsigned int)_mm256_movemask_epi8(x1); mask != 0; mask &= mask - 1) {
+            if (!index_char(x, p + CTZ(mask))) {
+                return;
+            }
+        }
+        p += 32;
+    }
+    index_structural_sse2(x, p, end);
 }
+#endif
 
-void set_number(value* v, double n) {
-    tiny_free(v);
-    v->u.n = n;
-    v->tiny_type = NUMBER;
-}
+typedef void (*index_structural_fn)(structural_index* x, const char* p, const char* end);
 
-int get_boolean(const value* v) {
-    assert(v != nullptr && (v->tiny_type == TRUE || v->tiny_type == FALSE));
-    return v->tiny_type == TRUE;
+static index_structural_fn select_index_structural() {
+#ifdef TINYJSON_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return index_structural_avx2;
+    }
+#endif
+#ifdef TINYJSON_SSE2
+    return index_structural_sse2;
+#else
+    return index_structural_scalar;
+#endif
 }
 
-void set_boolean(value* v, int b) {
-    // 先释放内存
-    tiny_free(v);
-    v->tiny_type = b ? TRUE : FALSE;
+// 从根的左括号root开始扫描，x->close为nullptr表示直到end都没有找到与之匹配的右括号
+static void index_structural(structural_index* x, const char* root, const char* end, size_t chunk_size) {
+    static const index_structural_fn fn = select_index_structural();
+    x->skip = x->close = nullptr;
+    x->depth = x->commas = 0;
+    x->in_string = false;
+    x->chunk_begin = root + 1;
+    x->chunk_first = 0;
+    x->chunk_size = chunk_size;
+    x->chunks = nullptr;
+    x->nchunks = x->capacity = 0;
+    fn(x, root, end);
 }
 
-const char* get_string(const value* v) {
-    assert(v != nullptr && v->tiny_type == STRING);
-    return v->u.s.s;
-}
+// 所有线程共享的任务，chunks中的段由next依次分配
+typedef struct {
+    parallel_chunk* chunks;
+    size_t nchunks;
+    std::atomic<size_t> next;
+    std::atomic<bool> failed;
+    value* elements; // 根为array时的元素
+    member* members; // 根为object时的成员
+    const parse_options* opt;
+} parallel_job;
 
-size_t get_string_len(const value* v) {
-    assert(v != nullptr && v->tiny_type == STRING);
-    return v->u.s.len;
+// 解析一段中的元素/成员：ws value ws *(',' ws value ws)，object的成员为 ws string ws ':' ws value ws
+static int parse_chunk(context* c, parallel_job* job, parallel_chunk* ch) {
+    for (size_t i = 0; i < ch->count; ++i) {
+        if (i > 0) {
+            if (PEEK(c) != ',') {
+                return PARSE_INVALID_VALUE;
+            }
+            c->json++;
+        }
+        parse_whitespace(c);
+        int ret;
+        if (job->members) {
+            member* m = &job->members[ch->first + i];
+            const char* str;
+            size_t len;
+            bool in_input;
+            if (PEEK(c) != '\"' || parse_string_raw(c, &str, &len, &in_input) != PARSE_OK) {
+                return PARSE_MISS_KEY;
+            }
+            member_key_init(c, m, str, len, in_input);
+            parse_whitespace(c);
+            if (PEEK(c) != ':') {
+                free_key(m);
+                return PARSE_MISS_COLON;
+            }
+            c->json++;
+            parse_whitespace(c);
+            if ((ret = parse_value(c, &m->v)) != PARSE_OK) {
+                free_key(m);
+                return ret;
+            }
+        } else if ((ret = parse_value(c, &job->elements[ch->first + i])) != PARSE_OK) {
+            return ret;
+        }
+        parse_whitespace(c);
+        ch->done++;
+    }
+    return c->json == c->end ? PARSE_OK : PARSE_INVALID_VALUE;
 }
 
-void set_string(value* v, const char* s, size_t len) {
-    assert(v != nullptr && (s != nullptr || len == 0));
-    tiny_free(v);
-    v->u.s.s = (char*)malloc(len + 1);
-    memcpy(v->u.s.s, s, len);
-    v->u.s.s[len] = '\0';
-    v->u.s.len = len;
-    v->tiny_type = STRING;
+static void parallel_worker(parallel_job* job) {
+    context c;
+    context_init(&c, nullptr, 0);
+    c.flags = job->opt->flags;
+    c.max_depth = job->opt->max_depth - 1; // 根占用了一层
+    c.keys = job->opt->keys;
+    for (size_t k; !job->failed && (k = job->next++) < job->nchunks;) {
+        parallel_chunk* ch = &job->chunks[k];
+        c.json = ch->begin;
+        c.end = ch->end;
+        if (parse_chunk(&c, job, ch) != PARSE_OK) {
+            job->failed = true;
+        }
+        assert(c.top == 0);
+    }
+    free(c.stack);
 }
 
-size_t get_array_size(const value* v) {
-    assert(v != nullptr && v->tiny_type == ARRAY);
-    return v->u.a.size;
-}
+int parse_parallel(value* v, const char* json, size_t len, unsigned int threads, const parse_options* opt) {
+    parse_options defaults;
+    assert(v != nullptr && (json != nullptr || len == 0));
+    if (opt == nullptr) {
+        parse_options_init(&defaults);
+        opt = &defaults;
+    }
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    const char *root = json, *end = json + len;
+    while (root != end && (*root == ' ' || *root == '\t' || *root == '\n' || *root == '\r')) {
+        ++root;
+    }
+    if (threads <= 1 || len < PARSE_PARALLEL_MIN_SIZE || opt->pool || opt->max_depth == 0 || root == end ||
+        (*root != '[' && *root != '{')) {
+        return parse(v, json, len, opt);
+    }
 
-size_t get_array_capacity(const value* v) {
-    assert(v != nullptr && v->tiny_type == ARRAY);
-    return v->u.a.capacity;
-}
+    structural_index x;
+    index_structural(&x, root, end, len / (threads * PARALLEL_CHUNKS_PER_THREAD) + 1);
+    const char* p = x.close ? x.close + 1 : end;
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        ++p;
+    }
+    // 括号不匹配或根之后还有其他字符，交给顺序解析报告错误
+    if (!x.close || *x.close != (*root == '[' ? ']' : '}') || p != end) {
+        free(x.chunks);
+        return parse(v, json, len, opt);
+    }
 
-void array_reserve(value* v, size_t capacity) {
-    assert(v != nullptr && v->tiny_type == ARRAY);
-    if (v->u.a.capacity >= capacity) {
-        return;
+    size_t size = x.commas + 1;
+    bool is_object = *root == '{';
+    bool indexed = is_object && size >= OBJECT_INDEX_THRESHOLD;
+    parallel_job job;
+    job.chunks = x.chunks;
+    job.nchunks = x.nchunks;
+    job.next = 0;
+    job.failed = false;
+    job.elements = is_object ? nullptr : (value*)malloc(size * sizeof(value));
+    job.members = is_object ? (member*)malloc(object_block_size(size, indexed)) : nullptr;
+    job.opt = opt;
+    unsigned int workers = (unsigned int)(x.nchunks < threads ? x.nchunks : threads) - 1;
+    std::thread* pool = new std::thread[workers];
+    for (unsigned int i = 0; i < workers; ++i) {
+        pool[i] = std::thread(parallel_worker, &job);
     }
-    v->u.a.capacity = capacity;
-    v->u.a.e = (value*)realloc(v->u.a.e, capacity * sizeof(value));
-}
+    parallel_worker(&job); // 调用线程也参与解析
+    for (unsigned int i = 0; i < workers; ++i) {
+        pool[i].join();
+    }
+    delete[] pool;
 
-void array_shrink(value* v) {
-    assert(v != nullptr && v->tiny_type == ARRAY && v->u.a.capacity >= v->u.a.size);
-    if (v->u.a.size == v->u.a.capacity) {
-        return;
+    if (job.failed) {
+        for (size_t k = 0; k < job.nchunks; ++k) {
+            for (size_t i = 0; i < job.chunks[k].done; ++i) {
+                size_t j = job.chunks[k].first + i;
+                if (is_object) {
+                    free_key(&job.members[j]);
+                    tiny_free(&job.members[j].v);
+                } else {
+                    tiny_free(&job.elements[j]);
+                }
+            }
+        }
+        free(job.elements);
+        free(job.members);
+        free(x.chunks);
+        return parse(v, json, len, opt);
     }
-    v->u.a.capacity = v->u.a.size;
-    v->u.a.e = (value*)realloc(v->u.a.e, v->u.a.capacity * sizeof(value));
+    free(x.chunks);
+    tiny_init(v);
+    if (is_object) {
+        v->tiny_type = OBJECT;
+        v->u.o.size = v->u.o.capacity = size;
+        v->u.o.m = job.members;
+        if (indexed) {
+            v->tiny_flags |= VALUE_FLAG_INDEXED;
+            object_build_index(v);
+        }
+    } else {
+        v->tiny_type = ARRAY;
+        v->u.a.size = v->u.a.capacity = size;
+        v->u.a.e = job.elements;
+    }
+    return PARSE_OK;
 }
 
-value* array_pushback(value* v) {
-    assert(v != nullptr && v->tiny_type == ARRAY);
-    if (v->u.a.size == v->u.a.capacity) {
-        array_reserve(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * EXPAND_COEFFICIENT);
-    }
-    tiny_init(&v->u.a.e[v->u.a.size]);
-    return &v->u.a.e[v->u.a.size++];
+/* 文件解析：mmap只读映射整个文件，直接在映射的内存上解析，解析器按长度工作，不需要文件以'\0'结尾
+ * mmap失败（例如管道、/proc中大小为0的文件）或者在Windows上时，改为读入堆上的缓冲区
+ */
+#ifdef _WIN32
+inline int OPEN_FILE(const char* path) { return _open(path, _O_RDONLY | _O_BINARY); }
+// _read一次最多读取INT_MAX字节
+inline long READ_FILE(int fd, char* buf, size_t len) {
+    return _read(fd, buf, (unsigned int)(len < 1u << 30 ? len : 1u << 30));
 }
+inline int CLOSE_FILE(int fd) { return _close(fd); }
+#else
+inline int OPEN_FILE(const char* path) { return open(path, O_RDONLY); }
+inline long READ_FILE(int fd, char* buf, size_t len) { return (long)read(fd, buf, len); }
+inline int CLOSE_FILE(int fd) { return close(fd); }
+#endif
 
-void array_popback(value* v) {
-    assert(v != nullptr && v->tiny_type == ARRAY && v->u.a.size > 0);
-    tiny_free(&v->u.a.e[--v->u.a.size]);
+// 读取fd的全部内容，size_hint为预计的大小，可以为0
+static int read_file(mapped_file* f, int fd, size_t size_hint) {
+    size_t capacity = size_hint > 0 ? size_hint + 1 : 4096, size = 0;
+    char* buf = (char*)malloc(capacity);
+    for (;;) {
+        if (size == capacity) {
+            capacity *= 2;
+            buf = (char*)realloc(buf, capacity);
+        }
+        long n = READ_FILE(fd, buf + size, capacity - size);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) {
+                continue;
+            }
+#endif
+            free(buf);
+            return PARSE_FILE_ERROR;
+        }
+        size += n;
+    }
+    f->data = buf;
+    f->size = size;
+    f->mapped = 0;
+    return PARSE_OK;
 }
 
-value* array_insert(value* v, size_t index) {
-    assert(v != nullptr && v->tiny_type == ARRAY && index <= v->u.a.capacity);
-    if (index == v->u.a.capacity) {
-        return array_pushback(v);
+int map_file(mapped_file* f, const char* path) {
+    assert(f != nullptr && path != nullptr);
+    f->data = nullptr;
+    f->size = 0;
+    f->mapped = 0;
+    int fd = OPEN_FILE(path);
+    if (fd < 0) {
+        return PARSE_FILE_ERROR;
     }
-    if (v->u.a.capacity < v->u.a.size + 1) {
-        array_reserve(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * EXPAND_COEFFICIENT);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        CLOSE_FILE(fd);
+        return PARSE_FILE_ERROR;
     }
-    for (size_t i = v->u.a.size + 1; i > index; --i) {
-        move(&v->u.a.e[i], &v->u.a.e[i - 1]);
+    size_t size = st.st_size > 0 ? (size_t)st.st_size : 0;
+#ifndef _WIN32
+    if (size > 0 && S_ISREG(st.st_mode)) {
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, size, MADV_SEQUENTIAL);
+            close(fd); // 映射在关闭文件后仍然有效
+            f->data = (const char*)p;
+            f->size = size;
+            f->mapped = 1;
+            return PARSE_OK;
+        }
     }
-    tiny_init(&v->u.a.e[index]);
-    ++v->u.a.size;
-    return &v->u.a.e[index];
+#endif
+    int ret = read_file(f, fd, size);
+    CLOSE_FILE(fd);
+    return ret;
 }
 
-void array_erase(value* v, size_t index, size_t count) {
-    assert(v != nullptr && v->tiny_type == ARRAY && index < v->u.a.capacity);
-
-    for (size_t i = 0; i < count; ++i) {
-        tiny_free(&v->u.a.e[index + i]);
+void unmap_file(mapped_file* f) {
+    assert(f != nullptr);
+#ifndef _WIN32
+    if (f->mapped) {
+        munmap((void*)f->data, f->size);
+    } else
+#endif
+    {
+        free((void*)f->data);
     }
+    f->data = nullptr;
+    f->size = 0;
+    f->mapped = 0;
+}
 
-    // for (size_t i = 0; i < count; ++i) {
-    //     move(&v->u.a.e[index + i], &v->u.a.e[index + count + i]);
-    // }
-    memcpy(v->u.a.e + index, v->u.a.e + index + count, (v->u.a.size - index - count) * sizeof(value));
+int parse_file(value* v, const char* path) { return parse_file(v, path, nullptr, nullptr); }
 
-    for (size_t i = v->u.a.size - count; i < v->u.a.size; ++i) {
-        tiny_free(&v->u.a.e[i]);
-    }
-    v->u.a.size -= count;
-}
+int parse_file(value* v, const char* path, const parse_options* opt) { return parse_file(v, path, opt, nullptr); }
 
-void array_clear(value* v) {
-    assert(v != nullptr && v->tiny_type == ARRAY);
-    for (size_t i = 0; i < v->u.a.size; ++i) {
-        tiny_free(&v->u.a.e[i]);
+int parse_file(value* v, const char* path, const parse_options* opt, mapped_file* f) {
+    mapped_file tmp;
+    parse_options copy;
+    assert(v != nullptr);
+    tiny_init(v);
+    if (f == nullptr) {
+        // 映射在返回前就会解除，解析结果不能引用它
+        f = &tmp;
+        if (opt && (opt->flags & PARSE_FLAG_STRING_VIEW)) {
+            copy = *opt;
+            copy.flags &= ~PARSE_FLAG_STRING_VIEW;
+            opt = &copy;
+        }
     }
-    v->u.a.size = 0;
+    int ret = map_file(f, path);
+    if (ret != PARSE_OK) {
+        return ret;
+    }
+    ret = parse(v, f->data, f->size, opt);
+    if (f == &tmp) {
+        unmap_file(&tmp);
+    }
+    return ret;
 }
 
-value* get_array_element(const value* v, size_t index) {
-    assert(v != nullptr && v->tiny_type == ARRAY);
-    assert(index < v->u.a.size);
-    return &v->u.a.e[index];
-}
+/* SAX解析：语法与parse_value相同，词法部分直接复用parse_literal/parse_number/parse_string_raw
+ * 同样不递归：每进入一层array/object在堆栈上压入一个size_t，记录类型(最低位为1表示object)和已解析的元素个数
+ * 字符串只在需要转义时写入context的堆栈，回调返回后即出栈，整个解析过程只有堆栈这一块内存
+ */
+#define SAX_EVENT(h, cb, ...)                                                                                          \
+    do {                                                                                                               \
+        if ((h)->cb && (h)->cb(__VA_ARGS__) != 0) {                                                                    \
+            return PARSE_CANCELED;                                                                                     \
+        }                                                                                                              \
+    } while (0)
 
-void set_array(value* v, size_t capacity) {
+// 解析null / false / true / number / string并产生对应的事件
+static int sax_parse_scalar(context* c, const sax_handler* h, void* user) {
+    value v; // 只用来接收标量的词法分析结果，不会分配内存
+    const char* str;
+    size_t len;
+    bool in_input;
+    int ret;
+    if (c->json == c->end) {
+        return PARSE_EXPECT_VALUE;
+    }
+    switch (*c->json) {
+    case 'n':
+        if ((ret = parse_literal(c, &v, "null", TINYNULL)) == PARSE_OK) {
+            SAX_EVENT(h, null_value, user);
+        }
+        return ret;
+    case 't':
+        if ((ret = parse_literal(c, &v, "true", TRUE)) == PARSE_OK) {
+            SAX_EVENT(h, boolean, user, 1);
+        }
+        return ret;
+    case 'f':
+        if ((ret = parse_literal(c, &v, "false", FALSE)) == PARSE_OK) {
+            SAX_EVENT(h, boolean, user, 0);
+        }
+        return ret;
+    case '"':
+        if ((ret = parse_string_raw(c, &str, &len, &in_input)) == PARSE_OK) {
+            SAX_EVENT(h, string, user, str, len);
+        }
+        return ret;
+    default:
+        if ((ret = parse_number(c, &v)) == PARSE_OK) {
+            SAX_EVENT(h, number, user, v.u.n);
+        }
+        return ret;
+    }
+}
+
+// 解析object成员的 key ws ':' ws 部分
+static int sax_parse_key(context* c, const sax_handler* h, void* user) {
+    const char* str;
+    size_t len;
+    bool in_input;
+    int ret;
+    if (PEEK(c) != '"') {
+        return PARSE_MISS_KEY;
+    }
+    if ((ret = parse_string_raw(c, &str, &len, &in_input)) != PARSE_OK) {
+        return ret;
+    }
+    SAX_EVENT(h, key, user, str, len);
+    parse_whitespace(c);
+    if (PEEK(c) != ':') {
+        return PARSE_MISS_COLON;
+    }
+    c->json++;
+    parse_whitespace(c);
+    return PARSE_OK;
+}
+
+inline size_t* SAX_LEVEL(context* c) { return (size_t*)(c->stack + c->top) - 1; }
+
+// 开始一层非空的array/object
+static int sax_begin(context* c, const sax_handler* h, void* user, bool is_object) {
+    *(size_t*)context_push(c, sizeof(size_t)) = is_object;
+    return is_object ? sax_parse_key(c, h, user) : PARSE_OK;
+}
+
+static int sax_parse_value(context* c, const sax_handler* h, void* user) {
+    int ret;
+    for (;;) {
+        // 解析一个值，遇到非空的array/object时压入一层，接着解析它的第一个元素
+        char ch = PEEK(c);
+        if (ch == '[' || ch == '{') {
+            if (c->top / sizeof(size_t) == c->max_depth) {
+                return PARSE_TOO_DEEP;
+            }
+            c->json++;
+            if (ch == '[') {
+                SAX_EVENT(h, start_array, user);
+            } else {
+                SAX_EVENT(h, start_object, user);
+            }
+            parse_whitespace(c);
+            if (PEEK(c) != (ch == '[' ? ']' : '}')) {
+                if ((ret = sax_begin(c, h, user, ch == '{')) != PARSE_OK) {
+                    return ret;
+                }
+                continue;
+            }
+            c->json++;
+            if (ch == '[') {
+                SAX_EVENT(h, end_array, user, 0);
+            } else {
+                SAX_EVENT(h, end_object, user, 0);
+            }
+        } else if ((ret = sax_parse_scalar(c, h, user)) != PARSE_OK) {
+            return ret;
+        }
+
+        // 值已经完整，计入外层的array/object；外层随之结束时继续向上
+        for (;;) {
+            if (c->top == 0) {
+                return PARSE_OK;
+            }
+            size_t* level = SAX_LEVEL(c);
+            bool is_object = *level & 1;
+            *level += 2;
+            parse_whitespace(c);
+            ch = PEEK(c);
+            if (ch == ',') {
+                c->json++;
+                parse_whitespace(c);
+                if (is_object && (ret = sax_parse_key(c, h, user)) != PARSE_OK) {
+                    return ret;
+                }
+                break;
+            }
+            if (ch != (is_object ? '}' : ']')) {
+                return is_object ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            }
+            c->json++;
+            size_t count = *(size_t*)context_pop(c, sizeof(size_t)) >> 1;
+            if (is_object) {
+                SAX_EVENT(h, end_object, user, count);
+            } else {
+                SAX_EVENT(h, end_array, user, count);
+            }
+        }
+    }
+}
+
+int sax_parse(const char* json, size_t len, const sax_handler* h, void* user) {
+    return sax_parse(json, len, h, user, nullptr);
+}
+
+int sax_parse(const char* json, size_t len, const sax_handler* h, void* user, const parse_options* opt) {
+    context c;
+    assert(h != nullptr && (json != nullptr || len == 0));
+    context_init(&c, json, len);
+    if (opt) {
+        c.max_depth = opt->max_depth;
+        if (opt->work) {
+            c.stack = opt->work->stack;
+            c.size = opt->work->size;
+        }
+    }
+    parse_whitespace(&c);
+
+    int ret;
+    if ((ret = sax_parse_value(&c, h, user)) == PARSE_OK) {
+        parse_whitespace(&c);
+        if (c.json != c.end) {
+            ret = PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    if (opt && opt->work) {
+        opt->work->stack = c.stack;
+        opt->work->size = c.size;
+        shrink_buffer(&opt->work->stack, &opt->work->size, opt->work->retain);
+    } else {
+        free(c.stack);
+    }
+    return ret;
+}
+
+/* 增量解析：逐字节推进的状态机，语法状态和尚未结束的array/object都保存在push_parser中，不依赖递归
+ * 一个token完整地出现在一块输入中时直接在输入上做词法分析，跨越块边界时先拼接到p->buf中
+ * 数字逐字节按语法判断结束位置，字符串和字面量的词法分析复用parse_string_raw/sax_parse_value，所以错误码与parse一致
+ */
+enum {
+    PUSH_VALUE,        // 期待一个值
+    PUSH_ARRAY_FIRST,  // '['之后，期待值或']'
+    PUSH_OBJECT_FIRST, // '{'之后，期待键或'}'
+    PUSH_KEY,          // object中','之后，期待键
+    PUSH_COLON,        // 键之后，期待':'
+    PUSH_AFTER_VALUE,  // 值之后，期待','或结束的括号
+    PUSH_STRING,       // 正在读取字符串，lex为1表示上一个字符是转义用的'\'
+    PUSH_KEY_STRING,   // 正在读取键，lex同上
+    PUSH_NUMBER,       // 正在读取数字，lex为NUM_*
+    PUSH_LITERAL,      // 正在读取null/true/false，lex的低4位为已匹配的字符数，高位为PUSH_LITERALS中的下标
+};
+
+// 数字的词法状态
+enum {
+    NUM_SIGN,     // 负号之后
+    NUM_ZERO,     // 整数部分为0
+    NUM_INT,      // 整数部分
+    NUM_DOT,      // 小数点之后
+    NUM_FRAC,     // 小数部分
+    NUM_EXP,      // E之后
+    NUM_EXP_SIGN, // 指数的符号之后
+    NUM_EXP_INT,  // 指数部分
+};
+
+static const char* const PUSH_LITERALS[] = {"null", "true", "false"};
+
+// ch能否接在当前的数字之后，能则更新词法状态
+static bool number_accept(unsigned int* lex, char ch) {
+    switch (*lex) {
+    case NUM_SIGN:
+        if (!ISDIGIT(ch)) {
+            return false;
+        }
+        *lex = ch == '0' ? NUM_ZERO : NUM_INT;
+        return true;
+    case NUM_INT:
+        if (ISDIGIT(ch)) {
+            return true;
+        }
+        // fallthrough
+    case NUM_ZERO:
+    case NUM_FRAC:
+        if (ch == '.' && *lex != NUM_FRAC) {
+            *lex = NUM_DOT;
+            return true;
+        }
+        if (ch == 'e' || ch == 'E') {
+            *lex = NUM_EXP;
+            return true;
+        }
+        return *lex == NUM_FRAC && ISDIGIT(ch);
+    case NUM_DOT:
+        if (!ISDIGIT(ch)) {
+            return false;
+        }
+        *lex = NUM_FRAC;
+        return true;
+    case NUM_EXP:
+        if (ch == '+' || ch == '-') {
+            *lex = NUM_EXP_SIGN;
+            return true;
+        }
+        // fallthrough
+    case NUM_EXP_SIGN:
+    case NUM_EXP_INT:
+        if (!ISDIGIT(ch)) {
+            return false;
+        }
+        *lex = NUM_EXP_INT;
+        return true;
+    }
+    return false;
+}
+
+static void push_append(push_parser* p, const char* s, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (p->len + len > p->cap) {
+        p->cap = p->cap == 0 ? PARSE_STACK_INIT_SIZE : p->cap;
+        while (p->len + len > p->cap) {
+            p->cap += p->cap >> 1;
+        }
+        p->buf = (char*)realloc(p->buf, p->cap);
+    }
+    memcpy(p->buf + p->len, s, len);
+    p->len += len;
+}
+
+// 保证还能再压入一层array/object
+static void push_reserve_level(push_parser* p) {
+    if (p->depth == p->levels_cap) {
+        p->levels_cap = p->levels_cap == 0 ? 16 : p->levels_cap * EXPAND_COEFFICIENT;
+        p->levels = (size_t*)realloc(p->levels, p->levels_cap * sizeof(size_t));
+        if (p->root) {
+            p->open = (value**)realloc(p->open, p->levels_cap * sizeof(value*));
+        }
+    }
+}
+
+// 一个值结束，计入所在的array/object
+static void push_value_done(push_parser* p) {
+    p->state = PUSH_AFTER_VALUE;
+    if (p->depth > 0) {
+        p->levels[p->depth - 1] += 2;
+    }
+}
+
+// token已经完整，[tok, tok_end)为它在本块输入中的部分，之前的部分在p->buf中
+static int push_token(push_parser* p, const char* tok, const char* tok_end) {
+    context c;
+    int ret;
+    if (p->len > 0) {
+        push_append(p, tok, tok_end - tok);
+        tok = p->buf;
+        tok_end = p->buf + p->len;
+        p->len = 0;
+    }
+    context_init(&c, tok, tok_end - tok);
+    c.stack = p->stack;
+    c.size = p->stack_size;
+    if (p->state == PUSH_KEY_STRING) {
+        const char* str;
+        size_t len;
+        bool in_input;
+        if ((ret = parse_string_raw(&c, &str, &len, &in_input)) == PARSE_OK) {
+            p->state = PUSH_COLON;
+            if (p->h->key && p->h->key(p->user, str, len) != 0) {
+                ret = PARSE_CANCELED;
+            }
+        }
+    } else if ((ret = sax_parse_scalar(&c, p->h, p->user)) == PARSE_OK) {
+        push_value_done(p);
+    }
+    assert(c.top == 0);
+    p->stack = c.stack;
+    p->stack_size = c.size;
+    return ret;
+}
+
+static int push_begin_value(push_parser* p, char ch) {
+    switch (ch) {
+    case 'n':
+    case 't':
+    case 'f':
+        p->state = PUSH_LITERAL;
+        p->lex = 1 | (ch == 'n' ? 0 : ch == 't' ? 1 : 2) << 4;
+        return PARSE_OK;
+    case '"':
+        p->state = PUSH_STRING;
+        p->lex = 0;
+        return PARSE_OK;
+    case '[':
+    case '{':
+        if (p->depth == PARSE_MAX_DEPTH) {
+            return PARSE_TOO_DEEP;
+        }
+        push_reserve_level(p);
+        if (ch == '[') {
+            SAX_EVENT(p->h, start_array, p->user);
+        } else {
+            SAX_EVENT(p->h, start_object, p->user);
+        }
+        p->levels[p->depth++] = ch == '{';
+        p->state = ch == '[' ? PUSH_ARRAY_FIRST : PUSH_OBJECT_FIRST;
+        return PARSE_OK;
+    default:
+        if (ch != '-' && !ISDIGIT(ch)) {
+            return PARSE_INVALID_VALUE;
+        }
+        p->state = PUSH_NUMBER;
+        p->lex = ch == '-' ? NUM_SIGN : ch == '0' ? NUM_ZERO : NUM_INT;
+        return PARSE_OK;
+    }
+}
+
+static int push_close(push_parser* p) {
+    size_t level = p->levels[--p->depth];
+    if (level & 1) {
+        SAX_EVENT(p->h, end_object, p->user, level >> 1);
+    } else {
+        SAX_EVENT(p->h, end_array, p->user, level >> 1);
+    }
+    push_value_done(p);
+    return PARSE_OK;
+}
+
+// 处理一个非空白的结构字符，或者一个token的第一个字符
+static int push_structural(push_parser* p, char ch) {
+    switch (p->state) {
+    case PUSH_ARRAY_FIRST:
+        if (ch == ']') {
+            return push_close(p);
+        }
+        // fallthrough
+    case PUSH_VALUE:
+        return push_begin_value(p, ch);
+    case PUSH_OBJECT_FIRST:
+        if (ch == '}') {
+            return push_close(p);
+        }
+        // fallthrough
+    case PUSH_KEY:
+        if (ch != '"') {
+            return PARSE_MISS_KEY;
+        }
+        p->state = PUSH_KEY_STRING;
+        p->lex = 0;
+        return PARSE_OK;
+    case PUSH_COLON:
+        if (ch != ':') {
+            return PARSE_MISS_COLON;
+        }
+        p->state = PUSH_VALUE;
+        return PARSE_OK;
+    default: {
+        assert(p->state == PUSH_AFTER_VALUE);
+        if (p->depth == 0) {
+            return PARSE_ROOT_NOT_SINGULAR;
+        }
+        bool is_object = p->levels[p->depth - 1] & 1;
+        if (ch == ',') {
+            p->state = is_object ? PUSH_KEY : PUSH_VALUE;
+            return PARSE_OK;
+        }
+        if (ch == (is_object ? '}' : ']')) {
+            return push_close(p);
+        }
+        return is_object ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+    }
+}
+
+// 出错或中止后丢弃已经构建的DOM
+static int push_fail(push_parser* p, int ret) {
+    p->status = ret;
+    if (p->root) {
+        tiny_free(p->root);
+    }
+    return ret;
+}
+
+/* 构建DOM的SAX回调，user为push_parser本身
+ * 只有最内层的array/object会增加元素，外层节点的地址在子节点结束之前不会改变，所以p->open中可以保存节点的指针
+ */
+static value* push_dom_slot(push_parser* p) {
+    if (p->depth == 0) {
+        return p->root;
+    }
+    value* top = p->open[p->depth - 1];
+    return top->tiny_type == ARRAY ? array_pushback(top) : p->pending;
+}
+
+static int push_dom_null(void* user) {
+    push_dom_slot((push_parser*)user);
+    return 0;
+}
+
+static int push_dom_boolean(void* user, int b) {
+    set_boolean(push_dom_slot((push_parser*)user), b);
+    return 0;
+}
+
+static int push_dom_number(void* user, double n) {
+    set_number(push_dom_slot((push_parser*)user), n);
+    return 0;
+}
+
+static int push_dom_string(void* user, const char* s, size_t len) {
+    set_string(push_dom_slot((push_parser*)user), s, len);
+    return 0;
+}
+
+static int push_dom_key(void* user, const char* k, size_t len) {
+    push_parser* p = (push_parser*)user;
+    p->pending = object_append(p->open[p->depth - 1], k, len, nullptr);
+    return 0;
+}
+
+static int push_dom_start_array(void* user) {
+    push_parser* p = (push_parser*)user;
+    value* v = push_dom_slot(p);
+    set_array(v, 0);
+    p->open[p->depth] = v;
+    return 0;
+}
+
+static int push_dom_start_object(void* user) {
+    push_parser* p = (push_parser*)user;
+    value* v = push_dom_slot(p);
+    set_object(v, 0);
+    p->open[p->depth] = v;
+    return 0;
+}
+
+static const sax_handler PUSH_DOM_HANDLER = {push_dom_null,
+                                             push_dom_boolean,
+                                             push_dom_number,
+                                             push_dom_string,
+                                             push_dom_key,
+                                             push_dom_start_array,
+                                             nullptr,
+                                             push_dom_start_object,
+                                             nullptr};
+
+void push_parser_init(push_parser* p, const sax_handler* h, void* user) {
+    assert(p != nullptr && h != nullptr);
+    p->h = h;
+    p->user = user;
+    p->state = PUSH_VALUE;
+    p->status = PARSE_OK;
+    p->lex = 0;
+    p->buf = nullptr;
+    p->len = p->cap = 0;
+    p->levels = nullptr;
+    p->depth = p->levels_cap = 0;
+    p->stack = nullptr;
+    p->stack_size = 0;
+    p->root = nullptr;
+    p->open = nullptr;
+    p->pending = nullptr;
+}
+
+void push_parser_init(push_parser* p, value* v) {
+    assert(v != nullptr);
+    push_parser_init(p, &PUSH_DOM_HANDLER, p);
+    p->root = v;
+    tiny_init(v);
+}
+
+int push_parser_feed(push_parser* p, const char* chunk, size_t len) {
+    assert(p != nullptr && (chunk != nullptr || len == 0));
+    const char* s = chunk;
+    const char* end = chunk + len;
+    const char* tok = chunk; // 当前token在本块输入中的起始位置
+    int ret = p->status;
+    while (s != end && ret == PARSE_OK) {
+        switch (p->state) {
+        case PUSH_STRING:
+        case PUSH_KEY_STRING:
+            if (p->lex) {
+                // 转义符之后的字符，是否合法留给parse_string_raw判断
+                p->lex = 0;
+                ++s;
+                break;
+            }
+            s = scan_string(s, end);
+            if (s == end) {
+                break;
+            }
+            if (*s == '\\') {
+                p->lex = 1;
+            } else if (*s == '\"') {
+                ret = push_token(p, tok, s + 1);
+            }
+            ++s; // 控制字符同样留给parse_string_raw报告错误
+            break;
+        case PUSH_NUMBER:
+            if (number_accept(&p->lex, *s)) {
+                ++s;
+            } else {
+                ret = push_token(p, tok, s); // 当前字符不属于数字，在下一轮按新的状态处理
+            }
+            break;
+        case PUSH_LITERAL: {
+            const char* literal = PUSH_LITERALS[p->lex >> 4];
+            size_t n = p->lex & 0xf;
+            if (*s != literal[n]) {
+                ret = PARSE_INVALID_VALUE;
+                break;
+            }
+            ++s;
+            ++p->lex;
+            if (literal[n + 1] == '\0') {
+                ret = push_token(p, tok, s);
+            }
+            break;
+        }
+        default:
+            if (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r') {
+                ++s;
+                break;
+            }
+            tok = s;
+            ret = push_structural(p, *s++);
+            break;
+        }
+    }
+    if (ret != PARSE_OK) {
+        return push_fail(p, ret);
+    }
+    if (p->state >= PUSH_STRING) {
+        push_append(p, tok, end - tok);
+    }
+    return PARSE_OK;
+}
+
+int push_parser_finish(push_parser* p) {
+    assert(p != nullptr);
+    int ret = p->status;
+    if (ret != PARSE_OK) {
+        return ret;
+    }
+    switch (p->state) {
+    case PUSH_STRING:
+    case PUSH_KEY_STRING:
+    case PUSH_NUMBER:
+        // 字符串缺少结束的双引号时，parse_string_raw会给出与parse相同的错误码；数字在输入结束处自然结束
+        ret = push_token(p, nullptr, nullptr);
+        break;
+    case PUSH_LITERAL:
+        ret = PARSE_INVALID_VALUE;
+        break;
+    }
+    if (ret == PARSE_OK) {
+        switch (p->state) {
+        case PUSH_VALUE:
+        case PUSH_ARRAY_FIRST:
+            ret = PARSE_EXPECT_VALUE;
+            break;
+        case PUSH_OBJECT_FIRST:
+        case PUSH_KEY:
+            ret = PARSE_MISS_KEY;
+            break;
+        case PUSH_COLON:
+            ret = PARSE_MISS_COLON;
+            break;
+        default:
+            assert(p->state == PUSH_AFTER_VALUE);
+            if (p->depth > 0) {
+                ret = (p->levels[p->depth - 1] & 1) ? PARSE_MISS_COMMA_OR_CURLY_BRACKET
+                                                    : PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            }
+            break;
+        }
+    }
+    if (ret != PARSE_OK) {
+        return push_fail(p, ret);
+    }
+    return PARSE_OK;
+}
+
+int push_parser_complete(const push_parser* p) {
+    assert(p != nullptr);
+    return p->status == PARSE_OK && p->state == PUSH_AFTER_VALUE && p->depth == 0;
+}
+
+void push_parser_free(push_parser* p) {
+    assert(p != nullptr);
+    free(p->buf);
+    free(p->levels);
+    free(p->stack);
+    free(p->open);
+    p->buf = p->stack = nullptr;
+    p->levels = nullptr;
+    p->open = nullptr;
+    p->len = p->cap = p->depth = p->levels_cap = p->stack_size = 0;
+}
+
+/* NDJSON的并行解析
+ * 调用线程把输入切成至少batch_size字节、在换行处结束的批，放入固定数量的槽中；工作线程取走序号最小的待解析批，
+ * 逐行parse后把结果留在槽里；调用线程按序号（或按完成的先后）交付结果、清空槽，再切下一批
+ * 槽的数量是线程数的两倍，所以同时存在的解析结果最多这么多批；JSON的字符串内不能出现原始的换行，按'\n'切分总是安全的
+ */
+enum { NDJSON_SLOT_FREE, NDJSON_SLOT_READY, NDJSON_SLOT_PARSING, NDJSON_SLOT_DONE };
+
+typedef struct {
+    value v;
+    size_t line;
+    int status;
+} ndjson_record;
+
+typedef struct {
+    const char* begin; // 批的范围[begin, end)
+    const char* end;
+    size_t id, first_line;
+    ndjson_record* records; // 非空行的解析结果，内存在槽被重复使用时保留
+    size_t count, capacity;
+    int state; // 只在持有锁时修改；FREE和DONE的槽只有调用线程访问
+} ndjson_slot;
+
+struct ndjson_shared {
+    std::mutex lock;
+    std::condition_variable ready, done; // 有批等待解析 / 有批解析完成
+    ndjson_slot* slots;
+    size_t nslots;
+    int stop;
+    const parse_options* opt;
+};
+
+static size_t count_lines(const char* p, const char* end) {
+    size_t n = 0;
+    while ((p = (const char*)memchr(p, '\n', end - p)) != nullptr) {
+        ++n;
+        ++p;
+    }
+    return n;
+}
+
+static void ndjson_parse_batch(ndjson_slot* s, const parse_options* opt) {
+    size_t line = s->first_line;
+    for (const char* p = s->begin; p < s->end; ++line) {
+        const char* nl = (const char*)memchr(p, '\n', s->end - p);
+        const char* q = nl ? nl : s->end;
+        const char* t = p;
+        while (t < q && (*t == ' ' || *t == '\t' || *t == '\r')) {
+            ++t;
+        }
+        if (t < q) {
+            if (s->count == s->capacity) {
+                s->capacity = s->capacity == 0 ? 64 : s->capacity * 2;
+                s->records = (ndjson_record*)realloc(s->records, s->capacity * sizeof(ndjson_record));
+            }
+            ndjson_record* r = &s->records[s->count++];
+            r->line = line;
+            r->status = parse(&r->v, t, q - t, opt);
+        }
+        if (nl == nullptr) {
+            break;
+        }
+        p = nl + 1;
+    }
+}
+
+static void ndjson_discard(ndjson_slot* s) {
+    for (size_t i = 0; i < s->count; ++i) {
+        tiny_free(&s->records[i].v);
+    }
+    s->count = 0;
+}
+
+static int ndjson_deliver(ndjson_slot* s, ndjson_callback cb, void* user) {
+    int ret = PARSE_OK;
+    for (size_t i = 0; i < s->count && ret == PARSE_OK; ++i) {
+        ndjson_record* r = &s->records[i];
+        if (cb(user, r->line, &r->v, r->status) != 0) {
+            ret = PARSE_CANCELED;
+        }
+    }
+    ndjson_discard(s);
+    return ret;
+}
+
+// 每个线程使用自己的scratch，稳定后解析每条记录都不再为堆栈分配内存
+static void ndjson_parse_options(parse_options* opt, const parse_options* user, scratch* work) {
+    if (user) {
+        *opt = *user;
+    } else {
+        parse_options_init(opt);
+    }
+    scratch_init(work, SCRATCH_RETAIN_UNLIMITED);
+    opt->work = work;
+}
+
+// 从*p开始切出下一批，至少batch字节，在其后的第一个换行处结束
+static void ndjson_next_batch(ndjson_slot* s, const char** p, const char* end, size_t batch, size_t* line) {
+    const char* q = nullptr;
+    if ((size_t)(end - *p) > batch) {
+        q = (const char*)memchr(*p + batch, '\n', end - *p - batch);
+    }
+    q = q ? q + 1 : end;
+    s->begin = *p;
+    s->end = q;
+    s->first_line = *line;
+    *line += count_lines(*p, q);
+    *p = q;
+}
+
+static void ndjson_worker(ndjson_shared* sh) {
+    scratch work;
+    parse_options opt;
+    ndjson_parse_options(&opt, sh->opt, &work);
+
+    std::unique_lock<std::mutex> guard(sh->lock);
+    for (;;) {
+        ndjson_slot* s = nullptr;
+        for (size_t i = 0; i < sh->nslots; ++i) {
+            ndjson_slot* t = &sh->slots[i];
+            if (t->state == NDJSON_SLOT_READY && (s == nullptr || t->id < s->id)) {
+                s = t;
+            }
+        }
+        if (s == nullptr) {
+            if (sh->stop) {
+                break;
+            }
+            sh->ready.wait(guard);
+            continue;
+        }
+        s->state = NDJSON_SLOT_PARSING;
+        guard.unlock();
+        ndjson_parse_batch(s, &opt);
+        guard.lock();
+        s->state = NDJSON_SLOT_DONE;
+        sh->done.notify_one();
+    }
+    guard.unlock();
+    scratch_free(&work);
+}
+
+int parse_ndjson(const char* json, size_t len, ndjson_callback cb, void* user, const ndjson_options* opt) {
+    ndjson_options defaults;
+    assert((json != nullptr || len == 0) && cb != nullptr);
+    if (opt == nullptr) {
+        ndjson_options_init(&defaults);
+        opt = &defaults;
+    }
+    assert(opt->parse == nullptr || opt->parse->pool == nullptr);
+    unsigned int threads = opt->threads ? opt->threads : std::thread::hardware_concurrency();
+    if (threads == 0) {
+        threads = 1;
+    }
+    size_t batch = opt->batch_size ? opt->batch_size : NDJSON_BATCH_SIZE;
+    const char *p = json, *end = json + len;
+    size_t line = 0;
+    int ret = PARSE_OK;
+
+    if (threads == 1) {
+        // 只有一个线程时直接在调用线程上依次解析和交付，避免线程间的同步和跨线程释放内存
+        ndjson_slot s;
+        scratch work;
+        parse_options popt;
+        memset(&s, 0, sizeof(s));
+        ndjson_parse_options(&popt, opt->parse, &work);
+        while (p < end && ret == PARSE_OK) {
+            ndjson_next_batch(&s, &p, end, batch, &line);
+            ndjson_parse_batch(&s, &popt);
+            ret = ndjson_deliver(&s, cb, user);
+        }
+        free(s.records);
+        scratch_free(&work);
+        return ret;
+    }
+
+    ndjson_shared sh;
+    sh.nslots = (size_t)threads * 2;
+    sh.slots = (ndjson_slot*)calloc(sh.nslots, sizeof(ndjson_slot));
+    sh.stop = 0;
+    sh.opt = opt->parse;
+    std::thread* workers = new std::thread[threads];
+    for (unsigned int i = 0; i < threads; ++i) {
+        workers[i] = std::thread(ndjson_worker, &sh);
+    }
+
+    size_t next_id = 0, deliver_id = 0;
+    std::unique_lock<std::mutex> guard(sh.lock);
+    while (ret == PARSE_OK) {
+        // 切出新的批放入空闲的槽，填写槽的内容时不需要持有锁
+        for (size_t i = 0; i < sh.nslots && p < end; ++i) {
+            ndjson_slot* s = &sh.slots[i];
+            if (s->state != NDJSON_SLOT_FREE) {
+                continue;
+            }
+            guard.unlock();
+            ndjson_next_batch(s, &p, end, batch, &line);
+            s->id = next_id++;
+            guard.lock();
+            s->state = NDJSON_SLOT_READY;
+            sh.ready.notify_one();
+        }
+        // 有序时只能交付序号为deliver_id的批，否则交付已完成的批中序号最小的
+        ndjson_slot* s = nullptr;
+        int pending = 0;
+        for (size_t i = 0; i < sh.nslots; ++i) {
+            ndjson_slot* t = &sh.slots[i];
+            if (t->state != NDJSON_SLOT_FREE) {
+                pending = 1;
+            }
+            if (t->state == NDJSON_SLOT_DONE && (opt->ordered ? t->id == deliver_id : s == nullptr || t->id < s->id)) {
+                s = t;
+            }
+        }
+        if (s == nullptr) {
+            if (!pending) {
+                break;
+            }
+            sh.done.wait(guard);
+            continue;
+        }
+        guard.unlock();
+        ret = ndjson_deliver(s, cb, user);
+        ++deliver_id;
+        guard.lock();
+        s->state = NDJSON_SLOT_FREE;
+    }
+    // 中止时丢弃还没开始解析的批，等正在解析的批完成后释放它们的结果
+    for (int parsing = ret != PARSE_OK; parsing;) {
+        parsing = 0;
+        for (size_t i = 0; i < sh.nslots; ++i) {
+            ndjson_slot* s = &sh.slots[i];
+            if (s->state == NDJSON_SLOT_PARSING) {
+                parsing = 1;
+            } else if (s->state != NDJSON_SLOT_FREE) {
+                ndjson_discard(s);
+                s->state = NDJSON_SLOT_FREE;
+            }
+        }
+        if (parsing) {
+            sh.done.wait(guard);
+        }
+    }
+    sh.stop = 1;
+    sh.ready.notify_all();
+    guard.unlock();
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        workers[i].join();
+    }
+    delete[] workers;
+    for (size_t i = 0; i < sh.nslots; ++i) {
+        free(sh.slots[i].records);
+    }
+    free(sh.slots);
+    return ret;
+}
+
+/* 数字生成：Grisu2算法，输出能够精确还原成原double的最短（绝大多数情况下）十进制表示
+ * 精确的整数直接按整数输出，不经过浮点格式化
+ * 输出格式与"%.17g"一致：十进制指数小于-4或不小于17时使用科学计数法，指数至少两位
+ */
+typedef struct {
+    uint64_t f; // 有效数字
+    int e;      // 二进制指数，值为f * 2^e
+} diyfp;
+
+const int DIYFP_SIGNIFICAND_SIZE = 64;
+const int DOUBLE_EXPONENT_BIAS = 0x3ff + DOUBLE_MANTISSA_BITS;
+const uint64_t DOUBLE_HIDDEN_BIT = uint64_t(1) << DOUBLE_MANTISSA_BITS;
+
+static diyfp diyfp_from_double(double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    int biased_e = (int)((u >> DOUBLE_MANTISSA_BITS) & 0x7ff);
+    uint64_t significand = u & (DOUBLE_HIDDEN_BIT - 1);
+    diyfp r;
+    if (biased_e != 0) {
+        r.f = significand + DOUBLE_HIDDEN_BIT;
+        r.e = biased_e - DOUBLE_EXPONENT_BIAS;
+    } else {
+        r.f = significand;
+        r.e = 1 - DOUBLE_EXPONENT_BIAS;
+    }
+    return r;
+}
+
+// 两个diyfp相乘，只保留高64位并四舍五入
+static diyfp diyfp_mul(diyfp a, diyfp b) {
+    uint64_t hi, lo;
+    mul128(a.f, b.f, &hi, &lo);
+    if (lo & (uint64_t(1) << 63)) {
+        ++hi;
+    }
+    diyfp r = {hi, a.e + b.e + 64};
+    return r;
+}
+
+static diyfp diyfp_normalize(diyfp a) {
+    int s = CLZ64(a.f);
+    a.f <<= s;
+    a.e -= s;
+    return a;
+}
+
+// 计算v的两个边界(m-, m+)，即与相邻double的中点，并规格化到相同的指数
+static void diyfp_normalized_boundaries(diyfp v, diyfp* minus, diyfp* plus) {
+    diyfp pl = {(v.f << 1) + 1, v.e - 1};
+    while (!(pl.f & (DOUBLE_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= DIYFP_SIGNIFICAND_SIZE - DOUBLE_MANTISSA_BITS - 2;
+    pl.e -= DIYFP_SIGNIFICAND_SIZE - DOUBLE_MANTISSA_BITS - 2;
+    // 有效数字为2的幂时，下边界离v只有上边界的一半
+    diyfp mi = v.f == DOUBLE_HIDDEN_BIT ? diyfp{(v.f << 2) - 1, v.e - 2} : diyfp{(v.f << 1) - 1, v.e - 1};
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *minus = mi;
+    *plus = pl;
+}
+
+// 10^-348, 10^-340, ..., 10^340的规格化近似值，由脚本生成
+static const uint64_t CACHED_POWERS_F[] = {
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76, 0xcf42894a5dce35ea,
+    0x9a6bb0aa55653b2d, 0xe61acf033d1a45df, 0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f,
+    0xbe5691ef416bd60c, 0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57, 0xc21094364dfb5637,
+    0x9096ea6f3848984f, 0xd77485cb25823ac7, 0xa086cfcd97bf97f4, 0xef340a98172aace5,
+    0xb23867fb2a35b28e, 0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126, 0xb5b5ada8aaff80b8,
+    0x87625f056c7c4a8b, 0xc9bcff6034c13053, 0x964e858c91ba2655, 0xdff9772470297ebd,
+    0xa6dfbd9fb8e5b88f, 0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06, 0xaa242499697392d3,
+    0xfd87b5f28300ca0e, 0xbce5086492111aeb, 0x8cbccc096f5088cc, 0xd1b71758e219652c,
+    0x9c40000000000000, 0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+    0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068, 0x9f4f2726179a2245,
+    0xed63a231d4c4fb27, 0xb0de65388cc8ada8, 0x83c7088e1aab65db, 0xc45d1df942711d9a,
+    0x924d692ca61be758, 0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+    0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d, 0x952ab45cfa97a0b3,
+    0xde469fbd99a05fe3, 0xa59bc234db398c25, 0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece,
+    0x88fcf317f22241e2, 0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+    0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410, 0x8bab8eefb6409c1a,
+    0xd01fef10a657842c, 0x9b10a4e5e9913129, 0xe7109bfba19c0c9d, 0xac2820d9623bf429,
+    0x80444b5e7aa7cf85, 0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+    0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b,
+};
+static const short CACHED_POWERS_E[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927, -901, -874, -847, -821,
+    -794, -768, -741, -715, -688, -661, -635, -608, -582, -555, -529, -502, -475, -449, -422, -396,
+    -369, -343, -316, -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+// 取一个10^-K的近似值c，使得e + c.e + 64落在[-60, -32]之间
+static diyfp get_cached_power(int e, int* K) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347; // dk必须是正数，这样才能用截断实现向上取整
+    int k = (int)dk;
+    if (k != dk) {
+        ++k;
+    }
+    unsigned int index = (unsigned int)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+    diyfp r = {CACHED_POWERS_F[index], CACHED_POWERS_E[index]};
+    return r;
+}
+
+static const uint64_t POW10_U64[] = {1ULL,
+                                     10ULL,
+                                     100ULL,
+                                     1000ULL,
+                                     10000ULL,
+                                     100000ULL,
+                                     1000000ULL,
+                                     10000000ULL,
+                                     100000000ULL,
+                                     1000000000ULL,
+                                     10000000000ULL,
+                                     100000000000ULL,
+                                     1000000000000ULL,
+                                     10000000000000ULL,
+                                     100000000000000ULL,
+                                     1000000000000000ULL,
+                                     10000000000000000ULL,
+                                     100000000000000000ULL,
+                                     1000000000000000000ULL,
+                                     10000000000000000000ULL};
+
+// 在保证结果仍在边界内的前提下，把最后一位向真实值靠近
+static void grisu_round(char* buffer, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int count_decimal_digit32(uint32_t n) {
+    int d = 1;
+    while (d < 10 && n >= POW10_U64[d]) {
+        ++d;
+    }
+    return d;
+}
+
+// 生成尽可能少的数字，使结果落在(Mp - delta, Mp)之间
+static void digit_gen(diyfp W, diyfp Mp, uint64_t delta, char* buffer, int* len, int* K) {
+    const diyfp one = {uint64_t(1) << -Mp.e, Mp.e};
+    const uint64_t wp_w = Mp.f - W.f;
+    uint32_t p1 = (uint32_t)(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = count_decimal_digit32(p1);
+    *len = 0;
+    // 整数部分
+    while (kappa > 0) {
+        uint32_t d = p1 / (uint32_t)POW10_U64[kappa - 1];
+        p1 %= (uint32_t)POW10_U64[kappa - 1];
+        if (d || *len) {
+            buffer[(*len)++] = (char)('0' + d);
+        }
+        kappa--;
+        uint64_t tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            grisu_round(buffer, *len, delta, tmp, POW10_U64[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+    // 小数部分
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || *len) {
+            buffer[(*len)++] = (char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            int index = -kappa;
+            grisu_round(buffer, *len, delta, p2, one.f, wp_w * (index < 20 ? POW10_U64[index] : 0));
+            return;
+        }
+    }
+}
+
+// 生成正数d的十进制数字，d = buffer * 10^K
+static void grisu2(double d, char* buffer, int* len, int* K) {
+    const diyfp v = diyfp_from_double(d);
+    diyfp w_m, w_p;
+    diyfp_normalized_boundaries(v, &w_m, &w_p);
+    const diyfp c_mk = get_cached_power(w_p.e, K);
+    const diyfp W = diyfp_mul(diyfp_normalize(v), c_mk);
+    diyfp Wp = diyfp_mul(w_p, c_mk);
+    diyfp Wm = diyfp_mul(w_m, c_mk);
+    Wm.f++;
+    Wp.f--;
+    digit_gen(W, Wp, Wp.f - Wm.f, buffer, len, K);
+}
+
+static const char DIGITS_LUT[] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+// 无符号整数转字符串，返回写入结束的位置
+static char* u64toa(uint64_t n, char* buffer) {
+    char tmp[20];
+    int i = 20;
+    while (n >= 100) {
+        unsigned int r = (unsigned int)(n % 100) * 2;
+        n /= 100;
+        tmp[--i] = DIGITS_LUT[r + 1];
+        tmp[--i] = DIGITS_LUT[r];
+    }
+    if (n >= 10) {
+        tmp[--i] = DIGITS_LUT[n * 2 + 1];
+        tmp[--i] = DIGITS_LUT[n * 2];
+    } else {
+        tmp[--i] = (char)('0' + n);
+    }
+    memcpy(buffer, tmp + i, 20 - i);
+    return buffer + 20 - i;
+}
+
+// 把digits * 10^K按"%.17g"的规则排版，返回写入结束的位置
+static char* prettify(char* buffer, int len, int K) {
+    const int exp10 = len + K - 1; // 科学计数法的指数
+    if (exp10 < -4 || exp10 >= 17) {
+        // d.ddde+XX
+        char* p = buffer;
+        if (len > 1) {
+            memmove(p + 2, p + 1, len - 1);
+            p[1] = '.';
+            p += len + 1;
+        } else {
+            p += 1;
+        }
+        *p++ = 'e';
+        int e = exp10;
+        if (e < 0) {
+            *p++ = '-';
+            e = -e;
+        } else {
+            *p++ = '+';
+        }
+        if (e >= 100) {
+            *p++ = (char)('0' + e / 100);
+            e %= 100;
+        }
+        *p++ = DIGITS_LUT[e * 2];
+        *p++ = DIGITS_LUT[e * 2 + 1];
+        return p;
+    }
+    if (K >= 0) {
+        // 整数，末尾补0
+        memset(buffer + len, '0', K);
+        return buffer + len + K;
+    }
+    if (exp10 >= 0) {
+        // 1234e-2 -> 12.34
+        memmove(buffer + exp10 + 2, buffer + exp10 + 1, len - exp10 - 1);
+        buffer[exp10 + 1] = '.';
+        return buffer + len + 1;
+    }
+    // 1234e-6 -> 0.001234
+    const int offset = -exp10 + 1;
+    memmove(buffer + offset, buffer, len);
+    buffer[0] = '0';
+    buffer[1] = '.';
+    memset(buffer + 2, '0', offset - 2);
+    return buffer + len + offset;
+}
+
+// double转字符串，buffer至少需要25个字节，返回写入结束的位置
+static char* dtoa(double d, char* buffer) {
+    // JSON无法表示NaN和无穷大
+    if (d != d || d == HUGE_VAL || d == -HUGE_VAL) {
+        memcpy(buffer, "null", 4);
+        return buffer + 4;
+    }
+    if (std::signbit(d)) {
+        *buffer++ = '-';
+        d = -d;
+    }
+    // 能精确表示的整数直接按整数输出
+    if (d < 9007199254740992.0 && (double)(uint64_t)d == d) {
+        return u64toa((uint64_t)d, buffer);
+    }
+    int len, K;
+    grisu2(d, buffer, &len, &K);
+    return prettify(buffer, len, K);
+}
+
+/* 字符串生成：用scan_string（与解析共用的向量化扫描）找到下一个需要转义的字节，中间不需要转义的部分整段拷贝
+ * 每段输出前按最坏情况（每个字节都转义为\u00XX）一次性预留空间，之后直接写入，不再逐字节检查容量
+ */
+const size_t ESCAPE_MAX = 6;      // 一个字节转义后的最大长度
+const size_t ESCAPE_CHUNK = 4096; // 每次预留空间时最多处理的输入字节数
+
+// 控制字符的转义：非0时为两个字符的简写，为0时输出\u00XX
+static const char ESCAPE_SHORT[0x20] = {0, 0, 0, 0, 0, 0, 0, 0, 'b', 't', 'n', 0, 'f', 'r', 0, 0,
+                                        0, 0, 0, 0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0};
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// 转义[p, end)写入out，返回写入的结束位置，out至少有(end - p) * ESCAPE_MAX字节
+static char* escape_string(char* out, const char* p, const char* end) {
+    for (;;) {
+        const char* q = scan_string(p, end);
+        memcpy(out, p, q - p);
+        out += q - p;
+        if (q == end) {
+            return out;
+        }
+        unsigned char ch = (unsigned char)*q;
+        out[0] = '\\';
+        if (ch == '\"' || ch == '\\') {
+            out[1] = (char)ch;
+            out += 2;
+        } else if (ESCAPE_SHORT[ch]) {
+            out[1] = ESCAPE_SHORT[ch];
+            out += 2;
+        } else {
+            memcpy(out + 1, "u00", 3);
+            out[4] = HEX_DIGITS[ch >> 4];
+            out[5] = HEX_DIGITS[ch & 0xf];
+            out += 6;
+        }
+        p = q + 1;
+    }
+}
+
+static void stringify_string(context* c, const char* s, size_t len) {
+    assert(s != nullptr);
+    const char* end = s + len;
+    PUTC(c, '"');
+    while (s != end) {
+        size_t n = (size_t)(end - s);
+        if (c->sink) {
+            // 固定的缓冲区中放不下最坏情况时先交给sink，context_push要求预留的大小严格小于剩余空间
+            if (c->size - c->top <= ESCAPE_MAX) {
+                context_flush(c);
+            }
+            size_t avail = (c->size - c->top - 1) / ESCAPE_MAX;
+            n = n < avail ? n : avail;
+        } else if (n > ESCAPE_CHUNK) {
+            n = ESCAPE_CHUNK;
+        }
+        char* out = (char*)context_push(c, n * ESCAPE_MAX);
+        c->top -= n * ESCAPE_MAX - (escape_string(out, s, s + n) - out);
+        s += n;
+    }
+    PUTC(c, '"');
+}
+
+// 输出字符串或标量
+static void stringify_scalar(context* c, const value* v) {
+    switch (v->tiny_type) {
+    case TINYNULL:
+        PUTS(c, "null", 4);
+        break;
+    case TRUE:
+        PUTS(c, "true", 4);
+        break;
+    case FALSE:
+        PUTS(c, "false", 5);
+        break;
+    case NUMBER: {
+        char* buffer = (char*)context_push(c, 32);
+        c->top -= 32 - (dtoa(v->u.n, buffer) - buffer);
+        break;
+    }
+    case STRING:
+        stringify_string(c, STR(v), STR_LEN(v));
+        break;
+    default:
+        break;
+    }
+}
+
+/* 格式化输出与紧凑输出共用同一个遍历，只在括号、逗号和冒号处多输出换行和缩进，不需要再解析一遍
+ * 当前节点的嵌套层数就是w中的frame数；按键排序时每个object的成员指针排好序后压入order，
+ * 内层的object结束时会弹出自己的数组，所以当前object的数组总在order的栈顶
+ */
+const size_t INDENT_CHUNK = 32; // 每次写入的缩进字符数，流式生成时不能超过缓冲区的一半
+
+inline bool PRETTY(const context* c) { return c->format && c->format->indent > 0; }
+
+// 换行并缩进depth层
+static void stringify_newline(context* c, size_t depth) {
+    for (const char* p = c->format->newline; *p; ++p) {
+        PUTC(c, *p); // 逐个字符写入，流式生成时换行符再长也不会超过缓冲区
+    }
+    for (size_t n = c->format->indent * depth; n > 0;) {
+        size_t k = n < INDENT_CHUNK ? n : INDENT_CHUNK;
+        memset(context_push(c, k), c->format->indent_char, k);
+        n -= k;
+    }
+}
+
+// 按键的字节序比较，一个键是另一个的前缀时短的在前，键相同时保持成员原来的顺序
+static int compare_member_keys(const void* lhs, const void* rhs) {
+    const member* a = *(const member* const*)lhs;
+    const member* b = *(const member* const*)rhs;
+    size_t alen = KEY_LEN(a), blen = KEY_LEN(b);
+    int r = memcmp(KEY(a), KEY(b), alen < blen ? alen : blen);
+    if (r != 0) {
+        return r;
+    }
+    if (alen != blen) {
+        return alen < blen ? -1 : 1;
+    }
+    return a < b ? -1 : a > b;
+}
+
+static void sort_members(context* order, const value* v) {
+    const member** sorted = (const member**)context_push(order, v->u.o.size * sizeof(member*));
+    for (size_t i = 0; i < v->u.o.size; ++i) {
+        sorted[i] = &v->u.o.m[i];
+    }
+    qsort(sorted, v->u.o.size, sizeof(member*), compare_member_keys);
+}
+
+// 进入array/object：输出左括号，按键排序时为非空的object压入排好序的成员
+static void stringify_open(context* c, const value* v, context* order) {
+    PUTC(c, v->tiny_type == ARRAY ? '[' : '{');
+    if (v->tiny_type == OBJECT && v->u.o.size > 0 && c->format && c->format->sort_keys) {
+        sort_members(order, v);
+    }
+}
+
+// c的堆栈用于输出，遍历用的堆栈在w中
+static void stringify_value(context* c, const value* v, context* w) {
+    if (!IS_CONTAINER(v)) {
+        stringify_scalar(c, v);
+        return;
+    }
+    context order;
+    context_init(&order, nullptr, 0);
+    bool pretty = PRETTY(c), sorted = c->format && c->format->sort_keys;
+    walk_frame f = {v, nullptr, 0};
+    stringify_open(c, v, &order);
+    for (;;) {
+        size_t count = CHILD_COUNT(f.a);
+        if (f.i < count) {
+            size_t i = f.i++;
+            if (i != 0) {
+                PUTC(c, ',');
+            }
+            if (pretty) {
+                stringify_newline(c, w->top / sizeof(walk_frame) + 1);
+            }
+            const value* e;
+            if (f.a->tiny_type == OBJECT) {
+                const member* m = sorted ? ((const member**)(order.stack + order.top) - count)[i] : &f.a->u.o.m[i];
+                stringify_string(c, KEY(m), KEY_LEN(m));
+                PUTC(c, ':');
+                if (pretty) {
+                    PUTC(c, ' ');
+                }
+                e = &m->v;
+            } else {
+                e = CHILD(f.a, i);
+            }
+            if (IS_CONTAINER(e)) {
+                walk_push(w, &f);
+                f.a = e;
+                f.i = 0;
+                stringify_open(c, e, &order);
+            } else {
+                stringify_scalar(c, e);
+            }
+            continue;
+        }
+        if (pretty && count > 0) {
+            stringify_newline(c, w->top / sizeof(walk_frame));
+        }
+        PUTC(c, f.a->tiny_type == ARRAY ? ']' : '}');
+        if (sorted && f.a->tiny_type == OBJECT) {
+            order.top -= count * sizeof(member*);
+        }
+        if (w->top == 0) {
+            break;
+        }
+        memcpy(&f, context_pop(w, sizeof(walk_frame)), sizeof(walk_frame));
+    }
+    free(order.stack);
+}
+
+char* stringify(const value* v, size_t* len) { return stringify_format(v, len, nullptr); }
+
+char* stringify_format(const value* v, size_t* len, const stringify_options* opt) {
+    context c, w;
+    assert(v != nullptr);
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    c.stack = (char*)malloc(c.size = PARSE_STACK_INIT_SIZE);
+    c.format = opt;
+    stringify_value(&c, v, &w);
+    free(w.stack);
+    if (len) {
+        *len = c.top;
+    }
+    PUTC(&c, '\0');
+    return c.stack;
+}
+
+const char* stringify(const value* v, size_t* len, scratch* s) {
+    context c, w;
+    assert(v != nullptr && s != nullptr);
+    scratch_trim(s, s->retain); // 上一次的结果到这里才不再需要
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    c.stack = s->stack;
+    c.size = s->size;
+    w.stack = s->frames;
+    w.size = s->frames_size;
+    stringify_value(&c, v, &w);
+    if (len) {
+        *len = c.top;
+    }
+    PUTC(&c, '\0');
+    s->stack = c.stack;
+    s->size = c.size;
+    s->frames = w.stack;
+    s->frames_size = w.size;
+    return c.stack;
+}
+
+int stringify(const value* v, char* buf, size_t size, stringify_sink sink, void* user) {
+    return stringify_format(v, buf, size, sink, user, nullptr);
+}
+
+int stringify_format(const value* v, char* buf, size_t size, stringify_sink sink, void* user,
+                     const stringify_options* opt) {
+    context c, w;
+    assert(v != nullptr && buf != nullptr && size >= STRINGIFY_MIN_BUFFER_SIZE && sink != nullptr);
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    c.stack = buf;
+    c.size = size;
+    c.sink = sink;
+    c.user = user;
+    c.format = opt;
+    stringify_value(&c, v, &w);
+    free(w.stack);
+    context_flush(&c);
+    return c.status;
+}
+
+// 字符串转义后的长度，包括两端的双引号
+static size_t escaped_size(const char* p, size_t len) {
+    const char* end = p + len;
+    size_t size = len + 2;
+    while ((p = scan_string(p, end)) != end) {
+        unsigned char ch = (unsigned char)*p++;
+        size += ch == '\"' || ch == '\\' || ESCAPE_SHORT[ch] ? 1 : ESCAPE_MAX - 1;
+    }
+    return size;
+}
+
+static size_t scalar_size(const value* v) {
+    switch (v->tiny_type) {
+    case TINYNULL:
+    case TRUE:
+        return 4;
+    case FALSE:
+        return 5;
+    case NUMBER: {
+        // 与dtoa相同，精确的整数按整数输出，只需数出位数
+        bool negative = std::signbit(v->u.n);
+        double d = negative ? -v->u.n : v->u.n;
+        if (d < 9007199254740992.0 && (double)(uint64_t)d == d) {
+            size_t n = negative ? 2 : 1;
+            for (uint64_t u = (uint64_t)d; u >= 10; u /= 10) {
+                ++n;
+            }
+            return n;
+        }
+        char buffer[32];
+        return dtoa(v->u.n, buffer) - buffer;
+    }
+    case STRING:
+        return escaped_size(STR(v), STR_LEN(v));
+    default:
+        return 0;
+    }
+}
+
+size_t stringify_size(const value* v) {
+    assert(v != nullptr);
+    if (!IS_CONTAINER(v)) {
+        return scalar_size(v);
+    }
+    context w;
+    context_init(&w, nullptr, 0);
+    walk_frame f = {v, nullptr, 0};
+    size_t size = 2; // 两端的括号
+    for (;;) {
+        if (f.i < CHILD_COUNT(f.a)) {
+            size_t i = f.i++;
+            if (i != 0) {
+                ++size; // ','
+            }
+            if (f.a->tiny_type == OBJECT) {
+                size += escaped_size(KEY(&f.a->u.o.m[i]), KEY_LEN(&f.a->u.o.m[i])) + 1; // 键和':'
+            }
+            const value* e = CHILD(f.a, i);
+            if (IS_CONTAINER(e)) {
+                walk_push(&w, &f);
+                f.a = e;
+                f.i = 0;
+                size += 2;
+            } else {
+                size += scalar_size(e);
+            }
+            continue;
+        }
+        if (w.top == 0) {
+            break;
+        }
+        memcpy(&f, context_pop(&w, sizeof(walk_frame)), sizeof(walk_frame));
+    }
+    free(w.stack);
+    return size;
+}
+
+size_t stringify_into(const value* v, char* buf, size_t cap) {
+    context c, w;
+    assert(v != nullptr && buf != nullptr && cap >= stringify_size(v));
+    (void)cap;
+    // 容量设为最大值，context_push永远不会扩容，输出直接写入buf
+    // 数字和字符串按最坏情况预留的空间可能越过cap，但实际写入的字节恰好是stringify_size(v)个
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    c.stack = buf;
+    c.size = (size_t)-1;
+    stringify_value(&c, v, &w);
+    free(w.stack);
+    return c.top;
+}
+
+static int file_sink(void* user, const char* data, size_t len) {
+    return fwrite(data, 1, len, (FILE*)user) != len;
+}
+
+static int fd_sink(void* user, const char* data, size_t len) {
+    int fd = *(int*)user;
+    while (len > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, (unsigned int)len);
+#else
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (n <= 0) {
+            return 1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int stringify_file(const value* v, FILE* fp) {
+    char buf[STRINGIFY_BUFFER_SIZE];
+    assert(fp != nullptr);
+    return stringify(v, buf, sizeof(buf), file_sink, fp);
+}
+
+int stringify_fd(const value* v, int fd) {
+    char buf[STRINGIFY_BUFFER_SIZE];
+    return stringify(v, buf, sizeof(buf), fd_sink, &fd);
+}
+
+type get_type(const value* v) {
+    assert(v != nullptr);
+    return v->tiny_type;
+}
+
+double get_number(const value* v) {
+    assert(v != nullptr && v->tiny_type == NUMBER);
+    return v->u.n;
+}
+
+void set_number(value* v, double n) {
+    tiny_free(v);
+    v->u.n = n;
+    v->tiny_type = NUMBER;
+}
+
+int get_boolean(const value* v) {
+    assert(v != nullptr && (v->tiny_type == TRUE || v->tiny_type == FALSE));
+    return v->tiny_type == TRUE;
+}
+
+void set_boolean(value* v, int b) {
+    // 先释放内存
+    tiny_free(v);
+    v->tiny_type = b ? TRUE : FALSE;
+}
+
+const char* get_string(const value* v) {
+    assert(v != nullptr && v->tiny_type == STRING);
+    return STR(v);
+}
+
+size_t get_string_len(const value* v) {
+    assert(v != nullptr && v->tiny_type == STRING);
+    return STR_LEN(v);
+}
+
+void set_string(value* v, const char* s, size_t len) {
+    assert(v != nullptr && (s != nullptr || len == 0));
+    tiny_free(v);
+    string_init(v, s, len, nullptr);
+}
+
+size_t get_array_size(const value* v) {
+    assert(v != nullptr && v->tiny_type == ARRAY);
+    return v->u.a.size;
+}
+
+size_t get_array_capacity(const value* v) {
+    assert(v != nullptr && v->tiny_type == ARRAY);
+    return v->u.a.capacity;
+}
+
+void array_reserve(value* v, size_t capacity) {
+    assert(v != nullptr && v->tiny_type == ARRAY);
+    ASSERT_MUTABLE(v);
+    if (v->u.a.capacity >= capacity) {
+        return;
+    }
+    v->u.a.capacity = capacity;
+    v->u.a.e = (value*)realloc(v->u.a.e, capacity * sizeof(value));
+}
+
+void array_shrink(value* v) {
+    assert(v != nullptr && v->tiny_type == ARRAY && v->u.a.capacity >= v->u.a.size);
+    ASSERT_MUTABLE(v);
+    if (v->u.a.size == v->u.a.capacity) {
+        return;
+    }
+    v->u.a.capacity = v->u.a.size;
+    v->u.a.e = (value*)realloc(v->u.a.e, v->u.a.capacity * sizeof(value));
+}
+
+value* array_pushback(value* v) {
+    assert(v != nullptr && v->tiny_type == ARRAY);
+    if (v->u.a.size == v->u.a.capacity) {
+        array_reserve(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * EXPAND_COEFFICIENT);
+    }
+    tiny_init(&v->u.a.e[v->u.a.size]);
+    return &v->u.a.e[v->u.a.size++];
+}
+
+void array_popback(value* v) {
+    assert(v != nullptr && v->tiny_type == ARRAY && v->u.a.size > 0);
+    ASSERT_MUTABLE(v);
+    tiny_free(&v->u.a.e[--v->u.a.size]);
+}
+
+value* array_insert(value* v, size_t index) {
+    assert(v != nullptr && v->tiny_type == ARRAY && index <= v->u.a.capacity);
+    ASSERT_MUTABLE(v);
+    if (index == v->u.a.capacity) {
+        return array_pushback(v);
+    }
+    if (v->u.a.capacity < v->u.a.size + 1) {
+        array_reserve(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * EXPAND_COEFFICIENT);
+    }
+    memmove(&v->u.a.e[index + 1], &v->u.a.e[index], (v->u.a.size - index) * sizeof(value));
+    tiny_init(&v->u.a.e[index]);
+    ++v->u.a.size;
+    return &v->u.a.e[index];
+}
+
+void array_erase(value* v, size_t index, size_t count) {
+    assert(v != nullptr && v->tiny_type == ARRAY && index < v->u.a.capacity);
+    ASSERT_MUTABLE(v);
+
+    for (size_t i = 0; i < count; ++i) {
+        tiny_free(&v->u.a.e[index + i]);
+    }
+
+    // for (size_t i = 0; i < count; ++i) {
+    //     move(&v->u.a.e[index + i], &v->u.a.e[index + count + i]);
+    // }
+    memmove(v->u.a.e + index, v->u.a.e + index + count, (v->u.a.size - index - count) * sizeof(value));
+
+    // 末尾的元素已经被移动到前面，只需重新初始化，不能再次释放
+    for (size_t i = v->u.a.size - count; i < v->u.a.size; ++i) {
+        tiny_init(&v->u.a.e[i]);
+    }
+    v->u.a.size -= count;
+}
+
+void array_clear(value* v) {
+    assert(v != nullptr && v->tiny_type == ARRAY);
+    ASSERT_MUTABLE(v);
+    for (size_t i = 0; i < v->u.a.size; ++i) {
+        tiny_free(&v->u.a.e[i]);
+    }
+    v->u.a.size = 0;
+}
+
+value* get_array_element(const value* v, size_t index) {
+    assert(v != nullptr && v->tiny_type == ARRAY);
+    assert(index < v->u.a.size);
+    return &v->u.a.e[index];
+}
+
+void set_array(value* v, size_t capacity) {
+    assert(v != nullptr);
+    tiny_free(v);
+    v->tiny_type = ARRAY;
+    v->u.a.size = 0;
+    v->u.a.capacity = capacity;
+    v->u.a.e = capacity > 0 ? (value*)malloc(capacity * sizeof(value)) : nullptr;
+}
+
+size_t get_object_size(const value* v) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    return v->u.o.size;
+}
+
+const char* get_object_key(const value* v, size_t index) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    return KEY(&v->u.o.m[index]);
+}
+
+size_t get_object_key_length(const value* v, size_t index) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    assert(index < v->u.o.size);
+    return KEY_LEN(&v->u.o.m[index]);
+}
+
+value* get_object_value(const value* v, size_t index) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    return &v->u.o.m[index].v;
+}
+
+void set_object(value* v, size_t capacity) {
+    assert(v != nullptr);
+    tiny_free(v);
+    v->tiny_type = OBJECT;
+    v->u.o.size = 0;
+    v->u.o.capacity = capacity;
+    v->u.o.m = capacity > 0 ? (member*)malloc(capacity * sizeof(member)) : nullptr;
+}
+
+size_t get_object_capacity(const value* v) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    return v->u.o.capacity;
+}
+
+void object_reserve(value* v, size_t capacity) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    ASSERT_MUTABLE(v);
+    if (v->u.o.capacity >= capacity) {
+        return;
+    }
+    object_realloc(v, capacity, (v->tiny_flags & VALUE_FLAG_INDEXED) != 0);
+}
+
+void object_shrink(value* v) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    ASSERT_MUTABLE(v);
+    if (v->u.o.size == v->u.o.capacity) {
+        return;
+    }
+    // 收缩后成员数不足阈值时去掉索引
+    object_realloc(v, v->u.o.size, v->u.o.size >= OBJECT_INDEX_THRESHOLD);
+}
+
+void object_clear(value* v) {
+    assert(v != nullptr && v->tiny_type == OBJECT);
+    ASSERT_MUTABLE(v);
+    for (size_t i = 0; i < v->u.o.size; ++i) {
+        free_key(&v->u.o.m[i]);
+        tiny_free(&v->u.o.m[i].v);
+    }
+    v->u.o.size = 0;
+    if (v->tiny_flags & VALUE_FLAG_INDEXED) {
+        object_build_index(v);
+    }
+}
+
+value* set_object_value(value* v, char* key, size_t klen) { return set_object_value(v, key, klen, nullptr); }
+
+value* set_object_value(value* v, const char* key, size_t klen, key_table* keys) {
+    assert(v != nullptr && v->tiny_type == OBJECT && key != nullptr);
+    ASSERT_MUTABLE(v);
+    auto index = find_object_index(v, key, klen);
+    if (index != KEY_NOT_EXIST) {
+        return &v->u.o.m[index].v;
+    }
+    return object_append(v, key, klen, keys);
+}
+
+void remove_object_value(value* v, size_t index) {
+    assert(v != nullptr && v->tiny_type == OBJECT && index < v->u.o.size);
+    ASSERT_MUTABLE(v);
+    free_key(&v->u.o.m[index]);
+    tiny_free(&v->u.o.m[index].v);
+    memmove(&v->u.o.m[index], &v->u.o.m[index + 1], (v->u.o.size - index - 1) * sizeof(member));
+    auto size = v->u.o.size--;
+    KEY_SET(&v->u.o.m[size - 1], nullptr, 0, 0);
+    tiny_init(&v->u.o.m[size - 1].v);
+    // 后面的成员下标都变了，需要重建索引
+    if (v->tiny_flags & VALUE_FLAG_INDEXED) {
+        object_build_index(v);
+    }
+}
+
+// 释放一个array/object的元素、键和它自己的内存
+static void free_container(value* v) {
+    context c;
+    context_init(&c, nullptr, 0);
+    walk_frame f = {v, nullptr, 0};
+    for (;;) {
+        value* cur = (value*)f.a;
+        if (f.i < CHILD_COUNT(cur)) {
+            size_t i = f.i++;
+            if (cur->tiny_type == OBJECT) {
+                free_key(&cur->u.o.m[i]);
+            }
+            value* e = CHILD(cur, i);
+            if (IS_CONTAINER(e) && !(e->tiny_flags & VALUE_FLAG_ARENA)) {
+                walk_push(&c, &f);
+                f.a = e;
+                f.i = 0;
+            } else {
+                tiny_free(e);
+            }
+            continue;
+        }
+        free(cur->tiny_type == ARRAY ? (void*)cur->u.a.e : (void*)cur->u.o.m);
+        cur->tiny_type = TINYNULL;
+        cur->tiny_flags = 0;
+        if (c.top == 0) {
+            break;
+        }
+        memcpy(&f, context_pop(&c, sizeof(walk_frame)), sizeof(walk_frame));
+    }
+    free(c.stack);
+}
+
+void tiny_free(value* v) {
     assert(v != nullptr);
-    tiny_free(v);
-    v->tiny_type = ARRAY;
-    v->u.a.size = 0;
-    v->u.a.capacity = capacity;
-    v->u.a.e = capacity > 0 ? (value*)malloc(capacity * sizeof(value)) : nullptr;
+    if (v->tiny_flags & VALUE_FLAG_ARENA) {
+        // 内存属于arena，由arena_release统一释放
+        v->tiny_type = TINYNULL;
+        v->tiny_flags = 0;
+        return;
+    }
+    switch (v->tiny_type) {
+    case STRING:
+        if (!(v->tiny_flags & (VALUE_FLAG_VIEW | VALUE_FLAG_INLINE))) {
+            free(v->u.s.s);
+        }
+        break;
+    case ARRAY:
+    case OBJECT:
+        free_container(v);
+        break;
+    default:
+        break;
+    }
+    v->tiny_type = TINYNULL;
+    v->tiny_flags = 0;
+}
+
+// hash只在object有哈希索引时使用，此时必须等于hash_key(key, klen)
+static size_t find_member(const value* v, const char* key, size_t klen, size_t hash) {
+    size_t i;
+    if (v->tiny_flags & VALUE_FLAG_INDEXED) {
+        const uint32_t* slots = object_index(v);
+        size_t mask = index_slots(v->u.o.capacity) - 1;
+        for (size_t h = hash & mask; slots[h] != 0; h = (h + 1) & mask) {
+            const member* m = &v->u.o.m[slots[h] - 1];
+            if (KEY_LEN(m) == klen && (KEY(m) == key || memcmp(KEY(m), key, klen) == 0)) {
+                return slots[h] - 1;
+            }
+        }
+        return KEY_NOT_EXIST;
+    }
+    for (i = 0; i < v->u.o.size; ++i) {
+        const member* m = &v->u.o.m[i];
+        // 驻留的键与查找的键来自同一张表时只需比较指针
+        if (KEY_LEN(m) == klen && (KEY(m) == key || memcmp(KEY(m), key, klen) == 0)) {
+            return i;
+        }
+    }
+    return KEY_NOT_EXIST;
+}
+
+size_t find_object_index(const value* v, const char* key, size_t klen) {
+    assert(v != nullptr && v->tiny_type == OBJECT && key != nullptr);
+    return find_member(v, key, klen, (v->tiny_flags & VALUE_FLAG_INDEXED) ? hash_key(key, klen) : 0);
+}
+
+value* find_object_value(value* v, const char* key, size_t klen) {
+    auto index = find_object_index(v, key, klen);
+    return index == KEY_NOT_EXIST ? nullptr : &v->u.o.m[index].v;
+}
+
+// 比较两个节点本身，array/object只比较大小，元素由is_equal逐个比较
+static int is_equal_node(const value* lhs, const value* rhs) {
+    if (lhs->tiny_type != rhs->tiny_type) {
+        return 0;
+    }
+    switch (lhs->tiny_type) {
+    case STRING:
+        return STR_LEN(lhs) == STR_LEN(rhs) && memcmp(STR(lhs), STR(rhs), STR_LEN(lhs)) == 0;
+    case NUMBER:
+        return lhs->u.n == rhs->u.n;
+    case ARRAY:
+        return lhs->u.a.size == rhs->u.a.size;
+    case OBJECT:
+        return lhs->u.o.size == rhs->u.o.size;
+    default:
+        // TINYNULL、TRUE、FALSE这三种类型只需要比较类型相等即可
+        return 1;
+    }
+}
+
+int is_equal(const value* lhs, const value* rhs) {
+    assert(lhs != nullptr && rhs != nullptr);
+    if (!is_equal_node(lhs, rhs)) {
+        return 0;
+    }
+    if (!IS_CONTAINER(lhs)) {
+        return 1;
+    }
+    context c;
+    context_init(&c, nullptr, 0);
+    walk_frame f = {lhs, rhs, 0};
+    int ret = 1;
+    for (;;) {
+        if (f.i < CHILD_COUNT(f.a)) {
+            size_t i = f.i++;
+            const value* x = CHILD(f.a, i);
+            const value* y;
+            if (f.a->tiny_type == ARRAY) {
+                y = &f.b->u.a.e[i];
+            } else {
+                // object的成员顺序可以不同
+                auto index = find_object_index(f.b, KEY(&f.a->u.o.m[i]), KEY_LEN(&f.a->u.o.m[i]));
+                if (index == KEY_NOT_EXIST) {
+                    ret = 0;
+                    break;
+                }
+                y = &f.b->u.o.m[index].v;
+            }
+            if (!is_equal_node(x, y)) {
+                ret = 0;
+                break;
+            }
+            if (IS_CONTAINER(x)) {
+                walk_push(&c, &f);
+                f.a = x;
+                f.b = y;
+                f.i = 0;
+            }
+            continue;
+        }
+        if (c.top == 0) {
+            break;
+        }
+        memcpy(&f, context_pop(&c, sizeof(walk_frame)), sizeof(walk_frame));
+    }
+    free(c.stack);
+    return ret;
+}
+
+/* 紧凑DOM
+ * 节点的最后1字节是标记：低3位为类型，CVALUE_TAG_INLINE表示字符串直接存放在节点内，高4位为它的长度
+ * 长字符串的块为 [size_t len][字符][\0]，array的块为 [size_t size][cvalue...]，
+ * object的块为 [size_t size][键, 值, 键, 值...]，键也是字符串节点，所以成员可以看作两个连续的节点
+ * 解析时复用SAX解析器，完整的节点依次压入context的堆栈，array/object结束时把最后的元素/成员一次性移入新块
+ */
+const unsigned char CVALUE_TAG_INLINE = 1 << 3;
+
+inline unsigned char CTAG(const cvalue* v) { return v->b[15]; }
+
+inline type CTYPE(const cvalue* v) { return (type)(CTAG(v) & 7); }
+
+inline char* CBLOCK(const cvalue* v) {
+    char* p;
+    memcpy(&p, v->b, sizeof(p));
+    return p;
+}
+
+inline size_t CBLOCK_SIZE(const cvalue* v) {
+    char* p = CBLOCK(v);
+    return p ? *(size_t*)p : 0;
+}
+
+// array/object的元素，object的成员是两个连续的节点
+inline const cvalue* CITEMS(const cvalue* v) { return (const cvalue*)(CBLOCK(v) + sizeof(size_t)); }
+
+inline size_t CITEM_COUNT(const cvalue* v) { return CBLOCK_SIZE(v) * (CTYPE(v) == OBJECT ? 2 : 1); }
+
+inline bool CIS_CONTAINER(const cvalue* v) { return CTYPE(v) == ARRAY || CTYPE(v) == OBJECT; }
+
+// 有自己的堆内存的节点：长字符串、非空的array/object
+inline bool COWNS_BLOCK(const cvalue* v) {
+    return (CTYPE(v) == STRING && !(CTAG(v) & CVALUE_TAG_INLINE)) || (CIS_CONTAINER(v) && CBLOCK(v));
+}
+
+static void cvalue_set(cvalue* v, type t, const void* payload, size_t size) {
+    tiny_init(v);
+    if (size) {
+        memcpy(v->b, payload, size);
+    }
+    v->b[15] = (unsigned char)t;
+}
+
+static void cvalue_set_block(cvalue* v, type t, char* block) { cvalue_set(v, t, &block, sizeof(block)); }
+
+static void cvalue_set_string(cvalue* v, const char* s, size_t len) {
+    if (len <= CVALUE_INLINE_STRING) {
+        tiny_init(v);
+        memcpy(v->b, s, len);
+        v->b[15] = (unsigned char)(STRING | CVALUE_TAG_INLINE | len << 4);
+    } else {
+        char* p = (char*)malloc(sizeof(size_t) + len + 1);
+        *(size_t*)p = len;
+        memcpy(p + sizeof(size_t), s, len);
+        p[sizeof(size_t) + len] = '\0';
+        cvalue_set_block(v, STRING, p);
+    }
+}
+
+static void cvalue_set_number(cvalue* v, double n) { cvalue_set(v, NUMBER, &n, sizeof(n)); }
+
+// 以下向context的堆栈压入一个完整的节点
+inline cvalue* cbuild_push(context* c) { return (cvalue*)context_push(c, sizeof(cvalue)); }
+
+// array/object结束：堆栈顶部的count个元素/成员移入新块，换成array/object节点
+static void cbuild_end(context* c, type t, size_t count) {
+    char* p = nullptr;
+    if (count) {
+        size_t s = count * (t == OBJECT ? 2 : 1) * sizeof(cvalue);
+        p = (char*)malloc(sizeof(size_t) + s);
+        *(size_t*)p = count;
+        memcpy(p + sizeof(size_t), context_pop(c, s), s);
+    }
+    cvalue_set_block(cbuild_push(c), t, p);
+}
+
+static void cbuild_scalar(context* c, const value* v) {
+    switch (v->tiny_type) {
+    case NUMBER:
+        cvalue_set_number(cbuild_push(c), v->u.n);
+        break;
+    case STRING:
+        cvalue_set_string(cbuild_push(c), STR(v), STR_LEN(v));
+        break;
+    default:
+        cvalue_set(cbuild_push(c), v->tiny_type, nullptr, 0);
+        break;
+    }
+}
+
+// 解析失败时释放堆栈上已经完整的节点
+static void cbuild_free_all(context* c) {
+    while (c->top) {
+        tiny_free((cvalue*)context_pop(c, sizeof(cvalue)));
+    }
+}
+
+static int cbuild_null(void* user) {
+    cvalue_set(cbuild_push((context*)user), TINYNULL, nullptr, 0);
+    return 0;
+}
+
+static int cbuild_boolean(void* user, int b) {
+    cvalue_set(cbuild_push((context*)user), b ? TRUE : FALSE, nullptr, 0);
+    return 0;
+}
+
+static int cbuild_number(void* user, double n) {
+    cvalue_set_number(cbuild_push((context*)user), n);
+    return 0;
+}
+
+static int cbuild_string(void* user, const char* s, size_t len) {
+    cvalue_set_string(cbuild_push((context*)user), s, len);
+    return 0;
+}
+
+static int cbuild_end_array(void* user, size_t count) {
+    cbuild_end((context*)user, ARRAY, count);
+    return 0;
+}
+
+static int cbuild_end_object(void* user, size_t count) {
+    cbuild_end((context*)user, OBJECT, count);
+    return 0;
+}
+
+int parse(cvalue* v, const char* json, size_t len) { return parse(v, json, len, nullptr); }
+
+int parse(cvalue* v, const char* json, size_t len, const parse_options* opt) {
+    sax_handler h;
+    context c;
+    assert(v != nullptr);
+    sax_handler_init(&h);
+    h.null_value = cbuild_null;
+    h.boolean = cbuild_boolean;
+    h.number = cbuild_number;
+    h.string = h.key = cbuild_string; // 键也是字符串节点
+    h.end_array = cbuild_end_array;
+    h.end_object = cbuild_end_object;
+    context_init(&c, nullptr, 0);
+    tiny_init(v);
+    int ret = sax_parse(json, len, &h, &c, opt);
+    if (ret == PARSE_OK) {
+        assert(c.top == sizeof(cvalue));
+        memcpy(v, c.stack, sizeof(cvalue));
+    } else {
+        cbuild_free_all(&c);
+    }
+    free(c.stack);
+    return ret;
+}
+
+void compact(cvalue* dst, const value* src) {
+    context c, w;
+    assert(dst != nullptr && src != nullptr);
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    if (!IS_CONTAINER(src)) {
+        cbuild_scalar(&c, src);
+    } else {
+        walk_frame f = {src, nullptr, 0};
+        for (;;) {
+            if (f.i < CHILD_COUNT(f.a)) {
+                size_t i = f.i++;
+                if (f.a->tiny_type == OBJECT) {
+                    cvalue_set_string(cbuild_push(&c), KEY(&f.a->u.o.m[i]), KEY_LEN(&f.a->u.o.m[i]));
+                }
+                const value* e = CHILD(f.a, i);
+                if (IS_CONTAINER(e)) {
+                    walk_push(&w, &f);
+                    f.a = e;
+                    f.i = 0;
+                } else {
+                    cbuild_scalar(&c, e);
+                }
+                continue;
+            }
+            cbuild_end(&c, f.a->tiny_type, CHILD_COUNT(f.a));
+            if (w.top == 0) {
+                break;
+            }
+            memcpy(&f, context_pop(&w, sizeof(walk_frame)), sizeof(walk_frame));
+        }
+    }
+    assert(c.top == sizeof(cvalue));
+    tiny_free(dst);
+    memcpy(dst, c.stack, sizeof(cvalue));
+    free(c.stack);
+    free(w.stack);
+}
+
+void tiny_free(cvalue* v) {
+    assert(v != nullptr);
+    if (!COWNS_BLOCK(v)) {
+        tiny_init(v);
+        return;
+    }
+    // 待释放的节点压入堆栈，顺序无关紧要
+    context c;
+    context_init(&c, nullptr, 0);
+    memcpy(cbuild_push(&c), v, sizeof(cvalue));
+    while (c.top) {
+        cvalue cur;
+        memcpy(&cur, context_pop(&c, sizeof(cvalue)), sizeof(cvalue));
+        if (CIS_CONTAINER(&cur)) {
+            const cvalue* items = CITEMS(&cur);
+            for (size_t i = 0, n = CITEM_COUNT(&cur); i < n; ++i) {
+                if (COWNS_BLOCK(&items[i])) {
+                    memcpy(cbuild_push(&c), &items[i], sizeof(cvalue));
+                }
+            }
+        }
+        free(CBLOCK(&cur));
+    }
+    free(c.stack);
+    tiny_init(v);
+}
+
+type get_type(const cvalue* v) {
+    assert(v != nullptr);
+    return CTYPE(v);
+}
+
+double get_number(const cvalue* v) {
+    assert(v != nullptr && CTYPE(v) == NUMBER);
+    double n;
+    memcpy(&n, v->b, sizeof(n));
+    return n;
+}
+
+int get_boolean(const cvalue* v) {
+    assert(v != nullptr && (CTYPE(v) == TRUE || CTYPE(v) == FALSE));
+    return CTYPE(v) == TRUE;
+}
+
+const char* get_string(const cvalue* v) {
+    assert(v != nullptr && CTYPE(v) == STRING);
+    return CTAG(v) & CVALUE_TAG_INLINE ? (const char*)v->b : CBLOCK(v) + sizeof(size_t);
+}
+
+size_t get_string_len(const cvalue* v) {
+    assert(v != nullptr && CTYPE(v) == STRING);
+    return CTAG(v) & CVALUE_TAG_INLINE ? CTAG(v) >> 4 : CBLOCK_SIZE(v);
+}
+
+size_t get_array_size(const cvalue* v) {
+    assert(v != nullptr && CTYPE(v) == ARRAY);
+    return CBLOCK_SIZE(v);
+}
+
+const cvalue* get_array_element(const cvalue* v, size_t index) {
+    assert(v != nullptr && CTYPE(v) == ARRAY);
+    assert(index < CBLOCK_SIZE(v));
+    return &CITEMS(v)[index];
+}
+
+size_t get_object_size(const cvalue* v) {
+    assert(v != nullptr && CTYPE(v) == OBJECT);
+    return CBLOCK_SIZE(v);
+}
+
+const char* get_object_key(const cvalue* v, size_t index) {
+    assert(v != nullptr && CTYPE(v) == OBJECT);
+    assert(index < CBLOCK_SIZE(v));
+    return get_string(&CITEMS(v)[index * 2]);
+}
+
+size_t get_object_key_length(const cvalue* v, size_t index) {
+    assert(v != nullptr && CTYPE(v) == OBJECT);
+    assert(index < CBLOCK_SIZE(v));
+    return get_string_len(&CITEMS(v)[index * 2]);
+}
+
+const cvalue* get_object_value(const cvalue* v, size_t index) {
+    assert(v != nullptr && CTYPE(v) == OBJECT);
+    assert(index < CBLOCK_SIZE(v));
+    return &CITEMS(v)[index * 2 + 1];
+}
+
+size_t find_object_index(const cvalue* v, const char* key, size_t klen) {
+    assert(v != nullptr && CTYPE(v) == OBJECT && key != nullptr);
+    for (size_t i = 0, n = CBLOCK_SIZE(v); i < n; ++i) {
+        const cvalue* k = &CITEMS(v)[i * 2];
+        if (get_string_len(k) == klen && memcmp(get_string(k), key, klen) == 0) {
+            return i;
+        }
+    }
+    return KEY_NOT_EXIST;
+}
+
+const cvalue* find_object_value(const cvalue* v, const char* key, size_t klen) {
+    auto index = find_object_index(v, key, klen);
+    return index == KEY_NOT_EXIST ? nullptr : &CITEMS(v)[index * 2 + 1];
+}
+
+static int is_equal_cnode(const cvalue* lhs, const cvalue* rhs) {
+    if (CTYPE(lhs) != CTYPE(rhs)) {
+        return 0;
+    }
+    switch (CTYPE(lhs)) {
+    case STRING:
+        return get_string_len(lhs) == get_string_len(rhs) &&
+               memcmp(get_string(lhs), get_string(rhs), get_string_len(lhs)) == 0;
+    case NUMBER:
+        return get_number(lhs) == get_number(rhs);
+    case ARRAY:
+    case OBJECT:
+        return CBLOCK_SIZE(lhs) == CBLOCK_SIZE(rhs);
+    default:
+        return 1;
+    }
+}
+
+int is_equal(const cvalue* lhs, const cvalue* rhs) {
+    assert(lhs != nullptr && rhs != nullptr);
+    if (!is_equal_cnode(lhs, rhs)) {
+        return 0;
+    }
+    // 待比较的array/object成对压入堆栈，比较顺序无关紧要
+    context c;
+    context_init(&c, nullptr, 0);
+    const cvalue* pair[2] = {lhs, rhs};
+    int ret = 1;
+    if (CIS_CONTAINER(lhs)) {
+        memcpy(context_push(&c, sizeof(pair)), pair, sizeof(pair));
+    }
+    while (ret && c.top) {
+        memcpy(pair, context_pop(&c, sizeof(pair)), sizeof(pair));
+        const cvalue* a = pair[0];
+        const cvalue* b = pair[1];
+        for (size_t i = 0, n = CBLOCK_SIZE(a); i < n; ++i) {
+            if (CTYPE(a) == ARRAY) {
+                pair[0] = &CITEMS(a)[i];
+                pair[1] = &CITEMS(b)[i];
+            } else {
+                // object的成员顺序可以不同
+                const cvalue* k = &CITEMS(a)[i * 2];
+                pair[0] = k + 1;
+                pair[1] = find_object_value(b, get_string(k), get_string_len(k));
+                if (!pair[1]) {
+                    ret = 0;
+                    break;
+                }
+            }
+            if (!is_equal_cnode(pair[0], pair[1])) {
+                ret = 0;
+                break;
+            }
+            if (CIS_CONTAINER(pair[0])) {
+                memcpy(context_push(&c, sizeof(pair)), pair, sizeof(pair));
+            }
+        }
+    }
+    free(c.stack);
+    return ret;
+}
+
+char* stringify(const cvalue* v, size_t* len) {
+    typedef struct {
+        const cvalue* a; // 正在输出的array/object
+        size_t i;        // 下一个要输出的元素
+    } cwalk_frame;
+    context c, w;
+    assert(v != nullptr);
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    c.stack = (char*)malloc(c.size = PARSE_STACK_INIT_SIZE);
+    cwalk_frame f = {v, 0};
+    const cvalue* e = v;
+    for (;;) {
+        // e为下一个要输出的节点，array/object输出左括号后进入，之后依次输出它的元素
+        if (e) {
+            switch (CTYPE(e)) {
+            case TINYNULL:
+                PUTS(&c, "null", 4);
+                break;
+            case TRUE:
+                PUTS(&c, "true", 4);
+                break;
+            case FALSE:
+                PUTS(&c, "false", 5);
+                break;
+            case NUMBER: {
+                char* buffer = (char*)context_push(&c, 32);
+                c.top -= 32 - (dtoa(get_number(e), buffer) - buffer);
+                break;
+            }
+            case STRING:
+                stringify_string(&c, get_string(e), get_string_len(e));
+                break;
+            default:
+                PUTC(&c, CTYPE(e) == ARRAY ? '[' : '{');
+                if (e != v) {
+                    memcpy(context_push(&w, sizeof(cwalk_frame)), &f, sizeof(cwalk_frame));
+                }
+                f.a = e;
+                f.i = 0;
+                break;
+            }
+            e = nullptr;
+        }
+        if (!CIS_CONTAINER(f.a)) {
+            break;
+        }
+        if (f.i < CBLOCK_SIZE(f.a)) {
+            size_t i = f.i++;
+            if (i != 0) {
+                PUTC(&c, ',');
+            }
+            if (CTYPE(f.a) == OBJECT) {
+                const cvalue* k = &CITEMS(f.a)[i * 2];
+                stringify_string(&c, get_string(k), get_string_len(k));
+                PUTC(&c, ':');
+                e = k + 1;
+            } else {
+                e = &CITEMS(f.a)[i];
+            }
+            continue;
+        }
+        PUTC(&c, CTYPE(f.a) == ARRAY ? ']' : '}');
+        if (w.top == 0) {
+            break;
+        }
+        memcpy(&f, context_pop(&w, sizeof(cwalk_frame)), sizeof(cwalk_frame));
+    }
+    free(w.stack);
+    if (len) {
+        *len = c.top;
+    }
+    PUTC(&c, '\0');
+    return c.stack;
 }
 
-size_t get_object_size(const value* v) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    return v->u.o.size;
+/* JSON Pointer
+ * 编译时一次分配tokens数组和反转义后的键，"~1"还原为'/'，"~0"还原为'~'，反转义后的键不会比原来长
+ * 每个token同时按数组下标解析：只允许"0"或者不以'0'开头的十进制数，溢出时视为不是下标
+ */
+static size_t pointer_index(const char* s, size_t len) {
+    if (len == 1 && s[0] == '-') {
+        return POINTER_END_INDEX;
+    }
+    if (len == 0 || (s[0] == '0' && len > 1)) {
+        return POINTER_NO_INDEX;
+    }
+    size_t index = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (!ISDIGIT(s[i]) || index > (POINTER_END_INDEX - 1 - (size_t)(s[i] - '0')) / 10) {
+            return POINTER_NO_INDEX;
+        }
+        index = index * 10 + (size_t)(s[i] - '0');
+    }
+    return index;
 }
 
-const char* get_object_key(const value* v, size_t index) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    return v->u.o.m[index].k;
+int pointer_compile(pointer* p, const char* s, size_t len) {
+    assert(p != nullptr && (s != nullptr || len == 0));
+    p->tokens = nullptr;
+    p->count = 0;
+    if (len == 0) {
+        return POINTER_OK;
+    }
+    if (s[0] != '/') {
+        return POINTER_INVALID;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < len; ++i) {
+        count += s[i] == '/';
+    }
+    pointer_token* tokens = (pointer_token*)malloc(count * sizeof(pointer_token) + len);
+    char* key = (char*)(tokens + count);
+    const char* end = s + len;
+    for (size_t n = 0; n < count; ++n) {
+        pointer_token* t = &tokens[n];
+        t->key = key;
+        for (++s; s != end && *s != '/'; ++s) {
+            if (*s != '~') {
+                *key++ = *s;
+            } else if (s + 1 != end && (s[1] == '0' || s[1] == '1')) {
+                *key++ = *++s == '0' ? '~' : '/';
+            } else {
+                free(tokens);
+                return POINTER_INVALID;
+            }
+        }
+        t->len = (size_t)(key - t->key);
+        t->index = pointer_index(t->key, t->len);
+        t->hash = hash_key(t->key, t->len);
+    }
+    p->tokens = tokens;
+    p->count = count;
+    return POINTER_OK;
 }
 
-size_t get_object_key_length(const value* v, size_t index) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    assert(index < v->u.o.size);
-    return v->u.o.m[index].klen;
+void pointer_free(pointer* p) {
+    assert(p != nullptr);
+    free(p->tokens);
+    p->tokens = nullptr;
+    p->count = 0;
 }
 
-value* get_object_value(const value* v, size_t index) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    return &v->u.o.m[index].v;
+// 按一个token取子节点，类型不对或不存在时返回nullptr；"-"和非下标的index不小于任何数组的大小
+static value* pointer_child(const value* v, const pointer_token* t) {
+    if (v->tiny_type == OBJECT) {
+        size_t index = find_member(v, t->key, t->len, t->hash);
+        return index == KEY_NOT_EXIST ? nullptr : &v->u.o.m[index].v;
+    }
+    if (v->tiny_type == ARRAY && t->index < v->u.a.size) {
+        return &v->u.a.e[t->index];
+    }
+    return nullptr;
 }
 
-void set_object(value* v, size_t capacity) {
-    assert(v != nullptr);
-    tiny_free(v);
-    v->tiny_type = OBJECT;
-    v->u.o.size = 0;
-    v->u.o.capacity = capacity;
-    v->u.o.m = capacity > 0 ? (member*)malloc(capacity * sizeof(member)) : nullptr;
+// 查找前count个token指向的节点
+static value* pointer_walk(const value* v, const pointer* p, size_t count) {
+    for (size_t i = 0; i < count && v != nullptr; ++i) {
+        v = pointer_child(v, &p->tokens[i]);
+    }
+    return (value*)v;
 }
 
-size_t get_object_capacity(const value* v) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    return v->u.o.capacity;
+value* pointer_get(const value* v, const pointer* p) {
+    assert(v != nullptr && p != nullptr);
+    return pointer_walk(v, p, p->count);
 }
 
-void object_reserve(value* v, size_t capacity) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    if (v->u.o.capacity >= capacity) {
-        return;
+value* pointer_get(const value* v, const char* s, size_t len) {
+    pointer p;
+    if (pointer_compile(&p, s, len) != POINTER_OK) {
+        return nullptr;
     }
-    v->u.o.capacity = capacity;
-    v->u.o.m = (member*)realloc(v->u.o.m, capacity * sizeof(member));
+    value* ret = pointer_get(v, &p);
+    pointer_free(&p);
+    return ret;
 }
 
-void object_shrink(value* v) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    if (v->u.o.size == v->u.o.capacity) {
-        return;
+const cvalue* pointer_get(const cvalue* v, const pointer* p) {
+    assert(v != nullptr && p != nullptr);
+    for (size_t i = 0; i < p->count && v != nullptr; ++i) {
+        const pointer_token* t = &p->tokens[i];
+        if (CTYPE(v) == OBJECT) {
+            v = find_object_value(v, t->key, t->len);
+        } else if (CTYPE(v) == ARRAY && t->index < CBLOCK_SIZE(v)) {
+            v = &CITEMS(v)[t->index];
+        } else {
+            v = nullptr;
+        }
     }
-    v->u.o.capacity = v->u.o.size;
-    v->u.o.m = (member*)realloc(v->u.o.m, v->u.o.capacity * sizeof(member));
+    return v;
 }
 
-void object_clear(value* v) {
-    assert(v != nullptr && v->tiny_type == OBJECT);
-    for (size_t i = 0; i < v->u.o.size; ++i) {
-        free(v->u.o.m[i].k);
-        v->u.o.m[i].k = nullptr;
-        v->u.o.m[i].klen = 0;
-        tiny_free(&v->u.o.m[i].v);
+// 在父节点中新增或者定位最后一个token，insert为真时array在下标处插入
+static value* pointer_add(value* v, const pointer* p, bool insert) {
+    assert(v != nullptr && p != nullptr);
+    if (p->count == 0) {
+        return v;
     }
-    v->u.o.size = 0;
+    value* parent = pointer_walk(v, p, p->count - 1);
+    if (parent == nullptr) {
+        return nullptr;
+    }
+    ASSERT_MUTABLE(parent);
+    const pointer_token* t = &p->tokens[p->count - 1];
+    if (parent->tiny_type == OBJECT) {
+        size_t index = find_member(parent, t->key, t->len, t->hash);
+        return index != KEY_NOT_EXIST ? &parent->u.o.m[index].v : object_append(parent, t->key, t->len, nullptr);
+    }
+    if (parent->tiny_type != ARRAY) {
+        return nullptr;
+    }
+    size_t size = parent->u.a.size;
+    if (t->index == POINTER_END_INDEX || t->index == size) {
+        return array_pushback(parent);
+    }
+    if (t->index > size) {
+        return nullptr;
+    }
+    return insert ? array_insert(parent, t->index) : &parent->u.a.e[t->index];
 }
 
-value* set_object_value(value* v, char* key, size_t klen) {
-    assert(v != nullptr && v->tiny_type == OBJECT && key != nullptr);
-    auto index = find_object_index(v, key, klen);
-    if (index != KEY_NOT_EXIST) {
-        return &v->u.o.m[index].v;
+value* pointer_set(value* v, const pointer* p) { return pointer_add(v, p, false); }
+
+value* pointer_insert(value* v, const pointer* p) { return pointer_add(v, p, true); }
+
+int pointer_remove(value* v, const pointer* p) {
+    assert(v != nullptr && p != nullptr);
+    if (p->count == 0) {
+        return POINTER_NOT_FOUND;
     }
-    if (v->u.o.capacity == v->u.o.size) {
-        object_reserve(v, v->u.o.capacity == 0 ? 1 : v->u.o.capacity * EXPAND_COEFFICIENT);
+    value* parent = pointer_walk(v, p, p->count - 1);
+    if (parent == nullptr) {
+        return POINTER_NOT_FOUND;
     }
-    auto size = v->u.o.size++;
-    v->u.o.m[size].k = (char*)malloc(klen + 1);
-    memcpy(v->u.o.m[size].k, key, klen);
-    v->u.o.m[size].k[klen] = '\0';
-    v->u.o.m[size].klen = klen;
-    tiny_init(&v->u.o.m[size].v);
-    return &v->u.o.m[size].v;
+    const pointer_token* t = &p->tokens[p->count - 1];
+    if (parent->tiny_type == OBJECT) {
+        size_t index = find_member(parent, t->key, t->len, t->hash);
+        if (index == KEY_NOT_EXIST) {
+            return POINTER_NOT_FOUND;
+        }
+        remove_object_value(parent, index);
+        return POINTER_OK;
+    }
+    if (parent->tiny_type != ARRAY || t->index >= parent->u.a.size) {
+        return POINTER_NOT_FOUND;
+    }
+    array_erase(parent, t->index, 1);
+    return POINTER_OK;
 }
 
-void remove_object_value(value* v, size_t index) {
-    assert(v != nullptr && v->tiny_type == OBJECT && index < v->u.o.size);
-    free(v->u.o.m[index].k);
-    tiny_free(&v->u.o.m[index].v);
-    memcpy(&v->u.o.m[index], &v->u.o.m[index + 1], (v->u.o.size - index - 1) * sizeof(member));
-    auto size = v->u.o.size--;
-    v->u.o.m[size - 1].k = nullptr;
-    v->u.o.m[size - 1].klen = 0;
-    tiny_init(&v->u.o.m[size - 1].v);
+/* 惰性DOM
+ * 解析与sax_parse_value的结构相同，词法部分同样复用parse_literal/parse_number/parse_string_raw，
+ * 只是每个值在d->nodes中追加一项；堆栈上只压入尚未结束的array/object在nodes中的下标
+ * 访问时按需生成的内容（反转义的字符串、子节点表）在节点上标记LVALUE_MATERIALIZED，重新解析或释放时统一释放
+ */
+const unsigned char LVALUE_ESCAPED = 1 << 0;      // 字符串含转义
+const unsigned char LVALUE_MATERIALIZED = 1 << 1; // b.copy/b.children已经生成
+
+inline bool LIS_CONTAINER(const lvalue* v) { return v->type == ARRAY || v->type == OBJECT; }
+
+// 同一层的下一个节点
+inline const lvalue* LNEXT(const lvalue* v) { return v + (LIS_CONTAINER(v) ? v->a.skip : 1); }
+
+static lvalue* lazy_push(lazy_doc* d, type t) {
+    if (d->size == d->capacity) {
+        d->capacity = d->capacity < 16 ? 16 : d->capacity + (d->capacity >> 1);
+        d->nodes = (lvalue*)realloc(d->nodes, d->capacity * sizeof(lvalue));
+    }
+    lvalue* v = &d->nodes[d->size++];
+    v->type = (unsigned char)t;
+    v->flags = 0;
+    v->len = 0;
+    return v;
 }
 
-void tiny_free(value* v) {
-    assert(v != nullptr);
-    size_t i;
-    switch (v->tiny_type) {
-    case STRING:
-        free(v->u.s.s);
-        break;
-    case ARRAY:
-        for (i = 0; i < v->u.a.size; ++i) {
-            tiny_free(&v->u.a.e[i]);
+// 释放访问时生成的内容，保留nodes以便重新解析
+static void lazy_release(lazy_doc* d) {
+    for (size_t i = 0; i < d->size; ++i) {
+        lvalue* v = &d->nodes[i];
+        if (v->flags & LVALUE_MATERIALIZED) {
+            free(v->type == STRING ? (void*)v->b.copy : (void*)v->b.children);
         }
-        free(v->u.a.e);
-        break;
-    case OBJECT:
-        for (i = 0; i < v->u.o.size; ++i) {
-            free(v->u.o.m[i].k);
-            tiny_free(&v->u.o.m[i].v);
+    }
+    d->size = 0;
+}
+
+void tiny_free(lazy_doc* d) {
+    assert(d != nullptr);
+    lazy_release(d);
+    free(d->nodes);
+    tiny_init(d);
+}
+
+static int lazy_parse_string(context* c, lazy_doc* d) {
+    const char* q = c->json;
+    const char* str;
+    size_t len;
+    bool in_input;
+    int ret;
+    if ((ret = parse_string_raw(c, &str, &len, &in_input)) == PARSE_OK) {
+        lvalue* v = lazy_push(d, STRING);
+        v->a.s = q;
+        v->len = len;
+        if (!in_input) {
+            v->flags = LVALUE_ESCAPED;
+            v->b.raw = (size_t)(c->json - q);
         }
-        free(v->u.o.m);
+    }
+    return ret;
+}
+
+static int lazy_parse_scalar(context* c, lazy_doc* d) {
+    value v; // 只用来接收标量的词法分析结果，不会分配内存
+    int ret;
+    if (c->json == c->end) {
+        return PARSE_EXPECT_VALUE;
+    }
+    switch (*c->json) {
+    case 'n':
+        ret = parse_literal(c, &v, "null", TINYNULL);
         break;
-    default:
+    case 't':
+        ret = parse_literal(c, &v, "true", TRUE);
+        break;
+    case 'f':
+        ret = parse_literal(c, &v, "false", FALSE);
         break;
+    case '"':
+        return lazy_parse_string(c, d);
+    default:
+        if ((ret = parse_number(c, &v)) == PARSE_OK) {
+            lazy_push(d, NUMBER)->b.n = v.u.n;
+        }
+        return ret;
     }
-    v->tiny_type = TINYNULL;
+    if (ret == PARSE_OK) {
+        lazy_push(d, v.tiny_type);
+    }
+    return ret;
 }
 
-size_t find_object_index(const value* v, const char* key, size_t klen) {
-    size_t i;
-    assert(v != nullptr && v->tiny_type == OBJECT && key != nullptr);
-    for (i = 0; i < v->u.o.size; ++i) {
-        if (v->u.o.m[i].klen == klen && memcmp(v->u.o.m[i].k, key, klen) == 0) {
+// 解析object成员的 key ws ':' ws 部分
+static int lazy_parse_key(context* c, lazy_doc* d) {
+    int ret;
+    if (PEEK(c) != '"') {
+        return PARSE_MISS_KEY;
+    }
+    if ((ret = lazy_parse_string(c, d)) != PARSE_OK) {
+        return ret;
+    }
+    parse_whitespace(c);
+    if (PEEK(c) != ':') {
+        return PARSE_MISS_COLON;
+    }
+    c->json++;
+    parse_whitespace(c);
+    return PARSE_OK;
+}
+
+static int lazy_parse_value(context* c, lazy_doc* d) {
+    int ret;
+    for (;;) {
+        // 解析一个值，遇到非空的array/object时压入它的下标，接着解析它的第一个元素
+        char ch = PEEK(c);
+        if (ch == '[' || ch == '{') {
+            if (c->top / sizeof(size_t) == c->max_depth) {
+                return PARSE_TOO_DEEP;
+            }
+            c->json++;
+            lvalue* v = lazy_push(d, ch == '[' ? ARRAY : OBJECT);
+            v->a.skip = 1;
+            parse_whitespace(c);
+            if (PEEK(c) != (ch == '[' ? ']' : '}')) {
+                *(size_t*)context_push(c, sizeof(size_t)) = d->size - 1;
+                if (ch == '{' && (ret = lazy_parse_key(c, d)) != PARSE_OK) {
+                    return ret;
+                }
+                continue;
+            }
+            c->json++;
+        } else if ((ret = lazy_parse_scalar(c, d)) != PARSE_OK) {
+            return ret;
+        }
+
+        // 值已经完整，计入外层的array/object；外层随之结束时继续向上
+        for (;;) {
+            if (c->top == 0) {
+                return PARSE_OK;
+            }
+            size_t index = *((size_t*)(c->stack + c->top) - 1);
+            bool is_object = d->nodes[index].type == OBJECT;
+            d->nodes[index].len++;
+            parse_whitespace(c);
+            ch = PEEK(c);
+            if (ch == ',') {
+                c->json++;
+                parse_whitespace(c);
+                if (is_object && (ret = lazy_parse_key(c, d)) != PARSE_OK) {
+                    return ret;
+                }
+                break;
+            }
+            if (ch != (is_object ? '}' : ']')) {
+                return is_object ? PARSE_MISS_COMMA_OR_CURLY_BRACKET : PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            }
+            c->json++;
+            context_pop(c, sizeof(size_t));
+            d->nodes[index].a.skip = d->size - index;
+        }
+    }
+}
+
+int parse(lazy_doc* d, const char* json, size_t len) { return parse(d, json, len, nullptr); }
+
+int parse(lazy_doc* d, const char* json, size_t len, const parse_options* opt) {
+    context c;
+    assert(d != nullptr && (json != nullptr || len == 0));
+    lazy_release(d);
+    context_init(&c, json, len);
+    if (opt) {
+        c.max_depth = opt->max_depth;
+        if (opt->work) {
+            c.stack = opt->work->stack;
+            c.size = opt->work->size;
+        }
+    }
+    parse_whitespace(&c);
+
+    int ret;
+    if ((ret = lazy_parse_value(&c, d)) == PARSE_OK) {
+        parse_whitespace(&c);
+        if (c.json != c.end) {
+            ret = PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    if (opt && opt->work) {
+        opt->work->stack = c.stack;
+        opt->work->size = c.size;
+        shrink_buffer(&opt->work->stack, &opt->work->size, opt->work->retain);
+    } else {
+        free(c.stack);
+    }
+    if (ret != PARSE_OK) {
+        d->size = 0; // 出错之前的项都还没有生成过内容，不需要释放
+    }
+    return ret;
+}
+
+// 第一次访问含转义的字符串时反转义，输入已经校验过，不会出错
+static const char* lazy_string(const lvalue* v) {
+    lvalue* m = (lvalue*)v;
+    if (!(m->flags & LVALUE_MATERIALIZED)) {
+        context c;
+        const char* str;
+        size_t len;
+        bool in_input;
+        context_init(&c, m->a.s, m->b.raw);
+        int ret = parse_string_raw(&c, &str, &len, &in_input);
+        assert(ret == PARSE_OK && len == m->len);
+        (void)ret;
+        m->b.copy = (char*)malloc(len + 1);
+        memcpy(m->b.copy, str, len);
+        m->b.copy[len] = '\0';
+        m->flags |= LVALUE_MATERIALIZED;
+        free(c.stack);
+    }
+    return m->b.copy;
+}
+
+// 第一次按下标访问时建立子节点表，object的表中是键
+static const lvalue* const* lazy_children(const lvalue* v) {
+    lvalue* m = (lvalue*)v;
+    if (!(m->flags & LVALUE_MATERIALIZED)) {
+        const lvalue** children = (const lvalue**)malloc(m->len * sizeof(lvalue*));
+        const lvalue* e = v + 1;
+        for (size_t i = 0; i < m->len; ++i) {
+            children[i] = e;
+            e = LNEXT(m->type == OBJECT ? e + 1 : e);
+        }
+        m->b.children = children;
+        m->flags |= LVALUE_MATERIALIZED;
+    }
+    return m->b.children;
+}
+
+type get_type(const lvalue* v) {
+    assert(v != nullptr);
+    return (type)v->type;
+}
+
+double get_number(const lvalue* v) {
+    assert(v != nullptr && v->type == NUMBER);
+    return v->b.n;
+}
+
+int get_boolean(const lvalue* v) {
+    assert(v != nullptr && (v->type == TRUE || v->type == FALSE));
+    return v->type == TRUE;
+}
+
+const char* get_string(const lvalue* v) {
+    assert(v != nullptr && v->type == STRING);
+    return v->flags & LVALUE_ESCAPED ? lazy_string(v) : v->a.s + 1;
+}
+
+size_t get_string_len(const lvalue* v) {
+    assert(v != nullptr && v->type == STRING);
+    return v->len;
+}
+
+size_t get_array_size(const lvalue* v) {
+    assert(v != nullptr && v->type == ARRAY);
+    return v->len;
+}
+
+const lvalue* get_array_element(const lvalue* v, size_t index) {
+    assert(v != nullptr && v->type == ARRAY);
+    assert(index < v->len);
+    return lazy_children(v)[index];
+}
+
+size_t get_object_size(const lvalue* v) {
+    assert(v != nullptr && v->type == OBJECT);
+    return v->len;
+}
+
+const char* get_object_key(const lvalue* v, size_t index) {
+    assert(v != nullptr && v->type == OBJECT);
+    assert(index < v->len);
+    return get_string(lazy_children(v)[index]);
+}
+
+size_t get_object_key_length(const lvalue* v, size_t index) {
+    assert(v != nullptr && v->type == OBJECT);
+    assert(index < v->len);
+    return lazy_children(v)[index]->len;
+}
+
+const lvalue* get_object_value(const lvalue* v, size_t index) {
+    assert(v != nullptr && v->type == OBJECT);
+    assert(index < v->len);
+    return lazy_children(v)[index] + 1;
+}
+
+size_t find_object_index(const lvalue* v, const char* key, size_t klen) {
+    assert(v != nullptr && v->type == OBJECT && key != nullptr);
+    const lvalue* k = v + 1;
+    for (size_t i = 0; i < v->len; ++i) {
+        if (k->len == klen && memcmp(get_string(k), key, klen) == 0) {
             return i;
         }
+        k = LNEXT(k + 1);
     }
     return KEY_NOT_EXIST;
 }
 
-value* find_object_value(value* v, const char* key, size_t klen) {
-    auto index = find_object_index(v, key, klen);
-    return index == KEY_NOT_EXIST ? nullptr : &v->u.o.m[index].v;
+const lvalue* find_object_value(const lvalue* v, const char* key, size_t klen) {
+    assert(v != nullptr && v->type == OBJECT && key != nullptr);
+    const lvalue* k = v + 1;
+    for (size_t i = 0; i < v->len; ++i) {
+        if (k->len == klen && memcmp(get_string(k), key, klen) == 0) {
+            return k + 1;
+        }
+        k = LNEXT(k + 1);
+    }
+    return nullptr;
 }
 
-int is_equal(const value* lhs, const value* rhs) {
-    size_t i;
-    assert(lhs != nullptr && rhs != nullptr);
-    if (lhs->tiny_type != rhs->tiny_type) {
-        return 0;
+const lvalue* pointer_get(const lvalue* v, const pointer* p) {
+    assert(v != nullptr && p != nullptr);
+    for (size_t i = 0; i < p->count && v != nullptr; ++i) {
+        const pointer_token* t = &p->tokens[i];
+        if (v->type == OBJECT) {
+            v = find_object_value(v, t->key, t->len);
+        } else if (v->type == ARRAY && t->index < v->len) {
+            v = get_array_element(v, t->index);
+        } else {
+            v = nullptr;
+        }
     }
+    return v;
+}
 
-    switch (lhs->tiny_type) {
-    case STRING:
-        return lhs->u.s.len == rhs->u.s.len && memcmp(lhs->u.s.s, rhs->u.s.s, lhs->u.s.len) == 0;
-    case NUMBER:
-        return lhs->u.n == rhs->u.n;
-    case ARRAY:
-        if (lhs->u.a.size != rhs->u.a.size) {
-            return 0;
+// 子树在索引中是连续的，按顺序输出即可，堆栈上只记录每层array/object还剩下的元素个数
+char* stringify(const lvalue* v, size_t* len) {
+    typedef struct {
+        size_t left;    // 还没有输出的元素/成员个数
+        bool is_object; // 是否是object
+    } lwalk_frame;
+    context c, w;
+    assert(v != nullptr);
+    context_init(&c, nullptr, 0);
+    context_init(&w, nullptr, 0);
+    c.stack = (char*)malloc(c.size = PARSE_STACK_INIT_SIZE);
+    lwalk_frame f = {0, false};
+    for (const lvalue *e = v, *end = LNEXT(v); e != end; ++e) {
+        switch (e->type) {
+        case TINYNULL:
+            PUTS(&c, "null", 4);
+            break;
+        case TRUE:
+            PUTS(&c, "true", 4);
+            break;
+        case FALSE:
+            PUTS(&c, "false", 5);
+            break;
+        case NUMBER: {
+            char* buffer = (char*)context_push(&c, 32);
+            c.top -= 32 - (dtoa(e->b.n, buffer) - buffer);
+            break;
         }
-        for (i = 0; i < lhs->u.a.size; ++i) {
-            if (is_equal(&lhs->u.a.e[i], &rhs->u.a.e[i]) == 0) {
-                return 0;
+        case STRING:
+            stringify_string(&c, get_string(e), e->len);
+            break;
+        default:
+            PUTC(&c, e->type == ARRAY ? '[' : '{');
+            if (e->len > 0) {
+                if (e != v) {
+                    memcpy(context_push(&w, sizeof(lwalk_frame)), &f, sizeof(lwalk_frame));
+                }
+                f.left = e->len;
+                f.is_object = e->type == OBJECT;
+                if (f.is_object) {
+                    stringify_string(&c, get_string(e + 1), e[1].len);
+                    PUTC(&c, ':');
+                    ++e;
+                }
+                continue;
             }
+            PUTC(&c, e->type == ARRAY ? ']' : '}');
+            break;
         }
-        return 1;
-    case OBJECT:
-        if (lhs->u.o.size != rhs->u.o.size) {
-            return 0;
-        }
-        for (i = 0; i < lhs->u.o.size; ++i) {
-            auto index = find_object_index(rhs, lhs->u.o.m[i].k, lhs->u.o.m[i].klen);
-            if (index == KEY_NOT_EXIST) {
-                return 0;
+        // 一个值输出完毕：还有元素时输出分隔符（object还要输出下一个键），否则关闭这一层并继续向上
+        while (e != v) {
+            if (--f.left > 0) {
+                PUTC(&c, ',');
+                if (f.is_object) {
+                    ++e;
+                    stringify_string(&c, get_string(e), e->len);
+                    PUTC(&c, ':');
+                }
+                break;
             }
-            if (is_equal(&lhs->u.o.m[i].v, &rhs->u.o.m[index].v) == 0) {
-                return 0;
+            PUTC(&c, f.is_object ? '}' : ']');
+            if (w.top == 0) {
+                break;
             }
+            memcpy(&f, context_pop(&w, sizeof(lwalk_frame)), sizeof(lwalk_frame));
         }
-        return 1;
-    default:
-        // TINYNULL、TRUE、FALSE这三种类型只需要比较类型相等即可
-        return 1;
     }
+    free(w.stack);
+    if (len) {
+        *len = c.top;
+    }
+    PUTC(&c, '\0');
+    return c.stack;
 }
 } // namespace tinyjson
\ No newline at end of file
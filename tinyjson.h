@@ -8,17 +8,42 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdio>
 
 namespace tinyjson {
 const int PARSE_STACK_INIT_SIZE = 256;
+// array/object默认的最大嵌套层数
+const size_t PARSE_MAX_DEPTH = 1024;
 const size_t KEY_NOT_EXIST = (size_t)-1;
 const double EXPAND_COEFFICIENT = 2;
+// object的成员数达到这个值后建立哈希索引，查找从线性扫描变为平均O(1)
+const size_t OBJECT_INDEX_THRESHOLD = 16;
+// PARSE_FLAG_IN_PLACE时，array/object的元素/成员数达到这个值后改为直接写入最终的内存块
+const size_t PARSE_IN_PLACE_THRESHOLD = 64;
+// 不超过这个长度的字符串和键直接存放在value/member内，不另外分配内存
+const size_t VALUE_INLINE_STRING = 3 * sizeof(size_t) - 1;
+const size_t MEMBER_INLINE_KEY = 2 * sizeof(size_t) - 1;
+// 流式生成时调用者提供的缓冲区的最小大小，需要能放下一个完整的数字
+const size_t STRINGIFY_MIN_BUFFER_SIZE = 64;
+// stringify_file/stringify_fd使用的缓冲区大小
+const size_t STRINGIFY_BUFFER_SIZE = 4096;
 
 // tinyjson支持的数据结构
 typedef enum { TINYNULL, FALSE, TRUE, NUMBER, STRING, ARRAY, OBJECT } type;
 
 typedef struct value value;
 typedef struct member member;
+typedef struct cvalue cvalue;
+typedef struct arena arena;
+typedef struct arena_block arena_block;
+typedef struct parse_options parse_options;
+typedef struct scratch scratch;
+typedef struct key_table key_table;
+typedef struct sax_handler sax_handler;
+typedef struct push_parser push_parser;
+typedef struct ndjson_options ndjson_options;
+typedef struct mapped_file mapped_file;
+typedef struct stringify_options stringify_options;
 
 struct value {
     // 使用union来节省内存空间
@@ -34,15 +59,22 @@ struct value {
         struct {
             char* s;
             size_t len;
-        } s;      // string
-        double n; // number
+        } s;                         // string
+        char ss[3 * sizeof(size_t)]; // 不超过VALUE_INLINE_STRING字节的字符串直接存放在这里，以'\0'结尾
+        double n;                    // number
     } u;
     type tiny_type;
+    unsigned int tiny_flags; // 内部使用的标志位，例如节点的内存是否来自arena
 };
 
 struct member {
-    char* k;
-    size_t klen;
+    union {
+        struct {
+            char* s;
+            size_t len;
+        } p;                         // 堆上、arena中或输入缓冲区中的键，len中与ss最后1字节重合的部分是标记
+        char ss[2 * sizeof(size_t)]; // 不超过MEMBER_INLINE_KEY字节的键直接存放在这里，以'\0'结尾，最后1字节是标记
+    } k; // 标记只供内部使用，例如键是否直接引用输入缓冲区
     value v;
 };
 
@@ -61,19 +93,281 @@ enum {
     PARSE_MISS_COMMA_OR_SQUARE_BRACKET,
     PARSE_MISS_KEY,
     PARSE_MISS_COLON,
-    PARSE_MISS_COMMA_OR_CURLY_BRACKET
+    PARSE_MISS_COMMA_OR_CURLY_BRACKET,
+    PARSE_CANCELED,  // SAX回调要求中止解析
+    PARSE_TOO_DEEP,  // array/object的嵌套层数超过了max_depth
+    PARSE_FILE_ERROR // 无法打开或读取文件
+};
+
+// 内存池：bump allocator，先使用调用者提供的缓冲区，不够时再从堆上申请新块，最后由arena_release一次性释放
+struct arena {
+    char* buf;           // 当前正在分配的块
+    size_t size, used;   // 当前块的大小和已使用的大小
+    arena_block* blocks; // 从堆上申请的块组成的链表
+    char* head;          // 调用者提供的初始缓冲区
+    size_t head_size;
+};
+
+// 初始化arena，buf/size为调用者提供的初始缓冲区，可以为nullptr/0
+void arena_init(arena* a, void* buf, size_t size);
+// 从arena中分配size字节，按8字节对齐
+void* arena_alloc(arena* a, size_t size);
+// 一次性释放arena申请的所有内存，arena可以继续使用
+void arena_release(arena* a);
+
+// 键的驻留表：内容相同的键只保存一份不可修改的副本，供多个文档共享，可以同时被多个线程使用
+// 使用其中的键的文档必须在key_table_free之前释放；成员只供内部使用
+struct key_table {
+    void* impl; // 开放寻址的哈希表和新增键时使用的互斥锁，已有的键不加锁查找
+};
+
+void key_table_init(key_table* t);
+// 释放驻留的所有键
+void key_table_free(key_table* t);
+// 返回与[key, key + klen)内容相同的驻留副本，以'\0'结尾，在key_table_free之前一直有效
+// 同一张表中内容相同的键总是返回同一个指针，查找时传入它可以省去逐字节比较
+const char* key_table_intern(key_table* t, const char* key, size_t klen);
+size_t key_table_size(key_table* t);
+
+// 可以在多次parse/stringify之间复用的临时内存：保留堆栈以及它增长到的大小，稳定状态下不再为堆栈分配内存
+// 同一时间只能被一个调用使用
+struct scratch {
+    char* stack;  // 解析时的堆栈，生成时的输出缓冲区
+    size_t size;
+    char* frames; // 生成时遍历嵌套的array/object用的堆栈
+    size_t frames_size;
+    size_t retain; // 上面两块内存各自最多保留的大小
+};
+
+const size_t SCRATCH_RETAIN_UNLIMITED = (size_t)-1;
+
+// 初始化scratch，retain为调用结束后最多保留的内存大小
+void scratch_init(scratch* s, size_t retain);
+// 立即把保留的内存收缩到retain以内
+void scratch_trim(scratch* s, size_t retain);
+// 释放scratch保留的所有内存，之后可以继续使用
+void scratch_free(scratch* s);
+
+// parse_options::flags的取值
+enum {
+    PARSE_FLAG_DEFAULT = 0,
+    // 不含转义的字符串和键不再拷贝，直接以(指针, 长度)的形式引用输入缓冲区，只有含转义的字符串才会另外分配内存
+    // 此时输入缓冲区由调用者管理，必须比解析结果活得更久，并且这些字符串不以'\0'结尾，需配合长度使用
+    PARSE_FLAG_STRING_VIEW = 1 << 0,
+    // 宽的array/object不再把所有元素/成员先压入堆栈、结束时再整体拷贝一次：
+    // 达到PARSE_IN_PLACE_THRESHOLD个后移入按倍数增长的最终内存块，之后的元素/成员直接写入其中
+    // 结束时块收缩到恰好的大小，结果与默认方式相同；设置了pool时不起作用，arena中的内存无法增长
+    PARSE_FLAG_IN_PLACE = 1 << 1,
+};
+
+// 解析选项，使用前需调用parse_options_init初始化
+struct parse_options {
+    // 非空时，解析结果的节点、键和字符串全部从pool中分配
+    // 这样得到的树是只读的：tiny_free只需O(1)，内存由arena_release统一释放，需要修改时先copy到堆上
+    arena* pool;
+    unsigned int flags; // PARSE_FLAG_*的组合
+    // array/object的最大嵌套层数，超过时返回PARSE_TOO_DEEP；解析不使用递归，这个限制只用于约束恶意输入占用的内存
+    size_t max_depth;
+    // 非空时解析使用其中的堆栈，调用结束后交还，超过work->retain的部分被释放
+    scratch* work;
+    // 非空时长度超过MEMBER_INLINE_KEY的键从这里驻留，不再为每个成员复制一份；更短的键本来就存放在成员内
+    key_table* keys;
 };
 
-inline void tiny_init(value* v) { v->tiny_type = TINYNULL; }
+inline void parse_options_init(parse_options* opt) {
+    opt->pool = nullptr;
+    opt->flags = PARSE_FLAG_DEFAULT;
+    opt->max_depth = PARSE_MAX_DEPTH;
+    opt->work = nullptr;
+    opt->keys = nullptr;
+}
+
+inline void tiny_init(value* v) {
+    v->tiny_type = TINYNULL;
+    v->tiny_flags = 0;
+}
 
 void copy(value* dst, const value* src); // 深度拷贝函数
 void move(value* dst, value* src);       // 移动函数
 void swap(value* lhs, value* rhs);       // 交换值函数
 
-// JSON解析函数
+// JSON解析函数，json需以'\0'结尾
 int parse(value* v, const char* json);
+// JSON解析函数，只解析[json, json + len)范围内的字节，不要求以'\0'结尾，可直接解析大缓冲区中的一段
+int parse(value* v, const char* json, size_t len);
+// 带选项的JSON解析函数，opt为nullptr时与上面的函数相同
+int parse(value* v, const char* json, size_t len, const parse_options* opt);
+// SAX接口：按文档顺序把解析结果以事件的形式交给回调函数，不构建DOM，每个节点不需要分配内存
+// 回调可以为nullptr，表示忽略对应的事件；回调返回0表示继续解析，返回非0则中止解析，sax_parse返回PARSE_CANCELED
+// string/key收到的字符串只在回调期间有效，并且不以'\0'结尾；end_array/end_object的count为元素/成员个数
+struct sax_handler {
+    int (*null_value)(void* user);
+    int (*boolean)(void* user, int b);
+    int (*number)(void* user, double n);
+    int (*string)(void* user, const char* s, size_t len);
+    int (*key)(void* user, const char* k, size_t len);
+    int (*start_array)(void* user);
+    int (*end_array)(void* user, size_t count);
+    int (*start_object)(void* user);
+    int (*end_object)(void* user, size_t count);
+};
+
+inline void sax_handler_init(sax_handler* h) {
+    h->null_value = nullptr;
+    h->boolean = nullptr;
+    h->number = nullptr;
+    h->string = nullptr;
+    h->key = nullptr;
+    h->start_array = nullptr;
+    h->end_array = nullptr;
+    h->start_object = nullptr;
+    h->end_object = nullptr;
+}
+
+// SAX解析函数，只解析[json, json + len)范围内的字节，user原样传给每个回调
+// 语法错误的返回值与parse相同，出错之前已经产生的事件不会撤销
+int sax_parse(const char* json, size_t len, const sax_handler* h, void* user);
+// 带选项的SAX解析函数，只使用opt中的max_depth
+int sax_parse(const char* json, size_t len, const sax_handler* h, void* user, const parse_options* opt);
+
+// 增量解析器：输入可以分成任意多块依次交给push_parser_feed，解析状态在两次调用之间保存，
+// 只有跨越块边界的那一个token（字符串、数字或字面量）需要缓存，其余字节在feed返回后即可丢弃
+// array/object的最大嵌套层数为PARSE_MAX_DEPTH
+// 成员只供内部使用，不要直接访问
+struct push_parser {
+    const sax_handler* h;
+    void* user;
+    int state, status;    // 当前的语法状态；出错或中止后status保存错误码，之后的调用都直接返回它
+    unsigned int lex;     // 正在读取的token的词法状态
+    char* buf;            // 跨越块边界的不完整token
+    size_t len, cap;
+    size_t* levels; // 尚未结束的array/object，每层记录类型和已解析的元素个数
+    size_t depth, levels_cap;
+    char* stack; // 解析含转义的字符串时使用的堆栈
+    size_t stack_size;
+    value* root;    // 以下用于直接构建DOM
+    value** open;   // 尚未结束的array/object节点
+    value* pending; // object中已读到键、等待值的成员
+};
+
+// 初始化增量解析器，解析结果以SAX事件的形式交给h
+void push_parser_init(push_parser* p, const sax_handler* h, void* user);
+// 初始化增量解析器，解析结果构建为DOM存入v，与parse得到的树相同（容量可能大于元素个数），出错时v为TINYNULL
+void push_parser_init(push_parser* p, value* v);
+// 输入下一块数据，返回PARSE_OK表示目前为止没有错误，否则返回与parse相同的错误码
+int push_parser_feed(push_parser* p, const char* chunk, size_t len);
+// 输入结束，返回整个文档的解析结果
+int push_parser_finish(push_parser* p);
+// 根值是否已经完整读入；根值为数字时要等到后面出现其他字符或调用push_parser_finish才能确定
+int push_parser_complete(const push_parser* p);
+// 释放解析器的内部缓冲区，不影响已经构建好的DOM，解析器可以重新init后继续使用
+void push_parser_free(push_parser* p);
+
+// NDJSON（JSON Lines）每批交给一个工作线程的字节数，批在这个位置之后的第一个换行处结束
+const size_t NDJSON_BATCH_SIZE = 256 * 1024;
+
+// NDJSON的回调：line为记录所在的行号（从0开始，空行也计数），status为这条记录的parse结果
+// 出错时v为TINYNULL；回调可以用move取走v，否则回调返回后v被释放
+// 返回0表示继续，返回非0则停止，parse_ndjson返回PARSE_CANCELED
+typedef int (*ndjson_callback)(void* user, size_t line, value* v, int status);
+
+// NDJSON解析选项，使用前需调用ndjson_options_init初始化
+struct ndjson_options {
+    unsigned int threads; // 工作线程数，0表示使用硬件线程数，1表示不创建线程、直接在调用线程上解析
+    int ordered;          // 非0时按行号顺序交付；为0时哪一批先解析完就先交付哪一批，批内仍按行号顺序
+    size_t batch_size;    // 见NDJSON_BATCH_SIZE
+    // 每条记录的解析选项，可以为nullptr；其中的keys可以被所有线程共享，work被忽略（每个线程使用自己的scratch）
+    // 不支持pool，arena不能被多个线程同时使用
+    const parse_options* parse;
+};
+
+inline void ndjson_options_init(ndjson_options* opt) {
+    opt->threads = 0;
+    opt->ordered = 1;
+    opt->batch_size = NDJSON_BATCH_SIZE;
+    opt->parse = nullptr;
+}
+
+// 并行解析[json, json + len)中以'\n'分隔的JSON记录：输入按记录边界分批，由工作线程解析，
+// 回调总是在调用parse_ndjson的线程上依次执行，不需要加锁；只含空白的行被跳过
+// 每条记录的错误只通过回调报告，不影响其他记录；同时在途的批数有上限，内存占用与输入大小无关
+// opt为nullptr时使用默认选项，返回PARSE_OK或PARSE_CANCELED
+int parse_ndjson(const char* json, size_t len, ndjson_callback cb, void* user, const ndjson_options* opt);
+
+// 小于这个字节数的文档由parse_parallel直接顺序解析，并行的收益抵不上创建线程和建立索引的开销
+const size_t PARSE_PARALLEL_MIN_SIZE = 256 * 1024;
+
+// 多线程解析单个大文档：先向量化地扫描一遍，建立根array/object中元素/成员边界的结构索引，
+// 再按索引把它们分给threads个线程（0表示使用硬件线程数）同时解析，直接写入同一棵树
+// 结果和返回值与parse(v, json, len, opt)完全相同；根不是array/object、文档太小、出错或设置了pool时改为顺序解析
+int parse_parallel(value* v, const char* json, size_t len, unsigned int threads, const parse_options* opt);
+
+// 只读映射到内存中的文件，内容不以'\0'结尾；无法映射的文件（例如管道）改为读入堆上的缓冲区
+struct mapped_file {
+    const char* data;
+    size_t size;
+    int mapped; // 非0时data来自mmap，否则来自malloc
+};
+
+// 映射path指向的文件，并提示内核将按顺序读取，成功返回PARSE_OK，否则返回PARSE_FILE_ERROR
+int map_file(mapped_file* f, const char* path);
+// 解除映射，引用其内容的字符串随之失效
+void unmap_file(mapped_file* f);
+// 直接从映射的内存中解析文件，不需要先读入缓冲区，解析结束后解除映射
+// 此时解析结果不能引用文件的内容，opt中的PARSE_FLAG_STRING_VIEW被忽略
+int parse_file(value* v, const char* path);
+int parse_file(value* v, const char* path, const parse_options* opt);
+// 解析后把映射保留在f中，PARSE_FLAG_STRING_VIEW时字符串直接引用文件的内容，v释放之后再调用unmap_file
+// 返回PARSE_FILE_ERROR时f不需要unmap_file
+int parse_file(value* v, const char* path, const parse_options* opt, mapped_file* f);
+
+// 流式生成的返回值
+enum {
+    STRINGIFY_OK = 0,
+    STRINGIFY_SINK_ERROR, // sink返回了非0
+};
+
+// 流式生成的输出回调：写出[data, data + len)，成功返回0，失败返回非0
+typedef int (*stringify_sink)(void* user, const char* data, size_t len);
+
+// 生成选项，使用前需调用stringify_options_init初始化
+struct stringify_options {
+    unsigned int indent; // 每层缩进的字符数，为0时紧凑输出：不换行，':'之后也没有空格
+    char indent_char;    // 缩进使用的字符，' '或'\t'
+    const char* newline; // 换行符，例如"\n"或"\r\n"
+    int sort_keys;       // 非0时object的成员按键的字节序输出，键相同的成员保持原来的顺序；紧凑输出时同样有效
+};
+
+inline void stringify_options_init(stringify_options* opt) {
+    opt->indent = 0;
+    opt->indent_char = ' ';
+    opt->newline = "\n";
+    opt->sort_keys = 0;
+}
+
 // JSON字符串生成函数
 char* stringify(const value* v, size_t* len);
+// 带选项的生成函数，例如缩进输出，只遍历一次；opt为nullptr时与上面的函数相同
+char* stringify_format(const value* v, size_t* len, const stringify_options* opt);
+// 使用scratch的生成函数，结果直接存放在s的缓冲区中，以'\0'结尾，在下一次使用s之前有效，不需要调用者free
+// 由于结果需要保持有效，超过s->retain的内存在下一次调用开始时才被释放
+const char* stringify(const value* v, size_t* len, scratch* s);
+// 流式生成函数：输出先写入调用者提供的缓冲区buf，写满时交给sink并重复使用buf，内存占用与文档大小无关
+// size不能小于STRINGIFY_MIN_BUFFER_SIZE，sink失败后不再调用sink，返回STRINGIFY_SINK_ERROR
+int stringify(const value* v, char* buf, size_t size, stringify_sink sink, void* user);
+// 带选项的流式生成函数，opt为nullptr时与上面的函数相同
+int stringify_format(const value* v, char* buf, size_t size, stringify_sink sink, void* user,
+                     const stringify_options* opt);
+// 流式生成到文件，使用栈上STRINGIFY_BUFFER_SIZE大小的缓冲区
+int stringify_file(const value* v, FILE* fp);
+// 流式生成到文件描述符，例如socket
+int stringify_fd(const value* v, int fd);
+// stringify输出的精确字节数，不含结尾的'\0'；可以对任意子树调用，子树不变时结果可以由调用者缓存，
+// 父节点的大小等于各子树大小之和加上括号、逗号以及object的键和冒号
+size_t stringify_size(const value* v);
+// 生成到调用者预先分配好的buf中，不检查边界也不重新分配内存，cap必须不小于stringify_size(v)
+// 返回写入的字节数，即stringify_size(v)，不在结尾添加'\0'
+size_t stringify_into(const value* v, char* buf, size_t cap);
 
 // 访问结果的相关函数
 // 获取类型
@@ -84,7 +378,7 @@ void set_number(value* v, double n);
 // 访问布尔属性
 int get_boolean(const value* v);
 void set_boolean(value* v, int b);
-// 访问字符串属性
+// 访问字符串属性，以PARSE_FLAG_STRING_VIEW解析得到的字符串不保证以'\0'结尾
 const char* get_string(const value* v);
 size_t get_string_len(const value* v);
 // 动态分配内存并将字符串存入到value中
@@ -133,9 +427,11 @@ void object_shrink(value* v);
 void object_clear(value* v);
 // 修改/新增object中的value，返回新增键值对的指针
 value* set_object_value(value* v, char* key, size_t klen);
+// 同上，新增的键从keys中驻留
+value* set_object_value(value* v, const char* key, size_t klen, key_table* keys);
 // remove函数，删除object中的value
 void remove_object_value(value* v, size_t index);
-// 查找key对应的index，线性查找
+// 查找key对应的index，小object线性查找，大object使用哈希索引
 size_t find_object_index(const value* v, const char* key, size_t klen);
 // 辅助函数，查找对应的value
 value* find_object_value(value* v, const char* key, size_t klen);
@@ -147,6 +443,145 @@ inline void set_null(value* v) { tiny_free(v); }
 // 比较函数，比较两个value是否相等
 int is_equal(const value* lhs, const value* rhs);
 
+// 紧凑的只读DOM：每个节点16字节，是value的一半，object的每个成员32字节
+// 数字直接存放double，null/true/false只占标记；不超过CVALUE_INLINE_STRING字节的字符串和键直接存放在节点内
+// 较长的字符串以及array/object指向堆上恰好大小的块，长度/元素个数存放在块头
+// 成员只供内部使用，通过下面重载的访问函数读取；需要修改时改用value
+struct cvalue {
+    alignas(8) unsigned char b[16]; // 前8字节为数值或指针，短字符串占用前15字节，最后1字节为类型和短字符串长度
+};
+
+const size_t CVALUE_INLINE_STRING = 14;
+
+inline void tiny_init(cvalue* v) { *v = cvalue(); }
+void tiny_free(cvalue* v);
+
+// 解析为紧凑DOM，语法和错误码与parse相同，出错时v为TINYNULL；opt只使用其中的max_depth
+int parse(cvalue* v, const char* json, size_t len);
+int parse(cvalue* v, const char* json, size_t len, const parse_options* opt);
+// 把value转换为紧凑DOM
+void compact(cvalue* dst, const value* src);
+char* stringify(const cvalue* v, size_t* len);
+
+type get_type(const cvalue* v);
+double get_number(const cvalue* v);
+int get_boolean(const cvalue* v);
+// 字符串以'\0'结尾，短字符串指向节点本身，只在节点有效期间有效
+const char* get_string(const cvalue* v);
+size_t get_string_len(const cvalue* v);
+size_t get_array_size(const cvalue* v);
+const cvalue* get_array_element(const cvalue* v, size_t index);
+size_t get_object_size(const cvalue* v);
+const char* get_object_key(const cvalue* v, size_t index);
+size_t get_object_key_length(const cvalue* v, size_t index);
+const cvalue* get_object_value(const cvalue* v, size_t index);
+// 紧凑DOM没有哈希索引，线性查找
+size_t find_object_index(const cvalue* v, const char* key, size_t klen);
+const cvalue* find_object_value(const cvalue* v, const char* key, size_t klen);
+int is_equal(const cvalue* lhs, const cvalue* rhs);
+
+// JSON Pointer（RFC 6901）的返回值
+enum {
+    POINTER_OK = 0,
+    POINTER_INVALID,   // 非空的pointer不以'/'开头，或者'~'之后不是'0'/'1'
+    POINTER_NOT_FOUND, // 路径上的节点不存在、类型不对或者下标越界
+};
+
+// token不是合法的数组下标时的index，以及token为"-"（末尾元素之后）时的index，两者都不小于任何数组的大小
+const size_t POINTER_NO_INDEX = (size_t)-1;
+const size_t POINTER_END_INDEX = (size_t)-2;
+
+// 预先解析好的引用token：key是去掉转义之后的键，index是按数组下标解析的结果，hash供有哈希索引的object直接使用
+struct pointer_token {
+    const char* key;
+    size_t len;
+    size_t index;
+    size_t hash;
+};
+
+// 编译后的pointer，可以反复用于查找不同的文档而不需要重新切分和反转义
+struct pointer {
+    pointer_token* tokens; // tokens和反转义后的键在同一块内存中
+    size_t count;          // 为0时指向整个文档
+};
+
+// 编译[s, s + len)，成功返回POINTER_OK，之后需要调用pointer_free；失败返回POINTER_INVALID，p为空
+int pointer_compile(pointer* p, const char* s, size_t len);
+void pointer_free(pointer* p);
+
+// 查找p指向的节点，不存在时返回nullptr
+value* pointer_get(const value* v, const pointer* p);
+// 同上，临时编译s，适合只查找一次的路径
+value* pointer_get(const value* v, const char* s, size_t len);
+const cvalue* pointer_get(const cvalue* v, const pointer* p);
+
+// 以下函数要求p的父节点已经存在，不会自动创建中间的节点，失败时返回nullptr/POINTER_NOT_FOUND且不修改v
+// 修改/新增p指向的节点，与set_object_value相同，返回已有的节点或新增的TINYNULL节点；
+// 父节点是array时下标可以等于数组大小或者为"-"，此时在末尾新增元素；p为空时返回v本身
+value* pointer_set(value* v, const pointer* p);
+// 与pointer_set相同，只是父节点是array时在下标处插入新的元素，原来的元素依次后移（RFC 6902的add）
+value* pointer_insert(value* v, const pointer* p);
+// 删除p指向的节点，父节点是array时后面的元素依次前移；不能删除整个文档
+int pointer_remove(value* v, const pointer* p);
+
+// 惰性DOM：parse只校验语法并为每个值在结构索引中记录一项，不复制字符串，也不为array/object分配内存
+// 索引按文档顺序排列，array/object之后紧跟着它的元素/成员（键也占一项），跳过一个子树只需O(1)
+// find_object_value直接在索引上查找；第一次按下标访问某个array/object时才为它建立子节点表，
+// 含转义的字符串第一次访问时才反转义，不含转义的字符串直接引用输入，不保证以'\0'结尾
+// 输入在文档释放或重新解析之前必须保持有效；访问会修改文档，同一个文档不能在多个线程中同时访问
+struct lvalue {
+    // 索引中的一项，成员只供内部使用
+    union {
+        const char* s; // STRING：开始的双引号在输入中的位置
+        size_t skip;   // ARRAY/OBJECT：子树占的项数，下一个兄弟节点在skip项之后
+    } a;
+    union {
+        double n;                // NUMBER
+        size_t raw;              // 含转义的STRING：反转义之前在输入中的长度，包括两个双引号
+        char* copy;              // 含转义的STRING：反转义之后的副本
+        const lvalue** children; // ARRAY：元素表；OBJECT：键的表，值在键之后的一项
+    } b;
+    size_t len;         // STRING：反转义之后的长度；ARRAY/OBJECT：元素/成员个数
+    unsigned char type; // tinyjson::type
+    unsigned char flags;
+};
+
+struct lazy_doc {
+    lvalue* nodes; // nodes[0]是根，重新解析时复用
+    size_t size;
+    size_t capacity;
+};
+
+inline void tiny_init(lazy_doc* d) {
+    d->nodes = nullptr;
+    d->size = d->capacity = 0;
+}
+void tiny_free(lazy_doc* d);
+
+// 以惰性模式解析，语法和错误码与parse相同；之前从d得到的指针全部失效，出错时d为空
+// opt只使用其中的max_depth和work
+int parse(lazy_doc* d, const char* json, size_t len);
+int parse(lazy_doc* d, const char* json, size_t len, const parse_options* opt);
+// 根节点，d为空时返回nullptr
+inline const lvalue* lazy_root(const lazy_doc* d) { return d->size > 0 ? d->nodes : nullptr; }
+char* stringify(const lvalue* v, size_t* len);
+
+type get_type(const lvalue* v);
+double get_number(const lvalue* v);
+int get_boolean(const lvalue* v);
+const char* get_string(const lvalue* v);
+size_t get_string_len(const lvalue* v);
+size_t get_array_size(const lvalue* v);
+const lvalue* get_array_element(const lvalue* v, size_t index);
+size_t get_object_size(const lvalue* v);
+const char* get_object_key(const lvalue* v, size_t index);
+size_t get_object_key_length(const lvalue* v, size_t index);
+const lvalue* get_object_value(const lvalue* v, size_t index);
+// 在索引上依次比较键，不建立子节点表
+size_t find_object_index(const lvalue* v, const char* key, size_t klen);
+const lvalue* find_object_value(const lvalue* v, const char* key, size_t klen);
+const lvalue* pointer_get(const lvalue* v, const pointer* p);
+
 } // namespace tinyjson
 
 #endif
\ No newline at end of file